@@ -30,7 +30,6 @@
  * DEALINGS IN THE SOFTWARE.
  ******************************************************************************/
 
-#include <cassert>
 #include "draft.h"
 
 WALLAROO_REGISTER( Draft );
@@ -47,27 +46,26 @@ void Draft::Align()
     
     unsigned int currentX = 0;
 
-    for ( Collaborator< Shape, collection >::iterator i = shapes.begin(); i != shapes.end(); ++i )
+    // the shapes are owned by the catalog: we can use plain pointers
+    const Collaborator< Shape, collection >::RawPointersPtr view = shapes.Pointers();
+    const Collaborator< Shape, collection >::RawPointers& s = *view;
+    for ( std::size_t i = 0; i < s.size(); ++i )
     {
-        cxx0x::shared_ptr< Shape > s = i -> lock();
-        assert( s );
-        Box box = s -> BoundingBox();
+        Box box = s[ i ] -> BoundingBox();
 
-        s -> MoveX( currentX - box.x_min );
+        s[ i ] -> MoveX( currentX - box.x_min );
         currentX += ( box.Width() + spacing );
 
-        s -> MoveY( 1 - box.y_min );
+        s[ i ] -> MoveY( 1 - box.y_min );
     }
 }
 
 void Draft::Draw()
 {
-    for ( Collaborator< Shape, collection >::iterator i = shapes.begin(); i != shapes.end(); ++i )
-    {
-        cxx0x::shared_ptr< Shape > s = i -> lock();
-        assert( s );
-        s -> Draw( canvas );
-    }
+    const Collaborator< Shape, collection >::RawPointersPtr view = shapes.Pointers();
+    const Collaborator< Shape, collection >::RawPointers& s = *view;
+    for ( std::size_t i = 0; i < s.size(); ++i )
+        s[ i ] -> Draw( canvas );
 
     canvas -> Show();
 }
@@ -37,7 +37,15 @@
 #include "wallaroo/catalog.h"
 #include "wallaroo/jsonconfiguration.h"
 #include "wallaroo/xmlconfiguration.h"
+#include "wallaroo/jsonstreamconfiguration.h"
+#include "wallaroo/xmlstreamconfiguration.h"
+#include "wallaroo/binaryconfiguration.h"
 #include "wallaroo/cxx0x.h"
+#include "wallaroo/parameters.h"
+#include <fstream>
+#include <iterator>
+#include <sstream>
+#include <cstdio>
 
 using namespace wallaroo;
 using namespace cxx0x;
@@ -131,6 +139,14 @@ namespace Foo
             }
             return sum;
         }
+        // the values of the parts in the container, as the digits of a number
+        int Digits() const
+        {
+            int digits = 0;
+            for ( Collaborator< I5, collection >::const_iterator i = container.begin(); i != container.end(); ++i )
+                digits = digits * 10 + i->lock()->F();
+            return digits;
+        }
     private:
         Collaborator< I5, collection > container;
         const std::string s;
@@ -163,6 +179,61 @@ private:
 WALLAROO_REGISTER( O5< double > )
 WALLAROO_REGISTER( O5< int > )
 
+// user defined types for constructor parameters
+
+struct Millis5
+{
+    long count;
+};
+
+static bool ParseMillis5( const std::string& v, Millis5& value )
+{
+    std::istringstream istream( v );
+    std::string unit;
+    return ( istream >> value.count >> unit ) && unit == "ms";
+}
+
+DEFINE_2PARAM_CLASS( S5, float, int )
+DEFINE_2PARAM_CLASS( T5, Millis5, float )
+DEFINE_2PARAM_CLASS( W5, cxx0x::int64_t, int )
+
+class U5 : public Part
+{
+public:
+    U5( const Millis5& _timeout ) : timeout( _timeout ) {}
+    const Millis5 timeout;
+};
+
+WALLAROO_REGISTER( U5, Millis5 )
+
+class Y5 : public Part
+{
+public:
+    Y5( const std::string& _text ) : text( _text ) {}
+    const std::string text;
+};
+
+WALLAROO_REGISTER( Y5, std::string )
+
+// counts its instances, to test the lazy creation
+class V5 : public Part
+{
+public:
+    V5() : next( "next", RegistrationToken() ) { ++instances; }
+    static int instances;
+    Collaborator< V5, wallaroo::optional > next;
+};
+
+int V5::instances = 0;
+
+WALLAROO_REGISTER( V5 )
+
+static V5* Next( const shared_ptr< V5 >& v )
+{
+    const shared_ptr< V5 > next = v -> next;
+    return next.get();
+}
+
 // tests
 
 BOOST_AUTO_TEST_SUITE( CfgFile )
@@ -252,4 +323,425 @@ BOOST_AUTO_TEST_CASE( XmlOk )
     TestContent( catalog );
 }
 
+BOOST_AUTO_TEST_CASE( XmlLazy )
+{
+    XmlConfiguration file( "test_xml.xml" );
+    BOOST_REQUIRE_NO_THROW( file.LoadPlugins() );
+    Catalog catalog;
+    BOOST_REQUIRE_NO_THROW( file.FillLazily( catalog ) );
+    TestContent( catalog );
+}
+
+BOOST_AUTO_TEST_CASE( LazyInstantiation )
+{
+    {
+        std::ofstream file( "test_lazy.xml" );
+        file << "<wallaroo><parts>"
+                "<part><name>v1</name><class>V5</class></part>"
+                "<part><name>v2</name><class>V5</class></part>"
+                "<part><name>v3</name><class>V5</class></part>"
+                "<part><name>v4</name><class>V5</class></part>"
+                "<part><name>v5</name><class>V5</class></part>"
+                "<part><name>bad</name><class>B5</class>"
+                "<parameter1><type>int</type><value>12x</value></parameter1></part>"
+                "</parts><wiring>"
+                "<wire><source>v1</source><dest>v2</dest><collaborator>next</collaborator></wire>"
+                "<wire><source>v2</source><dest>v3</dest><collaborator>next</collaborator></wire>"
+                "<wire><source>v3</source><dest>v1</dest><collaborator>next</collaborator></wire>"
+                "<wire><source>v5</source><dest>v4</dest><collaborator>next</collaborator></wire>"
+                "</wiring></wallaroo>";
+    }
+    Catalog catalog;
+    {
+        XmlConfiguration file( "test_lazy.xml" );
+        BOOST_REQUIRE_NO_THROW( file.FillLazily( catalog ) );
+    }
+    std::remove( "test_lazy.xml" );
+    BOOST_CHECK( V5::instances == 0 );
+
+    // the part is created with the parts reachable from it (the cycle included)
+    shared_ptr< V5 > v2 = catalog[ "v2" ];
+    BOOST_CHECK( V5::instances == 3 );
+    shared_ptr< V5 > v1 = catalog[ "v1" ];
+    BOOST_CHECK( V5::instances == 3 );
+    shared_ptr< V5 > v3 = catalog[ "v3" ];
+    BOOST_CHECK( V5::instances == 3 );
+    BOOST_CHECK( Next( v1 ) == v2.get() );
+    BOOST_CHECK( Next( v2 ) == v3.get() );
+    BOOST_CHECK( Next( v3 ) == v1.get() );
+    BOOST_CHECK( catalog.IsWiringOk() );
+
+    // wiring a part creates it
+    BOOST_CHECK_THROW( catalog.Declare( "v4", Catalog::Builder() ), DuplicatedElement );
+    BOOST_CHECK_THROW( catalog.Add( "v4", v1 ), DuplicatedElement );
+    BOOST_CHECK_NO_THROW( catalog.DeclareWiring( Symbol( "v1" ), Symbol( "next" ), Symbol( "v4" ) ) );
+    BOOST_CHECK( V5::instances == 4 );
+    shared_ptr< V5 > v4 = catalog[ "v4" ];
+    BOOST_CHECK( Next( v1 ) == v4.get() );
+
+    // the errors in the description are reported when the part is created
+    BOOST_CHECK_THROW( catalog[ "bad" ], WrongFile );
+    BOOST_CHECK_THROW( catalog[ "bad" ], WrongFile );
+
+    // the parts not created yet are discarded by Freeze
+    catalog.Freeze();
+    BOOST_CHECK_THROW( catalog[ "v5" ], ElementNotFound );
+    BOOST_CHECK( V5::instances == 4 );
+}
+
+static void WriteXml( const std::string& fileName, const std::string& parts )
+{
+    std::ofstream file( fileName.c_str() );
+    file << "<wallaroo><parts>" << parts << "</parts></wallaroo>";
+}
+
+BOOST_AUTO_TEST_CASE( UserParameterTypes )
+{
+    RegisterParameterType< float >( "float" );
+    RegisterParameterType< Millis5 >( "millis", &ParseMillis5 );
+    RegisterParameterTypes< Millis5, float >();
+    RegisterParameterType< cxx0x::int64_t >( "int64" ); // an alias of a built-in type on some platforms
+
+    WriteXml(
+        "test_parameters.xml",
+        "<part><name>p</name><class>S5</class>"
+        "<parameter1><type>float</type><value>2.5</value></parameter1>"
+        "<parameter2><type>int</type><value>7</value></parameter2></part>"
+        "<part><name>q</name><class>T5</class>"
+        "<parameter1><type>millis</type><value>250 ms</value></parameter1>"
+        "<parameter2><type>float</type><value>0.5</value></parameter2></part>"
+        "<part><name>r</name><class>U5</class>"
+        "<parameter1><type>millis</type><value>10 ms</value></parameter1></part>"
+        "<part><name>w</name><class>W5</class>"
+        "<parameter1><type>int64</type><value>-5000000000</value></parameter1>"
+        "<parameter2><type>int</type><value>3</value></parameter2></part>"
+    );
+
+    XmlConfiguration file( "test_parameters.xml" );
+    Catalog catalog;
+    BOOST_REQUIRE_NO_THROW( file.Fill( catalog ) );
+
+    shared_ptr< S5 > p = catalog[ "p" ];
+    BOOST_CHECK( p -> p1 == 2.5f );
+    BOOST_CHECK( p -> p2 == 7 );
+    shared_ptr< T5 > q = catalog[ "q" ];
+    BOOST_CHECK( q -> p1.count == 250 );
+    BOOST_CHECK( q -> p2 == 0.5f );
+    shared_ptr< U5 > r = catalog[ "r" ];
+    BOOST_CHECK( r -> timeout.count == 10 );
+    shared_ptr< W5 > w = catalog[ "w" ];
+    BOOST_CHECK( w -> p1 == -5000000000LL );
+    BOOST_CHECK( w -> p2 == 3 );
+
+    std::remove( "test_parameters.xml" );
+}
+
+BOOST_AUTO_TEST_CASE( WrongParameters )
+{
+    WriteXml(
+        "test_parameters.xml",
+        "<part><name>b</name><class>B5</class>"
+        "<parameter1><type>int</type><value>12x</value></parameter1></part>"
+    );
+    XmlConfiguration badValue( "test_parameters.xml" );
+    Catalog catalog1;
+    BOOST_CHECK_THROW( badValue.Fill( catalog1 ), WrongFile );
+
+    WriteXml(
+        "test_parameters.xml",
+        "<part><name>b</name><class>B5</class>"
+        "<parameter1><type>unknown type</type><value>12</value></parameter1></part>"
+    );
+    XmlConfiguration badType( "test_parameters.xml" );
+    Catalog catalog2;
+    BOOST_CHECK_THROW( badType.Fill( catalog2 ), WrongFile );
+
+    // the unknown types are rejected by every loader
+    XmlStreamConfiguration streamBadType( "test_parameters.xml" );
+    Catalog catalog3;
+    BOOST_CHECK_THROW( streamBadType.Fill( catalog3 ), WrongFile );
+    BOOST_REQUIRE_NO_THROW( BinaryConfiguration::CompileXml( "test_parameters.xml", "test_parameters.bin" ) );
+    BinaryConfiguration binaryBadType( "test_parameters.bin" );
+    Catalog catalog4;
+    BOOST_CHECK_THROW( binaryBadType.Fill( catalog4 ), WrongFile );
+    {
+        std::ofstream file( "test_parameters.json" );
+        file << "{ \"wallaroo\": { \"parts\": [ { \"name\": \"b\", \"class\": \"B5\","
+                "\"parameter1\": { \"type\": \"unknown type\", \"value\": 12 } } ] } }";
+    }
+    JsonConfiguration jsonBadType( "test_parameters.json" );
+    Catalog catalog5;
+    BOOST_CHECK_THROW( jsonBadType.Fill( catalog5 ), WrongFile );
+    JsonStreamConfiguration jsonStreamBadType( "test_parameters.json" );
+    Catalog catalog6;
+    BOOST_CHECK_THROW( jsonStreamBadType.Fill( catalog6 ), WrongFile );
+
+    std::remove( "test_parameters.xml" );
+    std::remove( "test_parameters.bin" );
+    std::remove( "test_parameters.json" );
+}
+
+BOOST_AUTO_TEST_CASE( StreamNotFound )
+{
+    BOOST_CHECK_THROW( JsonStreamConfiguration( "UnexistentFile.json" ), WrongFile );
+    BOOST_CHECK_THROW( XmlStreamConfiguration( "UnexistentFile.xml" ), WrongFile );
+}
+
+BOOST_AUTO_TEST_CASE( JsonStreamOk )
+{
+    JsonStreamConfiguration file( "test_json.json" );
+    BOOST_REQUIRE_NO_THROW( file.LoadPlugins() );
+    Catalog catalog;
+    BOOST_REQUIRE_NO_THROW( file.Fill( catalog ) );
+    TestContent( catalog );
+}
+
+BOOST_AUTO_TEST_CASE( XmlStreamOk )
+{
+    XmlStreamConfiguration file( "test_xml.xml" );
+    BOOST_REQUIRE_NO_THROW( file.LoadPlugins() );
+    Catalog catalog;
+    BOOST_REQUIRE_NO_THROW( file.Fill( catalog ) );
+    TestContent( catalog );
+}
+
+BOOST_AUTO_TEST_CASE( StreamWiringFirst )
+{
+    {
+        std::ofstream file( "test_stream.json" );
+        file << "{ \"wallaroo\": {"
+                "\"wiring\": [ { \"source\": \"c\", \"dest\": \"a\", \"collaborator\": \"x\" } ],"
+                "\"parts\": [ { \"name\": \"a\", \"class\": \"A5\" },"
+                "{ \"name\": \"c\", \"class\": \"C5\", \"parameter1\": { \"type\": \"unsigned int\", \"value\": 1 } } ]"
+                "} }";
+    }
+    JsonStreamConfiguration file( "test_stream.json" );
+    Catalog catalog;
+    BOOST_REQUIRE_NO_THROW( file.Fill( catalog ) );
+    BOOST_CHECK( catalog.IsWiringOk() );
+    shared_ptr< C5 > c = catalog[ "c" ];
+    BOOST_CHECK( c -> F() == 5 );
+    BOOST_CHECK( catalog.Contains( "a" ) );
+    BOOST_CHECK( ! catalog.Contains( "missing" ) );
+
+    std::remove( "test_stream.json" );
+}
+
+BOOST_AUTO_TEST_CASE( StreamCdata )
+{
+    {
+        std::ofstream file( "test_stream.xml" );
+        file << "<wallaroo><parts>"
+                "<part><name>a</name><class>Y5</class><parameter1><type>string</type>"
+                "<value><![CDATA[x]]]></value></parameter1></part>"
+                "<part><name>b</name><class>Y5</class><parameter1><type>string</type>"
+                "<value><![CDATA[]a]]b]]]]]></value></parameter1></part>"
+                "</parts></wallaroo>";
+    }
+    XmlStreamConfiguration xml( "test_stream.xml" );
+    Catalog catalog;
+    BOOST_REQUIRE_NO_THROW( xml.Fill( catalog ) );
+    shared_ptr< Y5 > a = catalog[ "a" ];
+    BOOST_CHECK( a -> text == "x]" );
+    shared_ptr< Y5 > b = catalog[ "b" ];
+    BOOST_CHECK( b -> text == "]a]]b]]]" );
+
+    // the same as the ptree based loader
+    XmlConfiguration tree( "test_stream.xml" );
+    Catalog catalog2;
+    BOOST_REQUIRE_NO_THROW( tree.Fill( catalog2 ) );
+    shared_ptr< Y5 > a2 = catalog2[ "a" ];
+    BOOST_CHECK( a2 -> text == "x]" );
+
+    std::remove( "test_stream.xml" );
+}
+
+BOOST_AUTO_TEST_CASE( StreamWiringOrder )
+{
+    // the wires are postponed until their parts are created, but the
+    // collections are filled in file order, like XmlConfiguration does
+    {
+        std::ofstream file( "test_stream.xml" );
+        file << "<wallaroo>"
+                "<wiring>"
+                "<wire><source>d</source><dest>b1</dest><collaborator>container</collaborator></wire>"
+                "<wire><source>d</source><dest>b2</dest><collaborator>container</collaborator></wire>"
+                "<wire><source>d</source><dest>b3</dest><collaborator>container</collaborator></wire>"
+                "</wiring>"
+                "<parts>"
+                "<part><name>b2</name><class>B5</class><parameter1><type>int</type><value>2</value></parameter1></part>"
+                "<part><name>b3</name><class>B5</class><parameter1><type>int</type><value>3</value></parameter1></part>"
+                "<part><name>d</name><class>Foo::D5</class>"
+                "<parameter1><type>string</type><value>s</value></parameter1>"
+                "<parameter2><type>int</type><value>0</value></parameter2></part>"
+                "<part><name>b1</name><class>B5</class><parameter1><type>int</type><value>1</value></parameter1></part>"
+                "</parts>"
+                "</wallaroo>";
+    }
+    Catalog stream;
+    BOOST_REQUIRE_NO_THROW( XmlStreamConfiguration( "test_stream.xml" ).Fill( stream ) );
+    Catalog tree;
+    BOOST_REQUIRE_NO_THROW( XmlConfiguration( "test_stream.xml" ).Fill( tree ) );
+    shared_ptr< Foo::D5 > d1 = stream[ "d" ];
+    shared_ptr< Foo::D5 > d2 = tree[ "d" ];
+    BOOST_CHECK_EQUAL( d1 -> Digits(), 123 );
+    BOOST_CHECK_EQUAL( d2 -> Digits(), 123 );
+
+    std::remove( "test_stream.xml" );
+}
+
+BOOST_AUTO_TEST_CASE( StreamWrongFile )
+{
+    {
+        std::ofstream file( "test_stream.xml" );
+        file << "<wallaroo><parts><part><name>a</name><class>A5</class></parts></wallaroo>";
+    }
+    XmlStreamConfiguration xml( "test_stream.xml" );
+    Catalog catalog1;
+    BOOST_CHECK_THROW( xml.Fill( catalog1 ), WrongFile );
+
+    {
+        std::ofstream file( "test_stream.json" );
+        file << "{ \"wallaroo\": { \"parts\": [ { \"class\": \"A5\" } ] } }";
+    }
+    JsonStreamConfiguration json( "test_stream.json" );
+    Catalog catalog2;
+    BOOST_CHECK_THROW( json.Fill( catalog2 ), WrongFile );
+
+    std::remove( "test_stream.xml" );
+    std::remove( "test_stream.json" );
+}
+
+static void TestShared( Catalog& catalog )
+{
+    BOOST_CHECK( catalog.IsShared( Symbol( "a" ) ) );
+    BOOST_CHECK( ! catalog.IsShared( Symbol( "b" ) ) );
+    BOOST_CHECK( ! catalog.IsShared( Symbol( "c" ) ) );
+}
+
+BOOST_AUTO_TEST_CASE( SharedParts )
+{
+    Catalog catalog1;
+    BOOST_REQUIRE_NO_THROW( JsonConfiguration( "test_shared.json" ).Fill( catalog1 ) );
+    TestShared( catalog1 );
+
+    Catalog catalog2;
+    BOOST_REQUIRE_NO_THROW( XmlConfiguration( "test_shared.xml" ).Fill( catalog2 ) );
+    TestShared( catalog2 );
+
+    Catalog catalog3;
+    BOOST_REQUIRE_NO_THROW( XmlConfiguration( "test_shared.xml" ).FillLazily( catalog3 ) );
+    TestShared( catalog3 );
+
+    Catalog catalog4;
+    BOOST_REQUIRE_NO_THROW( JsonStreamConfiguration( "test_shared.json" ).Fill( catalog4 ) );
+    TestShared( catalog4 );
+
+    Catalog catalog5;
+    BOOST_REQUIRE_NO_THROW( XmlStreamConfiguration( "test_shared.xml" ).Fill( catalog5 ) );
+    TestShared( catalog5 );
+
+    BOOST_REQUIRE_NO_THROW( BinaryConfiguration::CompileXml( "test_shared.xml", "test_shared.bin" ) );
+    Catalog catalog6;
+    BOOST_REQUIRE_NO_THROW( BinaryConfiguration( "test_shared.bin" ).Fill( catalog6 ) );
+    TestShared( catalog6 );
+    std::remove( "test_shared.bin" );
+}
+
+BOOST_AUTO_TEST_CASE( BinaryNotFound )
+{
+    BOOST_CHECK_THROW( BinaryConfiguration( "UnexistentFile.bin" ), WrongFile );
+    BOOST_CHECK_THROW( BinaryConfiguration::CompileXml( "UnexistentFile.xml", "test_xml.bin" ), WrongFile );
+}
+
+BOOST_AUTO_TEST_CASE( BinaryOk )
+{
+    BOOST_REQUIRE_NO_THROW( BinaryConfiguration::CompileXml( "test_xml.xml", "test_xml.bin" ) );
+    BOOST_REQUIRE_NO_THROW( BinaryConfiguration::CompileJson( "test_json.json", "test_json.bin" ) );
+
+    BinaryConfiguration xml( "test_xml.bin" );
+    BOOST_REQUIRE_NO_THROW( xml.LoadPlugins() );
+    Catalog catalog1;
+    BOOST_REQUIRE_NO_THROW( xml.Fill( catalog1 ) );
+    TestContent( catalog1 );
+
+    BinaryConfiguration json( "test_json.bin" );
+    BOOST_REQUIRE_NO_THROW( json.LoadPlugins() );
+    Catalog catalog2;
+    BOOST_REQUIRE_NO_THROW( json.Fill( catalog2 ) );
+    TestContent( catalog2 );
+
+    std::remove( "test_xml.bin" );
+    std::remove( "test_json.bin" );
+}
+
+BOOST_AUTO_TEST_CASE( BinaryRejected )
+{
+    BOOST_REQUIRE_NO_THROW( BinaryConfiguration::CompileXml( "test_xml.xml", "test_xml.bin" ) );
+    std::string image;
+    {
+        std::ifstream in( "test_xml.bin", std::ios::binary );
+        image.assign( std::istreambuf_iterator< char >( in ), std::istreambuf_iterator< char >() );
+    }
+    BOOST_REQUIRE( image.size() > 100 );
+
+    // a corrupted payload is detected by the checksum
+    std::string corrupted( image );
+    corrupted[ image.size() - 5 ] ^= 0x20;
+    {
+        std::ofstream out( "test_xml.bin", std::ios::binary );
+        out << corrupted;
+    }
+    BOOST_CHECK_THROW( BinaryConfiguration( "test_xml.bin" ), WrongFile );
+
+    // an image of another version of the format
+    std::string stale( image );
+    stale[ 8 ] ^= 0x01;
+    {
+        std::ofstream out( "test_xml.bin", std::ios::binary );
+        out << stale;
+    }
+    BOOST_CHECK_THROW( BinaryConfiguration( "test_xml.bin" ), WrongFile );
+
+    // a truncated image
+    {
+        std::ofstream out( "test_xml.bin", std::ios::binary );
+        out << image.substr( 0, image.size() / 2 );
+    }
+    BOOST_CHECK_THROW( BinaryConfiguration( "test_xml.bin" ), WrongFile );
+
+    // not an image at all
+    BOOST_CHECK_THROW( BinaryConfiguration( "test_xml.xml" ), WrongFile );
+
+    std::remove( "test_xml.bin" );
+
+    // an image older than its source file
+    std::string source;
+    {
+        std::ifstream in( "test_xml.xml", std::ios::binary );
+        source.assign( std::istreambuf_iterator< char >( in ), std::istreambuf_iterator< char >() );
+        std::ofstream out( "test_stale.xml", std::ios::binary );
+        out << source;
+    }
+    BOOST_REQUIRE_NO_THROW( BinaryConfiguration::CompileXml( "test_stale.xml", "test_stale.bin" ) );
+    BOOST_CHECK_NO_THROW( BinaryConfiguration( "test_stale.bin" ).CheckSource() );
+    {
+        std::ofstream out( "test_stale.xml", std::ios::binary );
+        out << source << ' ';
+    }
+    // the source is checked only on demand
+    BOOST_CHECK_NO_THROW( BinaryConfiguration( "test_stale.bin" ) );
+    BOOST_CHECK_THROW( BinaryConfiguration( "test_stale.bin" ).CheckSource(), WrongFile );
+    {
+        std::ofstream out( "test_stale.xml", std::ios::binary );
+        source[ source.size() / 2 ] ^= 0x01; // same size, different content
+        out << source;
+    }
+    BOOST_CHECK_THROW( BinaryConfiguration( "test_stale.bin" ).CheckSource(), WrongFile );
+    // without the source file, the image is used as it is
+    std::remove( "test_stale.xml" );
+    BOOST_CHECK_NO_THROW( BinaryConfiguration( "test_stale.bin" ).CheckSource() );
+    std::remove( "test_stale.bin" );
+}
+
 BOOST_AUTO_TEST_SUITE_END()
\ No newline at end of file
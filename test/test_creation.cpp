@@ -32,6 +32,9 @@
 
 #include <boost/test/unit_test.hpp>
 
+#include <sstream>
+#include <vector>
+
 #include "wallaroo/registered.h"
 #include "wallaroo/catalog.h"
 
@@ -197,4 +200,158 @@ BOOST_AUTO_TEST_CASE( namespaceRegistration )
     BOOST_CHECK( e == e_bis );
 }
 
+BOOST_AUTO_TEST_CASE( symbols )
+{
+    const Symbol a( "a_sym" );
+    const Symbol b( std::string( "b_sym" ) );
+    BOOST_CHECK( a == Symbol( "a_sym" ) );
+    BOOST_CHECK( a != b );
+    BOOST_CHECK( a.Name() == "a_sym" );
+    BOOST_CHECK( Symbol().Name().empty() );
+
+    Symbol found;
+    BOOST_CHECK( Symbol::Find( "b_sym", found ) );
+    BOOST_CHECK( found == b );
+    BOOST_CHECK( ! Symbol::Find( "never_interned_before", found ) );
+
+    Catalog catalog;
+    BOOST_REQUIRE_NO_THROW( catalog.Create( a, Symbol( "A1" ) ) );
+    BOOST_REQUIRE_NO_THROW( catalog.Create( b, Symbol( "B1" ), 10, std::string( "hello" ) ) );
+    BOOST_CHECK_THROW( catalog.Create( a, Symbol( "A1" ) ), DuplicatedElement );
+    BOOST_CHECK_THROW( catalog.Create( Symbol( "c_sym" ), Symbol( "Unknown" ) ), ElementNotFound );
+
+    // symbols and strings refer to the same elements
+    shared_ptr< A1 > a1 = catalog[ a ];
+    shared_ptr< A1 > a2 = catalog[ "a_sym" ];
+    BOOST_CHECK( a1 == a2 );
+    shared_ptr< B1 > b1 = catalog[ b ];
+    BOOST_CHECK( b1 -> GetX() == 10 );
+    BOOST_CHECK_THROW( catalog[ Symbol( "c_sym" ) ], ElementNotFound );
+}
+
+// adds the parts "concurrent0", "concurrent1", ... to a catalog
+struct ConcurrentWriter
+{
+    ConcurrentWriter( Catalog& c, atomic< int >& a, int t ) : catalog( c ), added( a ), total( t ) {}
+    void operator()()
+    {
+        for ( int i = 0; i < total; ++i )
+        {
+            catalog.Create( ConcurrentName( i ), "A1" );
+            added.store( i + 1 );
+        }
+    }
+    static std::string ConcurrentName( int i )
+    {
+        std::ostringstream name;
+        name << "concurrent" << i;
+        return name.str();
+    }
+    Catalog& catalog;
+    atomic< int >& added;
+    const int total;
+};
+
+// looks up the parts already added by ConcurrentWriter
+struct ConcurrentReader
+{
+    ConcurrentReader( const Catalog& c, const atomic< int >& a, atomic< int >& e, int t ) :
+        catalog( c ), added( a ), errors( e ), total( t ) {}
+    void operator()()
+    {
+        for ( int n = 0; added.load() < total; ++n )
+        {
+            const int available = added.load();
+            if ( available == 0 ) continue;
+            try
+            {
+                shared_ptr< A1 > a = catalog[ ConcurrentWriter::ConcurrentName( n % available ) ];
+                if ( ! a ) ++errors;
+            }
+            catch ( ... )
+            {
+                ++errors;
+            }
+        }
+    }
+    const Catalog& catalog;
+    const atomic< int >& added;
+    atomic< int >& errors;
+    const int total;
+};
+
+BOOST_AUTO_TEST_CASE( concurrentLookups )
+{
+    const int total = 2000;
+    Catalog catalog;
+    atomic< int > added( 0 );
+    atomic< int > errors( 0 );
+    thread r1( ConcurrentReader( catalog, added, errors, total ) );
+    thread r2( ConcurrentReader( catalog, added, errors, total ) );
+    thread r3( ConcurrentReader( catalog, added, errors, total ) );
+    thread w( ConcurrentWriter( catalog, added, total ) );
+    w.join();
+    r1.join();
+    r2.join();
+    r3.join();
+    BOOST_CHECK( errors.load() == 0 );
+    for ( int i = 0; i < total; ++i )
+    {
+        shared_ptr< A1 > a = catalog[ ConcurrentWriter::ConcurrentName( i ) ];
+        BOOST_CHECK( a );
+    }
+    BOOST_CHECK_THROW( catalog.Create( ConcurrentWriter::ConcurrentName( 0 ), "A1" ), DuplicatedElement );
+}
+
+BOOST_AUTO_TEST_CASE( frozenCatalog )
+{
+    Catalog catalog;
+    const int total = 500;
+    for ( int i = 0; i < total; ++i )
+        catalog.Create( ConcurrentWriter::ConcurrentName( i ), "A1" );
+    std::vector< shared_ptr< A1 > > before;
+    for ( int i = 0; i < total; ++i )
+        before.push_back( catalog[ ConcurrentWriter::ConcurrentName( i ) ] );
+
+    BOOST_CHECK( ! catalog.IsFrozen() );
+    catalog.Freeze();
+    BOOST_CHECK( catalog.IsFrozen() );
+    BOOST_CHECK_NO_THROW( catalog.Freeze() );
+
+    // the lookups give the same parts
+    for ( int i = 0; i < total; ++i )
+    {
+        shared_ptr< A1 > a = catalog[ ConcurrentWriter::ConcurrentName( i ) ];
+        BOOST_CHECK( a == before[ i ] );
+    }
+    BOOST_CHECK_THROW( catalog[ "a_sym" ], ElementNotFound );
+    BOOST_CHECK_THROW( catalog[ "never_added_to_the_catalog" ], ElementNotFound );
+    BOOST_CHECK_THROW( catalog.Create( "after_freeze", "A1" ), FrozenCatalog );
+    BOOST_CHECK_THROW( catalog[ "after_freeze" ], ElementNotFound );
+
+    Catalog empty;
+    empty.Freeze();
+    BOOST_CHECK_THROW( empty[ "a_sym" ], ElementNotFound );
+}
+
+BOOST_AUTO_TEST_CASE( arenaAllocation )
+{
+    shared_ptr< B1 > survivor;
+    {
+        Catalog catalog;
+        catalog.Create( "b1", "B1", 3, std::string( "first" ) );
+        catalog.Create( "b2", "B1", 4, std::string( "second" ) );
+        shared_ptr< B1 > b1 = catalog[ "b1" ];
+        shared_ptr< B1 > b2 = catalog[ "b2" ];
+        // the parts are allocated sequentially in the same chunk
+        const char* p1 = reinterpret_cast< const char* >( b1.get() );
+        const char* p2 = reinterpret_cast< const char* >( b2.get() );
+        BOOST_CHECK( p2 > p1 );
+        BOOST_CHECK( p2 - p1 < 1024 );
+        survivor = b2;
+    }
+    // the arena is kept alive by the parts still referenced
+    BOOST_CHECK( survivor -> GetX() == 4 );
+}
+
 BOOST_AUTO_TEST_SUITE_END()
\ No newline at end of file
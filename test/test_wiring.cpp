@@ -34,11 +34,16 @@
 
 #include "wallaroo/registered.h"
 #include "wallaroo/catalog.h"
+#include "wallaroo/prototype.h"
+#include "wallaroo/replicas.h"
 #include "wallaroo/cxx0x.h"
 
 #include <deque>
 #include <vector>
 #include <list>
+#include <sstream>
+#include <stdexcept>
+#include <functional>
 
 using namespace wallaroo;
 using namespace cxx0x;
@@ -149,6 +154,166 @@ public:
 
 WALLAROO_REGISTER( F2 )
 
+class G2 : public C2
+{
+public:
+    G2() : y( "y", RegistrationToken() ) {}
+    virtual int F() { return C2::F() + y -> F(); }
+    virtual ~G2() {}
+private:
+    Collaborator< I2 > y;
+};
+
+WALLAROO_REGISTER( G2 )
+
+// class to test the rewiring
+class H2 : public Part
+{
+public:
+    H2() : x( "x", RegistrationToken() ), xs( "xs", RegistrationToken() ) {}
+    int F() { return x -> F(); }
+    int Sum() const
+    {
+        int sum = 0;
+        const Collection::LinksPtr links = xs.Snapshot();
+        for ( Collection::Links::const_iterator i = links -> begin(); i != links -> end(); ++i )
+            sum += i -> lock() -> F();
+        return sum;
+    }
+    typedef Collaborator< I2, collection > Collection;
+    Collaborator< I2 > x;
+    Collection xs;
+};
+
+WALLAROO_REGISTER( H2 )
+
+// calls the parts linked to H2 while they're rewired
+struct RewiringReader
+{
+    RewiringReader( H2& p, const atomic< bool >& d, atomic< int >& e ) : part( p ), done( d ), errors( e ) {}
+    void operator()()
+    {
+        while ( ! done.load() )
+        {
+            const int f = part.F();
+            if ( f != 5 && f != 10 ) ++errors;
+            if ( part.Sum() != 15 ) ++errors;
+        }
+    }
+    H2& part;
+    const atomic< bool >& done;
+    atomic< int >& errors;
+};
+
+// classes to test the parallel calls
+class K2 : public Part
+{
+public:
+    K2() : value( 0 ) {}
+    void Add( int x ) { value += x; }
+    void Scale( int x, int y ) { value = value * x + y; }
+    int Value() const { return value; }
+    void Check() const { if ( value < 0 ) throw std::runtime_error( "negative value" ); }
+    void AddTo( atomic< int >& total ) const { total += value; }
+    int value;
+};
+
+WALLAROO_REGISTER( K2 )
+
+class L2 : public Part
+{
+public:
+    L2() : ks( "ks", RegistrationToken() ) {}
+    Collaborator< K2, collection > ks;
+};
+
+WALLAROO_REGISTER( L2 )
+
+struct Doubler
+{
+    void operator()( K2* k ) const { k -> value *= 2; }
+};
+
+// classes to test the prototypes
+class N2 : public Part
+{
+public:
+    N2() : back( "back", RegistrationToken() ), level( "level", RegistrationToken() ) {}
+    Collaborator< Part, wallaroo::optional > back;
+    Attribute< int > level;
+};
+
+WALLAROO_REGISTER( N2 )
+
+class M2 : public Part
+{
+public:
+    M2( int _k ) :
+        k( _k ),
+        helper( "helper", RegistrationToken() ),
+        shared( "shared", RegistrationToken() ),
+        name( "name", RegistrationToken() )
+    {}
+    const int k;
+    Collaborator< N2 > helper;
+    Collaborator< I2 > shared;
+    Attribute< std::string > name;
+};
+
+WALLAROO_REGISTER( M2, int )
+
+// looks up a part in the replica of its thread
+struct ReplicaReader
+{
+    ReplicaReader( Replicas& r, shared_ptr< M2 >& p ) : replicas( r ), part( p ) {}
+    void operator()() { part = replicas[ "m" ]; }
+    Replicas& replicas;
+    shared_ptr< M2 >& part;
+};
+
+// a class to test the autowiring: it's assignable to its own collaborator
+class O2 : public I2
+{
+public:
+    O2() : inner( "inner", RegistrationToken() ) {}
+    virtual int F() { return inner -> F() + 1; }
+    Collaborator< I2 > inner;
+};
+
+WALLAROO_REGISTER( O2 )
+
+// classes to test the members that differ between the instances:
+// the name of the collaborator is chosen at runtime...
+class P2 : public Part
+{
+public:
+    P2( const std::string& name ) : x( name, RegistrationToken() ) {}
+    int F() { return x -> F(); }
+    Collaborator< I2 > x;
+};
+
+WALLAROO_REGISTER( P2, std::string )
+
+// ...or the collaborator and the attribute are allocated on the heap
+class Q2 : public Part
+{
+public:
+    Q2() :
+        x( new Collaborator< I2 >( "x", RegistrationToken() ) ),
+        k( new Attribute< int >( "k", RegistrationToken() ) )
+    {}
+    ~Q2()
+    {
+        delete k;
+        delete x;
+    }
+    int F() { return ( *x ) -> F() + *k; }
+    Collaborator< I2 >* x;
+    Attribute< int >* k;
+};
+
+WALLAROO_REGISTER( Q2 )
+
 // tests
 
 BOOST_AUTO_TEST_SUITE( Wiring )
@@ -394,4 +559,664 @@ BOOST_AUTO_TEST_CASE( checkCast )
     BOOST_REQUIRE_NO_THROW( static_cast< const shared_ptr< I2 > >( f2 -> collaborator ) );
 }
 
-BOOST_AUTO_TEST_SUITE_END()
\ No newline at end of file
+BOOST_AUTO_TEST_CASE( sealedCatalog )
+{
+    Catalog catalog;
+
+    BOOST_REQUIRE_NO_THROW( catalog.Create( "a", "A2" ) );
+    BOOST_REQUIRE_NO_THROW( catalog.Create( "b", "B2" ) );
+    BOOST_REQUIRE_NO_THROW( catalog.Create( "c1", "C2" ) );
+    BOOST_REQUIRE_NO_THROW( catalog.Create( "c2", "C2" ) );
+
+    wallaroo_within( catalog )
+    {
+        BOOST_REQUIRE_NO_THROW( use( "a" ).as( "x" ).of( "c1" ) );
+    }
+
+    BOOST_REQUIRE_NO_THROW( catalog.Seal() );
+
+    shared_ptr< C2 > c1 = catalog[ "c1" ];
+    BOOST_CHECK( c1 -> F() == 5 );
+
+    // c2 is not wired yet
+    shared_ptr< C2 > c2 = catalog[ "c2" ];
+    BOOST_CHECK_THROW( c2 -> F(), DeletedPartError );
+
+    // wiring after sealing
+    wallaroo_within( catalog )
+    {
+        BOOST_REQUIRE_NO_THROW( use( "b" ).as( "x" ).of( "c1" ) );
+        BOOST_REQUIRE_NO_THROW( use( "a" ).as( "x" ).of( "c2" ) );
+    }
+    BOOST_CHECK( c1 -> F() == 10 );
+    BOOST_CHECK( c2 -> F() == 5 );
+
+    // parts added after sealing
+    BOOST_REQUIRE_NO_THROW( catalog.Create( "c3", "C2" ) );
+    wallaroo_within( catalog )
+    {
+        BOOST_REQUIRE_NO_THROW( use( "b" ).as( "x" ).of( "c3" ) );
+    }
+    shared_ptr< C2 > c3 = catalog[ "c3" ];
+    BOOST_CHECK( c3 -> F() == 10 );
+}
+
+BOOST_AUTO_TEST_CASE( inheritedCollaborators )
+{
+    Catalog catalog;
+
+    BOOST_REQUIRE_NO_THROW( catalog.Create( "a", "A2" ) );
+    BOOST_REQUIRE_NO_THROW( catalog.Create( "b", "B2" ) );
+    BOOST_REQUIRE_NO_THROW( catalog.Create( "g1", "G2" ) );
+    BOOST_REQUIRE_NO_THROW( catalog.Create( "g2", "G2" ) );
+    BOOST_REQUIRE_NO_THROW( catalog.Create( "c", "C2" ) );
+
+    wallaroo_within( catalog )
+    {
+        BOOST_REQUIRE_NO_THROW( use( "a" ).as( "x" ).of( "g1" ) );
+        BOOST_REQUIRE_NO_THROW( use( "b" ).as( "y" ).of( "g1" ) );
+        BOOST_REQUIRE_NO_THROW( use( "b" ).as( "x" ).of( "g2" ) );
+        BOOST_REQUIRE_NO_THROW( use( "b" ).as( "y" ).of( "g2" ) );
+        BOOST_REQUIRE_NO_THROW( use( "a" ).as( "x" ).of( "c" ) );
+        // the base class does not have the collaborators of the derived class
+        BOOST_CHECK_THROW( use( "a" ).as( "y" ).of( "c" ), ElementNotFound );
+    }
+
+    shared_ptr< G2 > g1 = catalog[ "g1" ];
+    BOOST_CHECK( g1 -> F() == 15 );
+    shared_ptr< G2 > g2 = catalog[ "g2" ];
+    BOOST_CHECK( g2 -> F() == 20 );
+    shared_ptr< C2 > c = catalog[ "c" ];
+    BOOST_CHECK( c -> F() == 5 );
+
+    // a part does not store its own tables of collaborators and attributes
+#ifdef WALLAROO_INTRUSIVE_PARTS
+    // (the intrusive reference count and the arena shared_ptr are in the base class)
+    BOOST_CHECK( sizeof( Part ) <= 2 * sizeof( shared_ptr< Part > ) + 2 * sizeof( void* ) + sizeof( wallaroo::detail::RefCounted ) );
+#else
+    BOOST_CHECK( sizeof( Part ) <= 2 * sizeof( shared_ptr< Part > ) + 2 * sizeof( void* ) );
+#endif
+}
+
+BOOST_AUTO_TEST_CASE( rewiring )
+{
+    Catalog catalog;
+    BOOST_REQUIRE_NO_THROW( catalog.Create( "a", "A2" ) );
+    BOOST_REQUIRE_NO_THROW( catalog.Create( "b", "B2" ) );
+    BOOST_REQUIRE_NO_THROW( catalog.Create( "b2", "B2" ) );
+    BOOST_REQUIRE_NO_THROW( catalog.Create( "c", "C2" ) );
+    BOOST_REQUIRE_NO_THROW( catalog.Create( "h", "H2" ) );
+
+    shared_ptr< Part > a = catalog[ "a" ];
+    shared_ptr< Part > b = catalog[ "b" ];
+    shared_ptr< Part > b2 = catalog[ "b2" ];
+    shared_ptr< Part > c = catalog[ "c" ];
+    shared_ptr< H2 > h = catalog[ "h" ];
+
+    wallaroo_within( catalog )
+    {
+        BOOST_REQUIRE_NO_THROW( use( "a" ).as( "x" ).of( "h" ) );
+        BOOST_REQUIRE_NO_THROW( use( "a" ).as( "xs" ).of( "h" ) );
+        BOOST_REQUIRE_NO_THROW( use( "b" ).as( "xs" ).of( "h" ) );
+    }
+    BOOST_CHECK( h -> F() == 5 );
+    BOOST_CHECK( h -> Sum() == 15 );
+
+    // single collaborator
+    BOOST_CHECK( ! h -> Rewire( "x", b, b2 ) ); // b is not linked
+    BOOST_CHECK( h -> F() == 5 );
+    BOOST_CHECK( h -> Rewire( "x", a, b ) );
+    BOOST_CHECK( h -> F() == 10 );
+    BOOST_CHECK_THROW( h -> Rewire( "x", b, c ), WrongType );
+    BOOST_CHECK_THROW( h -> Rewire( "does_not_exist", b, a ), ElementNotFound );
+    BOOST_CHECK( ! h -> Unwire( "x", a ) );
+    BOOST_CHECK( h -> Unwire( "x", b ) );
+    BOOST_CHECK( ! h -> x );
+    BOOST_CHECK_THROW( h -> F(), DeletedPartError );
+    BOOST_CHECK( ! h -> MultiplicitiesOk() );
+    BOOST_REQUIRE_NO_THROW( h -> Wire( "x", a ) );
+    BOOST_CHECK( h -> F() == 5 );
+
+    // collection
+    BOOST_CHECK( h -> Rewire( "xs", a, b2 ) );
+    BOOST_CHECK( h -> Sum() == 20 );
+    BOOST_CHECK( h -> Unwire( "xs", b ) );
+    BOOST_CHECK( ! h -> Unwire( "xs", b ) );
+    BOOST_CHECK( h -> Sum() == 10 );
+    BOOST_CHECK( h -> xs.size() == 1 );
+    BOOST_CHECK( h -> Rewire( "xs", b2, a ) );
+    BOOST_REQUIRE_NO_THROW( h -> Wire( "xs", b ) );
+    BOOST_CHECK( h -> Sum() == 15 );
+
+    // rewiring while other threads use the collaborators, before and after sealing
+    for ( int sealed = 0; sealed < 2; ++sealed )
+    {
+        if ( sealed ) catalog.Seal();
+        atomic< bool > done( false );
+        atomic< int > errors( 0 );
+        thread r1( RewiringReader( *h, done, errors ) );
+        thread r2( RewiringReader( *h, done, errors ) );
+        bool rewired = true;
+        for ( int i = 0; i < 500; ++i )
+        {
+            rewired = h -> Rewire( "x", a, b ) && rewired;
+            rewired = h -> Rewire( "xs", b, b2 ) && rewired;
+            rewired = h -> Rewire( "x", b, a ) && rewired;
+            rewired = h -> Rewire( "xs", b2, b ) && rewired;
+        }
+        done.store( true );
+        r1.join();
+        r2.join();
+        BOOST_CHECK( rewired );
+        BOOST_CHECK( errors.load() == 0 );
+    }
+    BOOST_CHECK( h -> F() == 5 );
+    BOOST_CHECK( h -> Sum() == 15 );
+}
+
+BOOST_AUTO_TEST_CASE( collectionViews )
+{
+    Catalog catalog;
+    BOOST_REQUIRE_NO_THROW( catalog.Create( "a", "A2" ) );
+    BOOST_REQUIRE_NO_THROW( catalog.Create( "b", "B2" ) );
+    BOOST_REQUIRE_NO_THROW( catalog.Create( "h", "H2" ) );
+    shared_ptr< H2 > h = catalog[ "h" ];
+
+    BOOST_CHECK( h -> xs.Pointers() -> empty() );
+    wallaroo_within( catalog )
+    {
+        BOOST_REQUIRE_NO_THROW( use( "a" ).as( "xs" ).of( "h" ) );
+        BOOST_REQUIRE_NO_THROW( use( "b" ).as( "xs" ).of( "h" ) );
+    }
+    BOOST_REQUIRE_NO_THROW( catalog.Seal() );
+
+    // the views are built once, and rebuilt only when the collection changes
+    H2::Collection::RawPointersPtr pointers = h -> xs.Pointers();
+    BOOST_REQUIRE( pointers -> size() == 2 );
+    BOOST_CHECK( ( *pointers )[ 0 ] -> F() + ( *pointers )[ 1 ] -> F() == 15 );
+    BOOST_CHECK( h -> xs.Pointers() == pointers );
+    BOOST_CHECK( h -> xs.Snapshot() == h -> xs.Snapshot() );
+
+    H2::Collection::SharedPointers parts = h -> xs.Lock();
+    BOOST_REQUIRE( parts.size() == 2 );
+    BOOST_CHECK( parts[ 0 ].get() == ( *pointers )[ 0 ] );
+    BOOST_CHECK( parts[ 1 ].get() == ( *pointers )[ 1 ] );
+
+    BOOST_CHECK( h -> Unwire( "xs", catalog[ "a" ] ) );
+    const H2::Collection::RawPointersPtr after = h -> xs.Pointers();
+    BOOST_CHECK( after != pointers );
+    BOOST_REQUIRE( after -> size() == 1 );
+    BOOST_CHECK( ( *after )[ 0 ] -> F() == 10 );
+    // the previous view is still valid while it's held, then it's freed
+    BOOST_CHECK( pointers -> size() == 2 );
+    const weak_ptr< const H2::Collection::RawPointers > previous = pointers;
+    pointers.reset();
+    BOOST_CHECK( previous.expired() );
+}
+
+BOOST_AUTO_TEST_CASE( parallelCalls )
+{
+    const int parts = 100;
+    Catalog catalog;
+    BOOST_REQUIRE_NO_THROW( catalog.Create( "l", "L2" ) );
+    shared_ptr< L2 > l = catalog[ "l" ];
+
+    // no parts: nothing is called
+    BOOST_CHECK_NO_THROW( l -> ks.ParallelForEach( &K2::Check ) );
+    BOOST_CHECK( l -> ks.ParallelReduce( &K2::Value, 7, std::plus< int >() ) == 7 );
+
+    for ( int i = 0; i < parts; ++i )
+    {
+        std::ostringstream name;
+        name << 'k' << i;
+        BOOST_REQUIRE_NO_THROW( catalog.Create( name.str(), "K2" ) );
+        wallaroo_within( catalog )
+        {
+            BOOST_REQUIRE_NO_THROW( use( name.str() ).as( "ks" ).of( "l" ) );
+        }
+    }
+    BOOST_REQUIRE_NO_THROW( catalog.Seal() );
+
+    BOOST_CHECK_NO_THROW( l -> ks.ParallelForEach( &K2::Add, 3 ) );
+    BOOST_CHECK_NO_THROW( l -> ks.ParallelForEach( &K2::Scale, 2, 1 ) );
+    BOOST_CHECK_NO_THROW( l -> ks.ParallelForEach( Doubler() ) );
+    BOOST_CHECK_NO_THROW( l -> ks.ParallelForEach( &K2::Check ) );
+    // every part has been called exactly once for each call
+    bool allCalled = true;
+    const Collaborator< K2, collection >::RawPointersPtr view = l -> ks.Pointers();
+    const Collaborator< K2, collection >::RawPointers& pointers = *view;
+    for ( std::size_t i = 0; i < pointers.size(); ++i )
+        if ( pointers[ i ] -> value != 14 ) allCalled = false;
+    BOOST_CHECK( allCalled );
+
+    BOOST_CHECK( l -> ks.ParallelReduce( &K2::Value, 1, std::plus< int >() ) == 14 * parts + 1 );
+    // a non-const reference argument is passed to every call
+    atomic< int > total( 0 );
+    BOOST_CHECK_NO_THROW( l -> ks.ParallelForEach( &K2::AddTo, total ) );
+    BOOST_CHECK( total.load() == 14 * parts );
+
+    // the exception thrown by a part is propagated to the caller
+    pointers[ parts / 2 ] -> value = -1;
+    BOOST_CHECK_THROW( l -> ks.ParallelForEach( &K2::Check ), std::runtime_error );
+    // the collection can still be used
+    pointers[ parts / 2 ] -> value = 14;
+    BOOST_CHECK_NO_THROW( l -> ks.ParallelForEach( &K2::Check ) );
+}
+
+// creates a part of class H2 on demand
+void LazyH2( Catalog& catalog, const Symbol& id )
+{
+    catalog.Create( id.Name(), "H2" );
+}
+
+BOOST_AUTO_TEST_CASE( prototypes )
+{
+    Catalog catalog;
+    catalog.EnableCloning();
+    BOOST_REQUIRE_NO_THROW( catalog.Create( "a", "A2" ) );
+    BOOST_REQUIRE_NO_THROW( catalog.Create( "m", "M2", 7 ) );
+    BOOST_REQUIRE_NO_THROW( catalog.Create( "n", "N2" ) );
+    wallaroo_within( catalog )
+    {
+        BOOST_REQUIRE_NO_THROW( use( "n" ).as( "helper" ).of( "m" ) );
+        BOOST_REQUIRE_NO_THROW( use( "a" ).as( "shared" ).of( "m" ) );
+        BOOST_REQUIRE_NO_THROW( use( "m" ).as( "back" ).of( "n" ) );
+        BOOST_REQUIRE_NO_THROW( set_attribute( "name" ).of( "m" ).to( std::string( "first" ) ) );
+        BOOST_REQUIRE_NO_THROW( set_attribute( "level" ).of( "n" ).to( 3 ) );
+    }
+
+    std::vector< std::string > ids;
+    ids.push_back( "m" );
+    ids.push_back( "n" );
+    Prototype prototype( catalog, ids );
+
+    Catalog session;
+    BOOST_REQUIRE_NO_THROW( prototype.Clone( session ) );
+    BOOST_CHECK( session.IsWiringOk() );
+    shared_ptr< A2 > a = catalog[ "a" ];
+    shared_ptr< M2 > m = catalog[ "m" ];
+    shared_ptr< M2 > m1 = session[ "m" ];
+    shared_ptr< N2 > n1 = session[ "n" ];
+    BOOST_CHECK_THROW( session[ "a" ], ElementNotFound );
+    // fresh instances with the same constructor parameters and attributes
+    BOOST_CHECK( m1 != m );
+    BOOST_CHECK( m1 -> k == 7 );
+    BOOST_CHECK( static_cast< std::string >( m1 -> name ) == "first" );
+    BOOST_CHECK( static_cast< int >( n1 -> level ) == 3 );
+    // the internal links are rewired to the copies, the external ones are kept
+    shared_ptr< N2 > helper = m1 -> helper;
+    shared_ptr< Part > back = n1 -> back;
+    shared_ptr< I2 > external = m1 -> shared;
+    BOOST_CHECK( helper == n1 );
+    BOOST_CHECK( back == m1 );
+    BOOST_CHECK( external == a );
+
+    // the copies get the current values of the attributes
+    wallaroo_within( catalog )
+    {
+        BOOST_REQUIRE_NO_THROW( set_attribute( "name" ).of( "m" ).to( std::string( "second" ) ) );
+    }
+    Catalog session2;
+    BOOST_REQUIRE_NO_THROW( prototype.Clone( session2 ) );
+    shared_ptr< M2 > m2 = session2[ "m" ];
+    BOOST_CHECK( static_cast< std::string >( m2 -> name ) == "second" );
+    BOOST_CHECK( static_cast< std::string >( m1 -> name ) == "first" );
+    shared_ptr< N2 > helper2 = m2 -> helper;
+    BOOST_CHECK( helper2 != n1 );
+
+    BOOST_CHECK_THROW( prototype.Clone( session ), DuplicatedElement );
+
+    // only the parts created by the catalog can be cloned
+    BOOST_REQUIRE_NO_THROW( catalog.Add( "b", shared_ptr< Part >( new B2 ) ) );
+    BOOST_CHECK_THROW( Prototype( catalog, std::vector< std::string >( 1, "b" ) ), WrongType );
+    BOOST_CHECK_THROW( Prototype( catalog, std::vector< std::string >( 1, "unknown part" ) ), ElementNotFound );
+
+    // without cloning, only the declared parts record how they're created
+    Catalog plain;
+    BOOST_CHECK( ! plain.IsCloningEnabled() );
+    BOOST_REQUIRE_NO_THROW( plain.Create( "c", "A2" ) );
+    BOOST_REQUIRE_NO_THROW( plain.Declare( "lazy", Catalog::Builder( LazyH2 ) ) );
+    BOOST_CHECK_THROW( Prototype( plain, std::vector< std::string >( 1, "c" ) ), WrongType );
+    Prototype lazy( plain, std::vector< std::string >( 1, "lazy" ) );
+    Catalog session3;
+    BOOST_REQUIRE_NO_THROW( lazy.Clone( session3 ) );
+    BOOST_CHECK( static_cast< shared_ptr< H2 > >( session3[ "lazy" ] ) != static_cast< shared_ptr< H2 > >( plain[ "lazy" ] ) );
+}
+
+BOOST_AUTO_TEST_CASE( replicas )
+{
+    Catalog catalog;
+    BOOST_CHECK_THROW( Replicas disabled( catalog ), WrongType ); // the cloning is not enabled
+    catalog.EnableCloning();
+    BOOST_REQUIRE_NO_THROW( catalog.Create( "a", "A2" ) );
+    BOOST_REQUIRE_NO_THROW( catalog.Create( "m", "M2", 7 ) );
+    BOOST_REQUIRE_NO_THROW( catalog.Create( "n", "N2" ) );
+    BOOST_REQUIRE_NO_THROW( catalog.Add( "b", shared_ptr< Part >( new B2 ) ) );
+    catalog.Share( Symbol( "a" ) );
+    BOOST_CHECK( catalog.IsShared( Symbol( "a" ) ) );
+    BOOST_CHECK( ! catalog.IsShared( Symbol( "m" ) ) );
+    wallaroo_within( catalog )
+    {
+        BOOST_REQUIRE_NO_THROW( use( "n" ).as( "helper" ).of( "m" ) );
+        BOOST_REQUIRE_NO_THROW( use( "a" ).as( "shared" ).of( "m" ) );
+        BOOST_REQUIRE_NO_THROW( use( "m" ).as( "back" ).of( "n" ) );
+    }
+    BOOST_REQUIRE_NO_THROW( catalog.Seal() );
+
+    Replicas replicas( catalog );
+    shared_ptr< A2 > a = catalog[ "a" ];
+    shared_ptr< M2 > m = catalog[ "m" ];
+    shared_ptr< M2 > local = replicas[ "m" ];
+    shared_ptr< N2 > localN = replicas[ "n" ];
+    shared_ptr< A2 > localA = replicas[ "a" ];
+    shared_ptr< B2 > localB = replicas[ "b" ];
+    BOOST_CHECK_THROW( replicas[ "unknown part" ], ElementNotFound );
+
+    // the shared parts and the parts added from outside are not replicated
+    BOOST_CHECK( localA == a );
+    BOOST_CHECK( localB.get() == static_cast< shared_ptr< B2 > >( catalog[ "b" ] ).get() );
+    // the other parts are replicated once per thread, with local wiring
+    BOOST_CHECK( local != m );
+    BOOST_CHECK( local -> k == 7 );
+    BOOST_CHECK( static_cast< shared_ptr< M2 > >( replicas[ "m" ] ) == local );
+    BOOST_CHECK( &replicas.Local() == &replicas.Local() );
+    shared_ptr< N2 > helper = local -> helper;
+    shared_ptr< I2 > external = local -> shared;
+    BOOST_CHECK( helper == localN );
+    BOOST_CHECK( external == a );
+    shared_ptr< Part > back = localN -> back;
+    BOOST_CHECK( back == local );
+
+    shared_ptr< M2 > other1;
+    shared_ptr< M2 > other2;
+    {
+        thread t1( ReplicaReader( replicas, other1 ) );
+        thread t2( ReplicaReader( replicas, other2 ) );
+        t1.join();
+        t2.join();
+    }
+    BOOST_REQUIRE( other1 && other2 );
+    BOOST_CHECK( other1 != local );
+    BOOST_CHECK( other2 != local );
+    BOOST_CHECK( other1 != other2 );
+    BOOST_CHECK( other1 != m );
+
+    // the numbered replicas
+    Catalog& replica0 = replicas.Replica( 0 );
+    BOOST_CHECK( &replicas.Replica( 0 ) == &replica0 );
+    BOOST_CHECK( &replicas.Replica( 1 ) != &replica0 );
+    BOOST_CHECK( &replica0 != &replicas.Local() );
+    shared_ptr< M2 > numbered = replica0[ "m" ];
+    BOOST_CHECK( numbered != local );
+    BOOST_CHECK_THROW( replica0[ "a" ], ElementNotFound );
+}
+
+BOOST_AUTO_TEST_CASE( childCatalogs )
+{
+    Catalog parent;
+    BOOST_REQUIRE_NO_THROW( parent.Create( "a", "A2" ) );
+    BOOST_REQUIRE_NO_THROW( parent.Create( "h", "H2" ) );
+    shared_ptr< A2 > a = parent[ "a" ];
+    {
+        Catalog child( &parent );
+        BOOST_REQUIRE_NO_THROW( child.Create( "b", "B2" ) );
+        BOOST_REQUIRE_NO_THROW( child.Create( "h2", "H2" ) );
+        BOOST_REQUIRE_NO_THROW( child.Declare( "lazy", Catalog::Builder( LazyH2 ) ) );
+        BOOST_REQUIRE_NO_THROW( child.DeclareWiring( Symbol( "lazy" ), Symbol( "x" ), Symbol( "a" ) ) );
+
+        // the names not in the child are looked up in the parent
+        shared_ptr< A2 > fromParent = child[ "a" ];
+        BOOST_CHECK( fromParent == a );
+        BOOST_CHECK_THROW( parent[ "b" ], ElementNotFound );
+        BOOST_CHECK_THROW( child[ "unknown part" ], ElementNotFound );
+
+        wallaroo_within( child )
+        {
+            BOOST_REQUIRE_NO_THROW( use( "a" ).as( "x" ).of( "h2" ) );
+            BOOST_REQUIRE_NO_THROW( use( "b" ).as( "xs" ).of( "h2" ) );
+            BOOST_REQUIRE_NO_THROW( use( "a" ).as( "xs" ).of( "h2" ) );
+        }
+        shared_ptr< H2 > h2 = child[ "h2" ];
+        BOOST_CHECK( h2 -> F() == 5 );
+        BOOST_CHECK( h2 -> Sum() == 15 );
+        BOOST_CHECK( child.IsWiringOk() );
+
+        // the declared parts are wired to the parts of the parent, too
+        shared_ptr< H2 > lazy = child[ "lazy" ];
+        BOOST_CHECK( lazy -> F() == 5 );
+
+        // a part of the child hides the part of the parent with the same name
+        BOOST_REQUIRE_NO_THROW( child.Create( "a", "B2" ) );
+        shared_ptr< A2 > hiding = child[ "a" ];
+        BOOST_CHECK( hiding != a );
+        BOOST_CHECK( hiding -> F() == 10 );
+
+        // the lookups go through all the ancestors
+        Catalog grandchild( &child );
+        shared_ptr< H2 > fromGrandparent = grandchild[ "h" ];
+        BOOST_CHECK( fromGrandparent == static_cast< shared_ptr< H2 > >( parent[ "h" ] ) );
+        shared_ptr< A2 > nearest = grandchild[ "a" ];
+        BOOST_CHECK( nearest == hiding );
+    }
+    // the parent is unaffected by the destruction of its children
+    BOOST_CHECK( static_cast< shared_ptr< A2 > >( parent[ "a" ] ) == a );
+    BOOST_CHECK( parent.IsWiringOk() == false ); // "h" has never been wired
+}
+
+BOOST_AUTO_TEST_CASE( childPrototypes )
+{
+    Catalog parent;
+    parent.EnableCloning();
+    BOOST_REQUIRE_NO_THROW( parent.Create( "a", "A2" ) );
+    BOOST_REQUIRE_NO_THROW( parent.Create( "m", "M2", 7 ) );
+    Catalog child( &parent );
+    child.EnableCloning();
+    BOOST_REQUIRE_NO_THROW( child.Create( "n", "N2" ) );
+    wallaroo_within( child )
+    {
+        BOOST_REQUIRE_NO_THROW( use( "m" ).as( "back" ).of( "n" ) );
+        BOOST_REQUIRE_NO_THROW( use( "a" ).as( "shared" ).of( "m" ) );
+    }
+
+    // the parts of the prototype can belong to the parent
+    std::vector< std::string > ids;
+    ids.push_back( "m" );
+    ids.push_back( "n" );
+    Prototype prototype( child, ids );
+    Catalog session;
+    BOOST_REQUIRE_NO_THROW( prototype.Clone( session ) );
+    shared_ptr< M2 > m = parent[ "m" ];
+    shared_ptr< M2 > m1 = session[ "m" ];
+    shared_ptr< N2 > n1 = session[ "n" ];
+    BOOST_CHECK( m1 != m );
+    BOOST_CHECK( m1 -> k == 7 );
+    shared_ptr< Part > back = n1 -> back;
+    shared_ptr< I2 > external = m1 -> shared;
+    BOOST_CHECK( back == m1 );
+    BOOST_CHECK( external == static_cast< shared_ptr< A2 > >( parent[ "a" ] ) );
+    BOOST_CHECK_THROW( Prototype( child, std::vector< std::string >( 1, "unknown part" ) ), ElementNotFound );
+}
+
+BOOST_AUTO_TEST_CASE( typeIndex )
+{
+    Catalog catalog;
+    BOOST_CHECK( catalog.All< I2 >().empty() );
+    BOOST_REQUIRE_NO_THROW( catalog.Create( "a", "A2" ) );
+    BOOST_REQUIRE_NO_THROW( catalog.Create( "b", "B2" ) );
+    BOOST_REQUIRE_NO_THROW( catalog.Create( "c", "C2" ) );
+    BOOST_REQUIRE_NO_THROW( catalog.Add( "h", shared_ptr< Part >( new H2 ) ) );
+    shared_ptr< A2 > a = catalog[ "a" ];
+    shared_ptr< B2 > b = catalog[ "b" ];
+
+    // the parts assignable to an interface, in the order they've been added
+    Catalog::Range< I2 > interfaces = catalog.All< I2 >();
+    BOOST_REQUIRE( interfaces.size() == 2 );
+    BOOST_CHECK( interfaces[ 0 ] == a.get() );
+    BOOST_CHECK( interfaces[ 1 ] == b.get() );
+    int sum = 0;
+    for ( Catalog::Range< I2 >::const_iterator i = interfaces.begin(); i != interfaces.end(); ++i )
+        sum += ( *i ) -> F();
+    BOOST_CHECK( sum == 15 );
+
+    // base classes and concrete classes
+    BOOST_CHECK( catalog.All< A2 >().size() == 2 );
+    BOOST_REQUIRE( catalog.All< B2 >().size() == 1 );
+    BOOST_CHECK( catalog.All< B2 >()[ 0 ] == b.get() );
+    BOOST_CHECK( catalog.All< H2 >().size() == 1 );
+    BOOST_CHECK( catalog.All< Part >().size() == 4 );
+    BOOST_CHECK( catalog.All< const I2 >().size() == 2 );
+    BOOST_CHECK( catalog.All< D2 >().empty() );
+
+    // the index is updated when parts are added, the ranges already returned are not
+    BOOST_REQUIRE_NO_THROW( catalog.Create( "b2", "B2" ) );
+    BOOST_CHECK( interfaces.size() == 2 );
+    Catalog::Range< I2 > updated = catalog.All< I2 >();
+    BOOST_REQUIRE( updated.size() == 3 );
+    BOOST_CHECK( updated[ 2 ] == static_cast< shared_ptr< I2 > >( catalog[ "b2" ] ).get() );
+    BOOST_CHECK( catalog.All< B2 >().size() == 2 );
+
+    // a failed insertion leaves the index untouched
+    BOOST_CHECK_THROW( catalog.Create( "a", "B2" ), DuplicatedElement );
+    BOOST_CHECK( catalog.All< I2 >().size() == 3 );
+}
+
+BOOST_AUTO_TEST_CASE( autowiring )
+{
+    Catalog catalog;
+    BOOST_REQUIRE_NO_THROW( catalog.Create( "a", "A2" ) );
+    BOOST_REQUIRE_NO_THROW( catalog.Create( "h", "H2" ) );
+    BOOST_REQUIRE_NO_THROW( catalog.Create( "o", "O2" ) );
+    BOOST_REQUIRE_NO_THROW( catalog.Create( "c", "C2" ) );
+    BOOST_REQUIRE_NO_THROW( catalog.Create( "e", "E2" ) );
+    // the wiring already done is not changed
+    wallaroo_within( catalog )
+    {
+        BOOST_REQUIRE_NO_THROW( use( "o" ).as( "x" ).of( "c" ) );
+    }
+    BOOST_CHECK( ! catalog.IsWiringOk() );
+
+    // "h" has two collaborators of type I2: "a" and "o" ("o" excludes itself)
+    BOOST_CHECK_THROW( catalog.Autowire(), AmbiguousWiring );
+    try
+    {
+        catalog.Autowire();
+    }
+    catch ( const AmbiguousWiring& e )
+    {
+        BOOST_CHECK( e.PartName() == "h" );
+        BOOST_CHECK( e.CollaboratorName() == "x" );
+        BOOST_REQUIRE( e.Candidates().size() == 2 );
+        BOOST_CHECK( e.Candidates()[ 0 ] == "a" );
+        BOOST_CHECK( e.Candidates()[ 1 ] == "o" );
+    }
+    wallaroo_within( catalog )
+    {
+        BOOST_REQUIRE_NO_THROW( use( "o" ).as( "x" ).of( "h" ) );
+    }
+    BOOST_REQUIRE_NO_THROW( catalog.Autowire() );
+    BOOST_CHECK( catalog.IsWiringOk() );
+
+    shared_ptr< H2 > h = catalog[ "h" ];
+    shared_ptr< O2 > o = catalog[ "o" ];
+    shared_ptr< C2 > c = catalog[ "c" ];
+    BOOST_CHECK( h -> F() == 6 ); // wired by hand
+    BOOST_CHECK( h -> Sum() == 11 ); // a collection is wired to all the candidates
+    BOOST_CHECK( o -> F() == 6 ); // the only candidate other than itself
+    BOOST_CHECK( c -> F() == 6 );
+    BOOST_CHECK( static_cast< shared_ptr< E2 > >( catalog[ "e" ] ) -> F() == 33 );
+    shared_ptr< I2 > inner = o -> inner;
+    BOOST_CHECK( inner == static_cast< shared_ptr< I2 > >( catalog[ "a" ] ) );
+
+    // autowiring again changes nothing
+    BOOST_REQUIRE_NO_THROW( catalog.Create( "b", "B2" ) );
+    BOOST_REQUIRE_NO_THROW( catalog.Autowire() );
+    BOOST_CHECK( h -> Sum() == 11 );
+    BOOST_CHECK( o -> F() == 6 );
+}
+
+BOOST_AUTO_TEST_CASE( instanceLayouts )
+{
+    Catalog catalog;
+    catalog.EnableCloning();
+
+    BOOST_REQUIRE_NO_THROW( catalog.Create( "a", "A2" ) );
+    BOOST_REQUIRE_NO_THROW( catalog.Create( "b", "B2" ) );
+    BOOST_REQUIRE_NO_THROW( catalog.Create( "p1", "P2", std::string( "first" ) ) );
+    BOOST_REQUIRE_NO_THROW( catalog.Create( "p2", "P2", std::string( "second" ) ) );
+    BOOST_REQUIRE_NO_THROW( catalog.Create( "p3", "P2", std::string( "first" ) ) );
+    BOOST_REQUIRE_NO_THROW( catalog.Create( "q1", "Q2" ) );
+    BOOST_REQUIRE_NO_THROW( catalog.Create( "q2", "Q2" ) );
+
+    wallaroo_within( catalog )
+    {
+        BOOST_REQUIRE_NO_THROW( use( "a" ).as( "first" ).of( "p1" ) );
+        BOOST_REQUIRE_NO_THROW( use( "b" ).as( "second" ).of( "p2" ) );
+        BOOST_REQUIRE_NO_THROW( use( "b" ).as( "first" ).of( "p3" ) );
+        BOOST_CHECK_THROW( use( "a" ).as( "second" ).of( "p1" ), ElementNotFound );
+        BOOST_CHECK_THROW( use( "a" ).as( "first" ).of( "p2" ), ElementNotFound );
+
+        BOOST_REQUIRE_NO_THROW( use( "a" ).as( "x" ).of( "q1" ) );
+        BOOST_REQUIRE_NO_THROW( use( "b" ).as( "x" ).of( "q2" ) );
+        BOOST_REQUIRE_NO_THROW( set_attribute( "k" ).of( "q1" ).to( 1 ) );
+        BOOST_REQUIRE_NO_THROW( set_attribute( "k" ).of( "q2" ).to( 2 ) );
+    }
+
+    BOOST_CHECK( catalog.IsWiringOk() );
+    shared_ptr< P2 > p1 = catalog[ "p1" ];
+    shared_ptr< P2 > p2 = catalog[ "p2" ];
+    shared_ptr< P2 > p3 = catalog[ "p3" ];
+    BOOST_CHECK( p1 -> F() == 5 );
+    BOOST_CHECK( p2 -> F() == 10 );
+    BOOST_CHECK( p3 -> F() == 10 );
+    shared_ptr< Q2 > q1 = catalog[ "q1" ];
+    shared_ptr< Q2 > q2 = catalog[ "q2" ];
+    BOOST_CHECK( q1 -> F() == 6 );
+    BOOST_CHECK( q2 -> F() == 12 );
+
+    // a prototype copies the members allocated on the heap of each instance
+    Prototype prototype( catalog, std::vector< std::string >( 1, "q2" ) );
+    Catalog copies;
+    BOOST_REQUIRE_NO_THROW( prototype.Clone( copies ) );
+    shared_ptr< Q2 > q3 = copies[ "q2" ];
+    BOOST_CHECK( q3 -> F() == 12 );
+}
+
+BOOST_AUTO_TEST_CASE( addedParts )
+{
+    shared_ptr< H2 > h = make_shared< H2 >();
+    weak_ptr< A2 > watch;
+    {
+        Catalog catalog;
+        const shared_ptr< A2 > a = make_shared< A2 >();
+        watch = a;
+        BOOST_REQUIRE_NO_THROW( catalog.Add( "a", a ) );
+        BOOST_REQUIRE_NO_THROW( catalog.Add( "b", make_shared< B2 >() ) );
+        BOOST_REQUIRE_NO_THROW( catalog.Add( "h", h ) );
+        wallaroo_within( catalog )
+        {
+            BOOST_REQUIRE_NO_THROW( use( "a" ).as( "x" ).of( "h" ) );
+            BOOST_REQUIRE_NO_THROW( use( "a" ).as( "xs" ).of( "h" ) );
+            BOOST_REQUIRE_NO_THROW( use( "b" ).as( "xs" ).of( "h" ) );
+        }
+        BOOST_CHECK( h -> F() == 5 );
+        BOOST_CHECK( h -> Sum() == 15 );
+
+        // the shared pointers to the parts share the control block of the catalog
+        const H2::Collection::SharedPointers parts = h -> xs.Lock();
+        BOOST_REQUIRE( parts.size() == 2 );
+        const shared_ptr< Part > b = catalog[ "b" ];
+        BOOST_CHECK( ! parts[ 1 ].owner_before( b ) && ! b.owner_before( parts[ 1 ] ) );
+
+        BOOST_CHECK( h -> Unwire( "xs", catalog[ "a" ] ) );
+        BOOST_CHECK( h -> Sum() == 10 );
+    }
+#ifdef WALLAROO_INTRUSIVE_PARTS
+    // the collaborator keeps its part alive
+    BOOST_CHECK( ! watch.expired() );
+    BOOST_CHECK( h -> F() == 5 );
+    h.reset();
+#endif
+    BOOST_CHECK( watch.expired() );
+}
+
+BOOST_AUTO_TEST_SUITE_END()
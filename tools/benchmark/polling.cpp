@@ -0,0 +1,179 @@
+/*******************************************************************************
+ * wallaroo - A library for configurable creation and wiring of C++ classes.
+ * Copyright (C) 2012 Daniele Pallastrelli
+ *
+ * This file is part of wallaroo.
+ * For more information, see http://wallaroo.googlecode.com/
+ *
+ * Boost Software License - Version 1.0 - August 17th, 2003
+ *
+ * Permission is hereby granted, free of charge, to any person or organization
+ * obtaining a copy of the software and accompanying documentation covered by
+ * this license (the "Software") to use, reproduce, display, distribute,
+ * execute, and transmit the Software, and to prepare derivative works of the
+ * Software, and to permit third-parties to whom the Software is furnished to
+ * do so, all subject to the following:
+ *
+ * The copyright notices in the Software and this entire statement, including
+ * the above license grant, this restriction and the following disclaimer,
+ * must be included in all copies of the Software, in whole or in part, and
+ * all derivative works of the Software, unless such copies or derivative
+ * works are solely in the form of machine-executable object code generated by
+ * a source language processor.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT
+ * SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE
+ * FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE,
+ * ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ ******************************************************************************/
+
+// polling measures the cost of the reference counting in a loop similar to
+// the mineplant sample: at every cycle the watchers are looked up in the
+// catalog and each one polls its sensors through the collaborators.
+// Build it with and without WALLAROO_SINGLE_THREADED (and
+// WALLAROO_INTRUSIVE_PARTS) to compare the ownership policies: see Makefile.
+// WALLAROO_SINGLE_THREADED doesn't change the std::shared_ptr counts, so
+// it must be combined with WALLAROO_INTRUSIVE_PARTS or WALLAROO_FORCE_USE_BOOST.
+// Usage: polling [cycles]
+
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+#include <cstdlib>
+#include <ctime>
+#include "wallaroo/registered.h"
+#include "wallaroo/catalog.h"
+
+#if defined( WALLAROO_SINGLE_THREADED ) && defined( WALLAROO_HAS_CXX0X ) && !defined( WALLAROO_INTRUSIVE_PARTS )
+    #error "WALLAROO_SINGLE_THREADED has no effect on std::shared_ptr: define WALLAROO_FORCE_USE_BOOST"
+#endif
+
+using namespace wallaroo;
+
+class Sensor : public Part
+{
+public:
+    Sensor() : threshold( "threshold", RegistrationToken() ), value( 0 ) {}
+    bool IsCritical() { return ++value > threshold; }
+private:
+    Attribute< int > threshold;
+    int value;
+};
+WALLAROO_REGISTER( Sensor )
+
+class Alarm : public Part
+{
+public:
+    Alarm() : on( 0 ), off( 0 ) {}
+    void On() { ++on; }
+    void Off() { ++off; }
+    unsigned long Count() const { return on + off; }
+private:
+    unsigned long on;
+    unsigned long off;
+};
+WALLAROO_REGISTER( Alarm )
+
+class Watcher : public Part
+{
+public:
+    Watcher() :
+        sensors( "sensors", RegistrationToken() ),
+        alarm( "alarm", RegistrationToken() )
+    {
+    }
+    void Watch()
+    {
+        for ( Sensors::iterator i = sensors.begin(); i != sensors.end(); ++i )
+        {
+            if ( i -> lock() -> IsCritical() )
+            {
+                alarm -> On();
+                return;
+            }
+        }
+        alarm -> Off();
+    }
+private:
+    typedef Collaborator< Sensor, collection > Sensors;
+    Sensors sensors;
+    Collaborator< Alarm > alarm;
+};
+WALLAROO_REGISTER( Watcher )
+
+static std::string Name( const char* prefix, int i )
+{
+    std::ostringstream name;
+    name << prefix << i;
+    return name.str();
+}
+
+// return the nanoseconds spent by each watcher poll
+static double Poll( Catalog& catalog, const std::vector< Symbol >& watchers, unsigned long cycles )
+{
+    const std::clock_t start = std::clock();
+    for ( unsigned long c = 0; c < cycles; ++c )
+        for ( std::vector< Symbol >::const_iterator i = watchers.begin(); i != watchers.end(); ++i )
+        {
+            cxx0x::shared_ptr< Watcher > watcher = catalog[ *i ];
+            watcher -> Watch();
+        }
+    const double elapsed = static_cast< double >( std::clock() - start ) / CLOCKS_PER_SEC;
+    return elapsed * 1e9 / ( static_cast< double >( cycles ) * watchers.size() );
+}
+
+int main( int argc, char* argv[] )
+{
+    const int sensorsCount = 8;
+    const int watchersCount = 16;
+    const unsigned long cycles = ( argc > 1 ? std::strtoul( argv[ 1 ], NULL, 10 ) : 200000 );
+
+    Catalog catalog;
+    catalog.Create( "alarm", "Alarm" );
+    for ( int s = 0; s < sensorsCount; ++s )
+    {
+        catalog.Create( Name( "sensor", s ), "Sensor" );
+        catalog[ Name( "sensor", s ) ].SetAttribute( "threshold", 1000000000 );
+    }
+    std::vector< Symbol > watchers;
+    for ( int w = 0; w < watchersCount; ++w )
+    {
+        watchers.push_back( Symbol( Name( "watcher", w ) ) );
+        catalog.Create( watchers.back(), Symbol( "Watcher" ) );
+        wallaroo_within( catalog )
+        {
+            use( "alarm" ).as( "alarm" ).of( watchers.back() );
+            for ( int s = 0; s < sensorsCount; ++s )
+                use( Name( "sensor", s ) ).as( "sensors" ).of( watchers.back() );
+        }
+    }
+    catalog.CheckWiring();
+
+    const double unsealed = Poll( catalog, watchers, cycles );
+    catalog.Seal();
+    const double sealed = Poll( catalog, watchers, cycles );
+
+    std::cout << "policy:";
+#ifdef WALLAROO_SINGLE_THREADED
+    std::cout << " single-threaded";
+#else
+    std::cout << " multi-threaded";
+#endif
+#ifdef WALLAROO_INTRUSIVE_PARTS
+    std::cout << ", intrusive";
+#endif
+#ifdef WALLAROO_HAS_CXX0X
+    std::cout << ", std" << std::endl;
+#else
+    std::cout << ", boost" << std::endl;
+#endif
+    std::cout << "  " << unsealed << " ns/poll" << std::endl;
+    std::cout << "  " << sealed << " ns/poll (sealed catalog)" << std::endl;
+
+    cxx0x::shared_ptr< Alarm > alarm = catalog[ "alarm" ];
+    return ( alarm -> Count() == 2 * cycles * watchersCount ? EXIT_SUCCESS : EXIT_FAILURE );
+}
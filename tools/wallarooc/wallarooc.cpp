@@ -0,0 +1,79 @@
+/*******************************************************************************
+ * wallaroo - A library for configurable creation and wiring of C++ classes.
+ * Copyright (C) 2012 Daniele Pallastrelli
+ *
+ * This file is part of wallaroo.
+ * For more information, see http://wallaroo.googlecode.com/
+ *
+ * Boost Software License - Version 1.0 - August 17th, 2003
+ *
+ * Permission is hereby granted, free of charge, to any person or organization
+ * obtaining a copy of the software and accompanying documentation covered by
+ * this license (the "Software") to use, reproduce, display, distribute,
+ * execute, and transmit the Software, and to prepare derivative works of the
+ * Software, and to permit third-parties to whom the Software is furnished to
+ * do so, all subject to the following:
+ *
+ * The copyright notices in the Software and this entire statement, including
+ * the above license grant, this restriction and the following disclaimer,
+ * must be included in all copies of the Software, in whole or in part, and
+ * all derivative works of the Software, unless such copies or derivative
+ * works are solely in the form of machine-executable object code generated by
+ * a source language processor.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT
+ * SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE
+ * FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE,
+ * ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ ******************************************************************************/
+
+// wallarooc compiles a xml or json configuration file into a binary image
+// that can be loaded by wallaroo::BinaryConfiguration.
+// With --check, it verifies instead that the image is valid and that its
+// source file has not changed after the compilation.
+// Usage: wallarooc <source.xml|source.json> <image>
+//        wallarooc --check <image>
+
+#include <iostream>
+#include <string>
+#include "wallaroo/binaryconfiguration.h"
+
+using namespace wallaroo;
+
+static bool EndsWith( const std::string& s, const std::string& suffix )
+{
+    return s.size() >= suffix.size() && s.compare( s.size() - suffix.size(), suffix.size(), suffix ) == 0;
+}
+
+int main( int argc, char* argv[] )
+{
+    if ( argc != 3 )
+    {
+        std::cerr << "Usage: " << argv[ 0 ] << " <source.xml|source.json> <image>" << std::endl;
+        std::cerr << "       " << argv[ 0 ] << " --check <image>" << std::endl;
+        return 1;
+    }
+
+    const std::string source( argv[ 1 ] );
+    const std::string image( argv[ 2 ] );
+
+    try
+    {
+        if ( source == "--check" )
+            BinaryConfiguration( image ).CheckSource();
+        else if ( EndsWith( source, ".json" ) )
+            BinaryConfiguration::CompileJson( source, image );
+        else
+            BinaryConfiguration::CompileXml( source, image );
+    }
+    catch ( const WallarooError& e )
+    {
+        std::cerr << e.what() << std::endl;
+        return 1;
+    }
+
+    return 0;
+}
@@ -34,43 +34,18 @@
 #define WALLAROO_ATTRIBUTE_H_
 
 #include <string>
-#include <sstream>
 #include <iostream>
+#include <typeinfo>
 #include "cxx0x.h"
 #include "part.h"
 #include "deserializable_value.h"
+#include "codec.h"
 #include "exceptions.h"
 
 
 namespace wallaroo
 {
 
-namespace detail
-{
-    // Template function that converts a string into a value of type T
-    // It provides a specialization to manage the case of type string
-
-    // Generic conversion: try to convert v to type T and put the result in value
-    // throw WrongType if v cannot be converted to T
-    template < typename T >
-    inline void String2Value( const std::string& v, T& value )
-    {
-        std::istringstream istream( v );
-        if ( !( istream >> std::boolalpha >> value ) )
-        {
-            // error: didn't convert to T
-            throw WrongType();
-        }
-    }
-
-    // T is a string. No conversion needed
-    template <>
-    inline void String2Value< std::string >( const std::string& v, std::string& value )
-    {
-        value = v;
-    }
-}
-
 /**
  * This is an attribute of a part. An attribute has a type T and
  * you can set its value at runtime by code or from a configuration file.
@@ -102,9 +77,30 @@ public:
      * @param v the string representation of the value
      * @throw WrongType if v cannot be converted to T
      */
-    virtual void Value( const std::string& v )
+    virtual void Value( StringView v )
+    {
+        if ( ! detail::Decode( v, value ) ) throw WrongType();
+    }
+
+    /** Assign a value to the Attribute, if its type is @c T
+     * @param type the type of the value pointed by @c v
+     * @param v a pointer to the value
+     * @return false if @c type is not @c T
+     */
+    virtual bool Assign( const std::type_info& type, const void* v )
+    {
+        if ( type != typeid( T ) ) return false;
+        value = *static_cast< const T* >( v );
+        return true;
+    }
+
+    /** Assign the value of the Attribute to @c other, if its type is @c T
+     * @param other the attribute to assign
+     * @return false if the type of @c other is not @c T
+     */
+    virtual bool CopyTo( DeserializableValue& other ) const
     {
-        detail::String2Value( v, value );
+        return other.Assign( typeid( T ), &value );
     }
 
     /** Conversion operator to the internal type @c T. Retrieve the internal value.
@@ -0,0 +1,238 @@
+/*******************************************************************************
+ * wallaroo - A library for configurable creation and wiring of C++ classes.
+ * Copyright (C) 2012 Daniele Pallastrelli
+ *
+ * This file is part of wallaroo.
+ * For more information, see http://wallaroo.googlecode.com/
+ *
+ * Boost Software License - Version 1.0 - August 17th, 2003
+ *
+ * Permission is hereby granted, free of charge, to any person or organization
+ * obtaining a copy of the software and accompanying documentation covered by
+ * this license (the "Software") to use, reproduce, display, distribute,
+ * execute, and transmit the Software, and to prepare derivative works of the
+ * Software, and to permit third-parties to whom the Software is furnished to
+ * do so, all subject to the following:
+ *
+ * The copyright notices in the Software and this entire statement, including
+ * the above license grant, this restriction and the following disclaimer,
+ * must be included in all copies of the Software, in whole or in part, and
+ * all derivative works of the Software, unless such copies or derivative
+ * works are solely in the form of machine-executable object code generated by
+ * a source language processor.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT
+ * SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE
+ * FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE,
+ * ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ ******************************************************************************/
+
+#ifndef WALLAROO_BINARYCONFIGURATION_H_
+#define WALLAROO_BINARYCONFIGURATION_H_
+
+#include <string>
+#include <vector>
+#include <fstream>
+#include <sstream>
+#include <iterator>
+#include "catalog.h"
+#include "dynamic_loader.h"
+#include "parameters.h"
+#include "detail/mapped_file.h"
+#include "detail/binaryimage.h"
+#include "detail/streambasedcfg.h"
+#include "detail/xmlstreamparser.h"
+#include "detail/jsonstreamparser.h"
+#include "detail/platform_specific_lib_macros.h"
+
+#ifdef WALLAROO_DETAIL_OS_FAMILY_WINDOWS
+    #include <direct.h>
+#else
+    #include <unistd.h>
+#endif
+
+namespace wallaroo
+{
+
+/**
+* This class populates a @c Catalog from the binary image of a configuration,
+* previously compiled from a xml or json configuration file (see
+* BinaryConfiguration::CompileXml and BinaryConfiguration::CompileJson,
+* or the tool @c wallarooc).
+* The image is mapped in memory and contains the strings, the parts
+* (with their constructor parameters and attributes) and the wiring
+* already decoded, so that no text parsing is needed.
+* The image contains a version and a checksum: an image that is corrupted
+* or has been compiled for a different version of the format or for a machine
+* with a different byte order is rejected.
+* The image also records the absolute path, the size and the checksum of its
+* source file: the application can ask to reject the image if the source file
+* has changed since the compilation (see BinaryConfiguration::CheckSource).
+* This check is not done by default, because it reads the whole source file.
+*/
+class BinaryConfiguration
+{
+public:
+    /** Create a BinaryConfiguration from the path specified as parameter.
+    * @param fileName The path of the binary image
+    * @throw WrongFile If the file does not exist or is not a valid image.
+    */
+    explicit BinaryConfiguration( const std::string& fileName ) :
+        name( fileName ),
+        file( fileName ),
+        image( file.Data(), file.Size(), fileName )
+    {
+    }
+
+    /** Check that the source file of the image has not changed after the
+    * compilation. A missing source file is not an error: the image can be
+    * deployed without it.
+    * @throw WrongFile If the content of the source file has changed.
+    */
+    void CheckSource() const
+    {
+        const std::string source = image.Source();
+        if ( source.empty() ) return;
+        std::ifstream in( source.c_str(), std::ios::binary );
+        if ( ! in ) return;
+        in.seekg( 0, std::ios::end );
+        const std::streamoff size = in.tellg();
+        bool stale = ( size < 0 || static_cast< detail::BinaryWord >( size ) != image.SourceSize() );
+        if ( ! stale )
+        {
+            in.seekg( 0, std::ios::beg );
+            const std::string content( ( std::istreambuf_iterator< char >( in ) ), std::istreambuf_iterator< char >() );
+            stale = ( detail::BinaryFormat::Checksum( content.data(), content.data() + content.size() ) != image.SourceChecksum() );
+        }
+        if ( stale ) throw WrongFile( name + ": stale image, " + source + " has changed after the compilation" );
+    }
+
+    /** Load the plugins (shared libraries) specified in the image.
+    * @throw WrongFile If a plugin cannot be loaded.
+    */
+    void LoadPlugins()
+    {
+        for ( detail::BinaryWord i = 0; i < image.Plugins(); ++i )
+            Plugin::Load( image.String( image.Plugin( i ) ) + Plugin::Suffix() );
+    }
+
+    /** Fill the @c catalog with the objects and relations specified in the image.
+    * @param catalog The catalog target of the new items of the image.
+    * @throw WrongFile If the image contains a semantic error.
+    */
+    void Fill( Catalog& catalog )
+    {
+        std::vector< Symbol > symbols( image.Strings() );
+        std::vector< bool > interned( image.Strings(), false );
+
+        for ( detail::BinaryWord i = 0; i < image.Parts(); ++i )
+        {
+            const detail::BinaryPart& part = image.Part( i );
+            const Symbol& name = Intern( part.name, symbols, interned );
+            const Symbol& cl = Intern( part.cl, symbols, interned );
+            if ( part.parameters == 0 )
+                catalog.Create( name, cl );
+            else
+            {
+                const std::string type2 = ( part.parameters == 2 ? image.String( part.type2 ) : std::string() );
+                detail::ParameterTable::Creator create = detail::ParameterTable::Find( image.String( part.type1 ), type2 );
+                if ( create == NULL )
+                    throw WrongFile( "Unknown constructor parameter types for part " + name.Name() );
+                create( catalog, name, cl, image.View( part.value1 ), image.View( part.value2 ) );
+            }
+            for ( detail::BinaryWord a = part.firstAttribute; a < part.firstAttribute + part.attributes; ++a )
+            {
+                const detail::BinaryAttribute& attribute = image.Attribute( a );
+                set_attribute( Intern( attribute.name, symbols, interned ) ).of( catalog[ name ] ).to( image.View( attribute.value ) );
+            }
+            if ( part.flags & detail::BinaryPart::shared ) catalog.Share( name );
+        }
+
+        for ( detail::BinaryWord i = 0; i < image.Wires(); ++i )
+        {
+            const detail::BinaryWire& wire = image.Wire( i );
+            use( catalog[ Intern( wire.dest, symbols, interned ) ] )
+                .as( Intern( wire.collaborator, symbols, interned ) )
+                .of( catalog[ Intern( wire.source, symbols, interned ) ] );
+        }
+    }
+
+    /** Compile the xml configuration file @c source into the binary image @c image.
+    * @throw WrongFile If the source file does not exist or contains an error,
+    *        or if the image cannot be written.
+    */
+    static void CompileXml( const std::string& source, const std::string& image )
+    {
+        Compile< detail::XmlStreamParser >( source, image );
+    }
+
+    /** Compile the json configuration file @c source into the binary image @c image.
+    * @throw WrongFile If the source file does not exist or contains an error,
+    *        or if the image cannot be written.
+    */
+    static void CompileJson( const std::string& source, const std::string& image )
+    {
+        Compile< detail::JsonStreamParser >( source, image );
+    }
+
+private:
+
+    // the symbol of the string @c i of the image, interned on first use
+    const Symbol& Intern( detail::BinaryWord i, std::vector< Symbol >& symbols, std::vector< bool >& interned ) const
+    {
+        if ( ! interned[ i ] )
+        {
+            symbols[ i ] = Symbol( image.String( i ) );
+            interned[ i ] = true;
+        }
+        return symbols[ i ];
+    }
+
+    template < typename Parser >
+    static void Compile( const std::string& source, const std::string& image )
+    {
+        std::ifstream file( source.c_str(), std::ios::binary );
+        if ( ! file ) throw WrongFile( "cannot open file " + source );
+        const std::string content( ( std::istreambuf_iterator< char >( file ) ), std::istreambuf_iterator< char >() );
+        detail::BinaryImageWriter writer;
+        writer.OnSource( Absolute( source ), content );
+        detail::CfgBuilder< detail::BinaryImageWriter > builder( writer );
+        std::istringstream in( content );
+        Parser parser( in, source );
+        parser.Parse( builder );
+
+        std::ofstream out( image.c_str(), std::ios::binary );
+        if ( ! out ) throw WrongFile( "cannot create file " + image );
+        writer.Write( out );
+    }
+
+    // @c path made absolute, so that the image can be checked from any directory
+    static std::string Absolute( const std::string& path )
+    {
+        const bool absolute = ( ! path.empty() && ( path[ 0 ] == '/' || path[ 0 ] == '\\' ) ) ||
+                              ( path.size() > 1 && path[ 1 ] == ':' );
+        if ( absolute ) return path;
+        char buffer[ 4096 ];
+#ifdef WALLAROO_DETAIL_OS_FAMILY_WINDOWS
+        if ( _getcwd( buffer, sizeof( buffer ) ) == NULL ) return path;
+#else
+        if ( getcwd( buffer, sizeof( buffer ) ) == NULL ) return path;
+#endif
+        return std::string( buffer ) + '/' + path;
+    }
+
+    const std::string name;
+    detail::MappedFile file;
+    detail::BinaryImage image;
+
+    // copy ctor and assignment operator disabled
+    BinaryConfiguration( const BinaryConfiguration& );
+    BinaryConfiguration& operator = ( const BinaryConfiguration& );
+};
+
+} // namespace
+
+#endif
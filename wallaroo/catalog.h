@@ -36,10 +36,23 @@
 #include <string>
 #include <typeinfo>
 #include <cassert>
+#include <vector>
+#include <deque>
+#include <utility>
+#include <algorithm>
+#include <cstddef>
+#include <set>
 #include "detail/partshell.h"
+#include "detail/dependency_graph.h"
+#include "detail/concurrent_index.h"
+#include "detail/perfect_hash.h"
+#include "detail/arena.h"
+#include "detail/recipe.h"
+#include "detail/type_index.h"
 #include "cxx0x.h"
 #include "part.h"
 #include "class.h"
+#include "symbol.h"
 
 namespace wallaroo
 {
@@ -61,14 +74,62 @@ class UseExpression;
  *
  * Each item in the catalog is identified by a @c id, with which
  * you can perform a lookup.
+ *
+ * The parts created by the catalog (see Catalog::Create) are allocated
+ * sequentially in a memory arena owned by the catalog, so that they
+ * are close in memory and released all together.
+ *
+ * The catalog can be shared among threads: the lookups never lock
+ * (so they scale with the number of threads and never see a part
+ * half inserted) while the insertions are serialized.
+ *
+ * The parts can also be declared (see Catalog::Declare) instead of created:
+ * a declared part is instantiated, together with the declared parts
+ * reachable through its declared wiring, only when it's looked up for
+ * the first time.
+ *
+ * A catalog can be the child of another catalog (see Catalog::Catalog(const Catalog*)):
+ * the names it doesn't contain are looked up in the parent, so that its
+ * parts can be wired to the parts of the parent. A child catalog is cheap
+ * to build and to destroy, because it only holds its own parts.
  */
 class Catalog
 {
 public:
 
+    /** The function that creates a declared part (see Catalog::Declare).
+    * It receives a catalog and the id of the part, and it must add the part
+    * to that catalog with that id (i.e. with Catalog::Create), then it can
+    * set its attributes. It must not look up other declared parts.
+    */
+    typedef cxx0x::function< void ( Catalog&, const Symbol& ) > Builder;
+
     /** Build an empty catalog.
     */
-    Catalog() {}
+    Catalog() :
+        arena( new detail::Arena ), parent( NULL ), types( this, &Catalog::EnumerateParts ), frozen( NULL ), sealed( false ), cloning( false ), declared( false ), children( 0 )
+    {}
+
+    /** Build an empty child catalog of @c parent: the elements not contained
+    * in this catalog are looked up in @c parent (and in its ancestors).
+    * The child doesn't own the parts of the parent, so the parent must
+    * outlive the child (in debug builds this is detected by an assertion).
+    * A part of the child can have the same name of a part of the parent,
+    * and it hides it.
+    * @param parent The parent catalog (if it's NULL, the catalog has no parent).
+    */
+    explicit Catalog( const Catalog* parent ) :
+        arena( new detail::Arena ), parent( parent ), types( this, &Catalog::EnumerateParts ), frozen( NULL ), sealed( false ), cloning( false ), declared( false ), children( 0 )
+    {
+        if ( parent != NULL ) ++( parent -> children );
+    }
+
+    ~Catalog()
+    {
+        assert( children.load() == 0 ); // the children must be destroyed before
+        if ( parent != NULL ) --( parent -> children );
+        delete frozen.load( cxx0x::memory_order_relaxed );
+    }
 
     /** Look for the element @c id in the catalog. It returns a class that
     * provides conversion operator so that you can write eg:
@@ -83,21 +144,215 @@ public:
     */
     detail::PartShell operator [] ( const std::string& id ) const
     {
-        Parts::const_iterator i = parts.find( id );
-        if ( i == parts.end() ) throw ElementNotFound( id );
-        return detail::PartShell( i -> second );
+        Symbol s;
+        if ( ! Symbol::Find( id, s ) ) throw ElementNotFound( id );
+        return operator[]( s );
+    }
+
+    /** Look for the element @c id in the catalog.
+    * @param id The name of the element
+    * If the element has been declared (see Catalog::Declare) and not
+    * instantiated yet, it's instantiated now. If the catalog doesn't contain
+    * the element, it's looked up in the parent catalog (if any).
+    * @return The element.
+    * @throw ElementNotFound If an element with key @c id cannot be found
+    *                        in the catalog.
+    */
+    detail::PartShell operator [] ( const Symbol& id ) const
+    {
+        const Entry* e = Lookup( id );
+        if ( e != NULL ) return detail::PartShell( e -> part );
+        const cxx0x::shared_ptr< Part > part = Instantiate( id );
+        if ( part ) return detail::PartShell( part );
+        if ( parent != NULL ) return ( *parent )[ id ];
+        throw ElementNotFound( id.Name() );
+    }
+
+    /** A read-only array of the parts assignable to the type @c T (see Catalog::All).
+    * It's a snapshot: the parts added to the catalog afterwards are not included.
+    * The pointers remain valid as long as the catalog exists.
+    */
+    template < class T >
+    class Range
+    {
+    public:
+        typedef T* const* const_iterator;
+        typedef const_iterator iterator;
+        const_iterator begin() const { return items -> empty() ? NULL : &( *items )[ 0 ]; }
+        const_iterator end() const { return begin() + size(); }
+        std::size_t size() const { return items -> size(); }
+        bool empty() const { return items -> empty(); }
+        T* operator [] ( std::size_t i ) const { return ( *items )[ i ]; }
+    private:
+        friend class Catalog;
+        explicit Range( const cxx0x::shared_ptr< const std::vector< T* > >& i ) : items( i ) {}
+        cxx0x::shared_ptr< const std::vector< T* > > items;
+    };
+
+    /** Return all the parts of the catalog assignable to the type @c T
+    * (its class, a base class or an interface), in the order they've been added.
+    * The first call for a type visits the parts once (with a dynamic_cast
+    * per class, not per part) and builds an index that the catalog keeps
+    * up to date, so the following calls don't visit them at all.
+    * No index is kept for the types never requested.
+    * The parts declared and not instantiated yet, and the parts of the parent
+    * catalog, are not included.
+    * @return The parts assignable to @c T.
+    */
+    template < class T >
+    Range< T > All() const
+    {
+        cxx0x::lock_guard< cxx0x::mutex > lock( mutex );
+        const cxx0x::shared_ptr< const detail::TypeIndex::Matches< T > > matches = types.All< T >();
+        return Range< T >( cxx0x::shared_ptr< const std::vector< T* > >( matches, &matches -> pointers ) );
     }
 
     /** Add an element to the catalog
     * @param id The name of the element to add
-    * @param dev The element to add (its class must derive from wallaroo::Part)
+    * @param dev The element to add (its class must derive from wallaroo::Part).
+    *        With WALLAROO_INTRUSIVE_PARTS, a part allocated elsewhere (i.e., with
+    *        make_shared) lives until both @c dev and the collaborators linked to it are gone.
     * @throw DuplicatedElement If a part with the name @c id is already in the catalog
+    * @throw FrozenCatalog If the catalog has been frozen
     */
     void Add( const std::string& id, const cxx0x::shared_ptr< Part >& dev )
     {
-        std::pair< Parts::iterator, bool > result = 
-            parts.insert( std::make_pair( id, dev ) );
-        if ( ! result.second ) throw DuplicatedElement( id );
+        Add( Symbol( id ), dev );
+    }
+
+    /** Add an element to the catalog
+    * @param id The name of the element to add
+    * @param dev The element to add (its class must derive from wallaroo::Part).
+    *        With WALLAROO_INTRUSIVE_PARTS, a part allocated elsewhere (i.e., with
+    *        make_shared) lives until both @c dev and the collaborators linked to it are gone.
+    * @throw DuplicatedElement If a part with the name @c id is already in the catalog
+    * @throw FrozenCatalog If the catalog has been frozen
+    */
+    void Add( const Symbol& id, const cxx0x::shared_ptr< Part >& dev )
+    {
+        Add( id, dev, Recipe() );
+    }
+
+    /** Declare a part, without creating it: @c build will be called to
+    * create it the first time it's looked up (see Catalog::operator[]),
+    * either directly or because a part wired to it has been looked up.
+    * Until then, the part is not contained in the catalog (i.e. Catalog::Init
+    * and Catalog::IsWiringOk don't consider it).
+    * @param id The name of the part to declare
+    * @param build The function that creates the part (see Catalog::Builder)
+    * @throw DuplicatedElement If a part with the name @c id is already in the catalog
+    *                          or has already been declared
+    * @throw FrozenCatalog If the catalog has been frozen
+    */
+    void Declare( const Symbol& id, const Builder& build )
+    {
+        cxx0x::lock_guard< cxx0x::mutex > lock( declarationsMutex );
+        if ( IsFrozen() ) throw FrozenCatalog( id.Name() );
+        if ( Lookup( id ) != NULL || declarations.find( id ) != declarations.end() )
+            throw DuplicatedElement( id.Name() );
+        declarations.insert( std::make_pair( id, Declaration( build ) ) );
+        declared.store( true, cxx0x::memory_order_release );
+    }
+
+    /** Declare a part, without creating it (see Catalog::Declare(const Symbol&,const Builder&)).
+    * @param id The name of the part to declare
+    * @param build The function that creates the part (see Catalog::Builder)
+    * @throw DuplicatedElement If a part with the name @c id is already in the catalog
+    *                          or has already been declared
+    * @throw FrozenCatalog If the catalog has been frozen
+    */
+    void Declare( const std::string& id, const Builder& build )
+    {
+        Declare( Symbol( id ), build );
+    }
+
+    /** Declare that the collaborator @c collaborator of the part @c source
+    * must be wired to the part @c dest.
+    * If @c source has been declared and not instantiated yet, the wiring is
+    * performed (and @c dest instantiated) when @c source is instantiated.
+    * Otherwise, it's performed immediately.
+    * @param source The name of the part whose collaborator must be wired
+    * @param collaborator The name of the collaborator of @c source
+    * @param dest The name of the part to wire to the collaborator
+    * @throw ElementNotFound If @c source or @c dest cannot be found in the catalog
+    *                        (when the wiring is performed).
+    */
+    void DeclareWiring( const Symbol& source, const Symbol& collaborator, const Symbol& dest )
+    {
+        {
+            cxx0x::lock_guard< cxx0x::mutex > lock( declarationsMutex );
+            Declarations::iterator i = declarations.find( source );
+            if ( i != declarations.end() )
+            {
+                i -> second.wiring.push_back( std::make_pair( collaborator, dest ) );
+                return;
+            }
+        }
+        operator[]( source ).Wire( collaborator, operator[]( dest ) );
+    }
+
+    /** Return true if the catalog contains the element @c id, that is if it
+    * has been added or declared (see Catalog::Declare) in this catalog or
+    * in the parent catalog (if any). A declared part is not instantiated.
+    * @param id The name of the element
+    */
+    bool Contains( const Symbol& id ) const
+    {
+        if ( Lookup( id ) != NULL ) return true;
+        if ( declared.load( cxx0x::memory_order_acquire ) )
+        {
+            cxx0x::lock_guard< cxx0x::mutex > lock( declarationsMutex );
+            if ( declarations.find( id ) != declarations.end() ) return true;
+        }
+        // it could have been instantiated in the meantime
+        // (the flag is cleared after the insertion)
+        if ( Lookup( id ) != NULL ) return true;
+        return parent != NULL && parent -> Contains( id );
+    }
+
+    /** Return true if the catalog contains the element @c id (see Catalog::Contains( const Symbol& )).
+    * @param id The name of the element
+    */
+    bool Contains( const std::string& id ) const
+    {
+        Symbol s;
+        return Symbol::Find( id, s ) && Contains( s );
+    }
+
+    /** Mark the part @c id as shared by all the replicas of the catalog (see Replicas),
+    * so that it's never replicated. The part can be added or declared later.
+    * @param id The name of the part
+    */
+    void Share( const Symbol& id )
+    {
+        cxx0x::lock_guard< cxx0x::mutex > lock( mutex );
+        shared.insert( id );
+    }
+
+    /** Return true if the part @c id has been marked as shared (see Catalog::Share).
+    * @param id The name of the part
+    */
+    bool IsShared( const Symbol& id ) const
+    {
+        cxx0x::lock_guard< cxx0x::mutex > lock( mutex );
+        return shared.find( id ) != shared.end();
+    }
+
+    /** Record, for each part created from now on (see Catalog::Create), its
+    * class and the parameters of its constructor, so that the part can be
+    * cloned (see Prototype and Replicas). It's disabled by default, because
+    * the record costs an allocation for each part created.
+    */
+    void EnableCloning()
+    {
+        cloning.store( true );
+    }
+
+    /** Return true if the catalog records how its parts are created (see Catalog::EnableCloning).
+    */
+    bool IsCloningEnabled() const
+    {
+        return cloning.load();
     }
 
     /** Instantiate a class having a 2 parameters constructor and add it to the catalog
@@ -108,15 +363,37 @@ public:
     * @return The element created.
     * @throw DuplicatedElement If an element with the name @c id is already in the catalog
     * @throw ElementNotFound If @c className class has not been registered
+    * @throw FrozenCatalog If the catalog has been frozen
     */
     template < class P1, class P2 >
     detail::PartShell Create( const std::string& id, const std::string& className, const P1& p1, const P2& p2 )
     {
         typedef Class< P1, P2 > C;
         C c = C::ForName( className );
-        cxx0x::shared_ptr< Part > obj = c.NewInstance( p1, p2 );
+        cxx0x::shared_ptr< Part > obj = c.NewInstance( arena, p1, p2 );
         if ( obj.get() == NULL ) throw ElementNotFound( className );
-        Add( id, obj );
+        Add( Symbol( id ), obj, Record( c, p1, p2 ) );
+        return detail::PartShell( obj );
+    }
+
+    /** Instantiate a class having a 2 parameters constructor and add it to the catalog
+    * @param id The name of the element to create and add
+    * @param className The name of the class to instantiate (must derive from wallaroo::Part)
+    * @param p1 The first parameter of the class constructor
+    * @param p2 The second parameter of the class constructor
+    * @return The element created.
+    * @throw DuplicatedElement If an element with the name @c id is already in the catalog
+    * @throw ElementNotFound If @c className class has not been registered
+    * @throw FrozenCatalog If the catalog has been frozen
+    */
+    template < class P1, class P2 >
+    detail::PartShell Create( const Symbol& id, const Symbol& className, const P1& p1, const P2& p2 )
+    {
+        typedef Class< P1, P2 > C;
+        C c = C::ForName( className );
+        cxx0x::shared_ptr< Part > obj = c.NewInstance( arena, p1, p2 );
+        if ( obj.get() == NULL ) throw ElementNotFound( className.Name() );
+        Add( id, obj, Record( c, p1, p2 ) );
         return detail::PartShell( obj );
     }
 
@@ -127,15 +404,36 @@ public:
     * @return The element created.
     * @throw DuplicatedElement If an element with the name @c id is already in the catalog
     * @throw ElementNotFound If @c className class has not been registered
+    * @throw FrozenCatalog If the catalog has been frozen
     */
     template < class P >
     detail::PartShell Create( const std::string& id, const std::string& className, const P& p )
     {
         typedef Class< P, void > C;
         C c = C::ForName( className );
-        cxx0x::shared_ptr< Part > obj = c.NewInstance( p );
+        cxx0x::shared_ptr< Part > obj = c.NewInstance( arena, p );
         if ( obj.get() == NULL ) throw ElementNotFound( className );
-        Add( id, obj );
+        Add( Symbol( id ), obj, Record( c, p ) );
+        return detail::PartShell( obj );
+    }
+
+    /** Instantiate a class having a 1 parameters constructor and add it to the catalog
+    * @param id The name of the element to create and add
+    * @param className The name of the class to instantiate (must derive from wallaroo::Part)
+    * @param p The parameter of the class constructor
+    * @return The element created.
+    * @throw DuplicatedElement If an element with the name @c id is already in the catalog
+    * @throw ElementNotFound If @c className class has not been registered
+    * @throw FrozenCatalog If the catalog has been frozen
+    */
+    template < class P >
+    detail::PartShell Create( const Symbol& id, const Symbol& className, const P& p )
+    {
+        typedef Class< P, void > C;
+        C c = C::ForName( className );
+        cxx0x::shared_ptr< Part > obj = c.NewInstance( arena, p );
+        if ( obj.get() == NULL ) throw ElementNotFound( className.Name() );
+        Add( id, obj, Record( c, p ) );
         return detail::PartShell( obj );
     }
 
@@ -145,14 +443,33 @@ public:
     * @return The element created.
     * @throw DuplicatedElement If an element with the name @c id is already in the catalog
     * @throw ElementNotFound If @c className class has not been registered
+    * @throw FrozenCatalog If the catalog has been frozen
     */
     detail::PartShell Create( const std::string& id, const std::string& className )
     {
         typedef Class< void, void > C;
         C c = C::ForName( className );
-        cxx0x::shared_ptr< Part > obj = c.NewInstance();
+        cxx0x::shared_ptr< Part > obj = c.NewInstance( arena );
         if ( obj.get() == NULL ) throw ElementNotFound( className );
-        Add( id, obj );
+        Add( Symbol( id ), obj, Record( c ) );
+        return detail::PartShell( obj );
+    }
+
+    /** Instantiate a class having a default constructor and add it to the catalog
+    * @param id The name of the element to create and add
+    * @param className The name of the class to instantiate (must derive from wallaroo::Part)
+    * @return The element created.
+    * @throw DuplicatedElement If an element with the name @c id is already in the catalog
+    * @throw ElementNotFound If @c className class has not been registered
+    * @throw FrozenCatalog If the catalog has been frozen
+    */
+    detail::PartShell Create( const Symbol& id, const Symbol& className )
+    {
+        typedef Class< void, void > C;
+        C c = C::ForName( className );
+        cxx0x::shared_ptr< Part > obj = c.NewInstance( arena );
+        if ( obj.get() == NULL ) throw ElementNotFound( className.Name() );
+        Add( id, obj, Record( c ) );
         return detail::PartShell( obj );
     }
 
@@ -175,17 +492,200 @@ public:
         if ( !wrongPart.empty() ) throw WiringError( wrongPart );
     }
 
+    /** Wire by type the collaborators left unwired: a collaborator is linked
+     *  to the only part of the catalog assignable to its type (if any), and
+     *  a collection collaborator to all of them. A part is never linked to
+     *  its own collaborators, and the collaborators already wired are not changed.
+     *  The candidates come from the type index of the catalog (see Catalog::All),
+     *  so the time taken is linear in the number of collaborators.
+     *  The parts of the parent catalog and the parts declared and not
+     *  instantiated yet are not considered.
+     *  @throw AmbiguousWiring If an unwired collaborator could be linked to more
+     *         than one part (the collaborators considered before remain wired).
+     */
+    void Autowire()
+    {
+        cxx0x::lock_guard< cxx0x::mutex > lock( mutex );
+        for ( Parts::const_iterator i = parts.begin(); i != parts.end(); ++i )
+        {
+            Symbol collaborator;
+            std::vector< const Part* > candidates;
+            if ( ! i -> part -> Autowire( types, collaborator, candidates ) )
+            {
+                std::vector< std::string > names;
+                for ( std::vector< const Part* >::const_iterator c = candidates.begin(); c != candidates.end(); ++c )
+                    for ( Parts::const_iterator p = parts.begin(); p != parts.end(); ++p )
+                        if ( p -> part.get() == *c ) names.push_back( p -> id.Name() );
+                throw AmbiguousWiring( i -> id.Name(), collaborator.Name(), names );
+            }
+        }
+    }
+
     /** This method calls Part::Init on every Part contained.
      *  You can call it in the setup phase of your application to perform
      *  the initialization required by each part before the run.
      *  Ideally you should call it *after* wiring and attributes setting, so that
      *  your objects already have dependencies and the right attribute values.
+     *  The parts are initialized after the parts linked to their collaborators.
+     *  If the collaborators of some parts form a cycle, the cycle is broken
+     *  at the first of its parts in name order: that part is initialized
+     *  before the parts of the cycle it depends on.
      *  This method rethrows every exception thrown by each Part::Init.
      */
     void Init()
     {
+        const detail::DependencyGraph::Parts sorted = SortedParts();
+        detail::DependencyGraph( sorted ).Forward( &Part::Init );
+    }
+
+    /** This method calls Part::Init on every Part contained, using a pool
+     *  of @c threads threads.
+     *  The parts are initialized after the parts linked to their collaborators,
+     *  and the parts that don't depend on each other are initialized concurrently.
+     *  When a Part::Init throws an exception, the parts depending on it are
+     *  not initialized, while the others are.
+     *  Unlike Catalog::Init(), the cycles are not accepted.
+     *  @param threads The number of threads of the pool.
+     *  @throw CyclicDependencyError If the collaborators of some parts form a cycle
+     *         (in this case no part is initialized).
+     *  @throw InitError If one or more Part::Init throw an exception. It contains
+     *         the names of the parts and the messages of all the exceptions,
+     *         and the names of the parts not initialized because of them
+     *         (with the message "not initialized").
+     */
+    void Init( std::size_t threads )
+    {
+        const detail::DependencyGraph::Parts sorted = SortedParts();
+        const PartsError::Failures failures = detail::DependencyGraph( sorted ).Forward( &Part::Init, threads, "not initialized" );
+        if ( ! failures.empty() ) throw InitError( failures );
+    }
+
+    /** This method calls Part::Start on every Part contained.
+     *  You should call it after Catalog::Init, to launch the activities of the parts.
+     *  The parts are started after the parts linked to their collaborators
+     *  (the cycles are broken as in Catalog::Init()).
+     *  This method rethrows every exception thrown by each Part::Start.
+     */
+    void Start()
+    {
+        const detail::DependencyGraph::Parts sorted = SortedParts();
+        detail::DependencyGraph( sorted ).Forward( &Part::Start );
+    }
+
+    /** This method calls Part::Start on every Part contained, using a pool
+     *  of @c threads threads.
+     *  The parts are started after the parts linked to their collaborators,
+     *  and the parts that don't depend on each other are started concurrently.
+     *  When a Part::Start throws an exception, the parts depending on it are
+     *  not started, while the others are.
+     *  Unlike Catalog::Start(), the cycles are not accepted.
+     *  @param threads The number of threads of the pool.
+     *  @throw CyclicDependencyError If the collaborators of some parts form a cycle
+     *         (in this case no part is started).
+     *  @throw InitError If one or more Part::Start throw an exception. It contains
+     *         the names of the parts and the messages of all the exceptions,
+     *         and the names of the parts not started because of them
+     *         (with the message "not started").
+     */
+    void Start( std::size_t threads )
+    {
+        const detail::DependencyGraph::Parts sorted = SortedParts();
+        const PartsError::Failures failures = detail::DependencyGraph( sorted ).Forward( &Part::Start, threads, "not started" );
+        if ( ! failures.empty() ) throw InitError( failures );
+    }
+
+    /** This method calls Part::Stop on every Part contained.
+     *  You can call it in the shutdown phase of your application, before
+     *  the destruction of the catalog.
+     *  The parts are stopped before the parts linked to their collaborators
+     *  (i.e., in the reverse order of Catalog::Init), so that a part can
+     *  still use its collaborators while it's stopping.
+     *  If the collaborators of some parts form a cycle, the cycle is broken
+     *  at the first of its parts in name order.
+     *  This method rethrows every exception thrown by each Part::Stop.
+     */
+    void Stop()
+    {
+        const detail::DependencyGraph::Parts sorted = SortedParts();
+        detail::DependencyGraph( sorted ).Backward( &Part::Stop );
+    }
+
+    /** This method calls Part::Stop on every Part contained, running at
+     *  most @c threads Part::Stop concurrently.
+     *  The parts are stopped before the parts linked to their collaborators,
+     *  and the parts that don't depend on each other are stopped concurrently.
+     *  Each Part::Stop runs on its own thread: if it doesn't return within
+     *  @c timeout milliseconds, the part is considered stopped and its thread
+     *  is abandoned. The abandoned thread keeps a reference to the part and
+     *  to all the parts reachable through its collaborators, so that they're
+     *  destroyed only when Part::Stop eventually returns: the thread can
+     *  outlive the catalog, and the collaborators remain valid (even when
+     *  pinned by Catalog::Seal).
+     *  A part that throws or times out doesn't prevent the other parts
+     *  from being stopped, so this method returns in a bounded time.
+     *  Unlike Catalog::Stop(), the cycles are not accepted.
+     *  @param threads The maximum number of Part::Stop running at the same time.
+     *  @param timeout The maximum duration of each Part::Stop, in milliseconds.
+     *  @throw CyclicDependencyError If the collaborators of some parts form a cycle
+     *         (in this case no part is stopped).
+     *  @throw StopError If one or more Part::Stop throw an exception or time out.
+     *         It contains the names of the parts and the messages of all the exceptions.
+     */
+    void Stop( std::size_t threads, unsigned long timeout )
+    {
+        const detail::DependencyGraph::Parts sorted = SortedParts();
+        const PartsError::Failures failures = detail::DependencyGraph( sorted ).Backward( &Part::Stop, threads, timeout );
+        if ( ! failures.empty() ) throw StopError( failures );
+    }
+
+    /** Seal the catalog: from now on, every collaborator of the parts
+     *  contained caches a plain pointer to the part it's linked to, so that
+     *  the access through Collaborator::operator-> doesn't need to lock a
+     *  weak pointer anymore.
+     *  The catalog guarantees the lifetime of its parts, so you must not
+     *  use the parts after the catalog has been destroyed (in debug builds
+     *  this is detected by an assertion).
+     *  You can still add and wire parts after sealing: the new
+     *  collaborators will be pinned as well.
+     */
+    void Seal()
+    {
+        cxx0x::lock_guard< cxx0x::mutex > lock( mutex );
+        for ( Parts::const_iterator i = parts.begin(); i != parts.end(); ++i )
+            i -> part -> Pin();
+        sealed = true;
+    }
+
+    /** Freeze the catalog: the set of its parts cannot change anymore,
+     *  so its index is rebuilt as a minimal perfect hash table over a
+     *  contiguous array, and the lookups become faster (no probing and
+     *  no collision chains).
+     *  Call it when the creation phase is over: from now on, Catalog::Add
+     *  and Catalog::Create throw FrozenCatalog. Wiring, attributes and
+     *  the lifecycle methods are not affected.
+     *  The parts declared (see Catalog::Declare) and not instantiated yet
+     *  are discarded.
+     *  Calling Freeze again has no effect.
+     */
+    void Freeze()
+    {
+        cxx0x::lock_guard< cxx0x::mutex > declarationsLock( declarationsMutex );
+        cxx0x::lock_guard< cxx0x::mutex > lock( mutex );
+        if ( frozen.load( cxx0x::memory_order_relaxed ) != NULL ) return;
+        declarations.clear();
+        declared.store( false, cxx0x::memory_order_release );
+        Frozen::Items items;
+        items.reserve( parts.size() );
         for ( Parts::const_iterator i = parts.begin(); i != parts.end(); ++i )
-            i -> second -> Init();
+            items.push_back( std::make_pair( i -> id.Id(), &*i ) );
+        frozen.store( new Frozen( items ), cxx0x::memory_order_release );
+    }
+
+    /** Return true if the catalog has been frozen (see Catalog::Freeze).
+     */
+    bool IsFrozen() const
+    {
+        return frozen.load( cxx0x::memory_order_acquire ) != NULL;
     }
 
 private:
@@ -194,25 +694,258 @@ private:
     Catalog( const Catalog& );
     Catalog& operator = ( const Catalog& );
 
+    // the parts contained, sorted by name
+    detail::DependencyGraph::Parts SortedParts() const
+    {
+        cxx0x::lock_guard< cxx0x::mutex > lock( mutex );
+        detail::DependencyGraph::Parts sorted;
+        sorted.reserve( parts.size() );
+        for ( Parts::const_iterator i = parts.begin(); i != parts.end(); ++i )
+            sorted.push_back( std::make_pair( i -> id.Name(), i -> part ) );
+        std::sort( sorted.begin(), sorted.end() );
+        return sorted;
+    }
+
     // returns the name of the first parts with wrong multiplicity
     // or the empty string if the test has success
     std::string FindWrongMultiplicity() const
     {
+        cxx0x::lock_guard< cxx0x::mutex > lock( mutex );
         for( Parts::const_iterator i = parts.begin(); i != parts.end(); ++i )
         {
-            if ( ! i -> second -> MultiplicitiesOk() )
-                return( i -> first );
+            if ( ! i -> part -> MultiplicitiesOk() )
+                return( i -> id.Name() );
         }
         return std::string();
     }
 
-    typedef cxx0x::unordered_map< std::string, cxx0x::shared_ptr< Part > > Parts;
+    typedef cxx0x::shared_ptr< const detail::Recipe > Recipe;
+    struct Entry
+    {
+        Entry( const Symbol& i, const cxx0x::shared_ptr< Part >& p, const Recipe& r ) : id( i ), part( p ), recipe( r ) {}
+        const Symbol id;
+        const cxx0x::shared_ptr< Part > part;
+        const Recipe recipe; // empty if the part has been added from outside, or created with cloning disabled
+    };
+    struct SameId
+    {
+        explicit SameId( const Symbol& i ) : id( i ) {}
+        bool operator()( const Entry& e ) const { return e.id == id; }
+        const Symbol id;
+    };
+    typedef std::deque< Entry > Parts; // a deque does not move its elements
+
+    typedef detail::PerfectHash< const Entry* > Frozen;
+
+    // a part declared and not instantiated yet
+    struct Declaration
+    {
+        typedef std::vector< std::pair< Symbol, Symbol > > Wiring; // collaborator, dest
+        explicit Declaration( const Builder& b ) : build( b ) {}
+        Builder build;
+        Wiring wiring;
+    };
+    typedef cxx0x::unordered_map< Symbol, Declaration, Symbol::Hash > Declarations;
+
+    // a catalog sharing the arena of another one (used to instantiate the declared parts)
+    explicit Catalog( const cxx0x::shared_ptr< detail::Arena >& a ) :
+        arena( a ), parent( NULL ), types( this, &Catalog::EnumerateParts ), frozen( NULL ), sealed( false ), cloning( false ), declared( false ), children( 0 )
+    {}
+
+    // the entry of the part @c id, or NULL if it's not contained
+    const Entry* Lookup( const Symbol& id ) const
+    {
+        const Frozen* f = frozen.load( cxx0x::memory_order_acquire );
+        if ( f != NULL )
+        {
+            const Entry* const* e = f -> Find( id.Id() );
+            return ( e == NULL ? NULL : *e );
+        }
+        return index.Find( Symbol::Hash()( id ), SameId( id ) );
+    }
+
+    // the parts of the catalog @c owner (see detail::TypeIndex)
+    static void EnumerateParts( const void* owner, std::vector< cxx0x::shared_ptr< Part > >& result )
+    {
+        const Parts& parts = static_cast< const Catalog* >( owner ) -> parts;
+        for ( Parts::const_iterator i = parts.begin(); i != parts.end(); ++i )
+            result.push_back( i -> part );
+    }
+
+    // the entry of the part @c id in this catalog or in the nearest ancestor
+    // containing it, or NULL if no catalog of the chain contains it.
+    // If the part has been declared, it's instantiated with its recipe.
+    const Entry* Resolve( const Symbol& id ) const
+    {
+        for ( const Catalog* c = this; c != NULL; c = c -> parent )
+        {
+            const Entry* e = c -> Lookup( id );
+            if ( e == NULL && c -> Instantiate( id, true ) ) e = c -> Lookup( id );
+            if ( e != NULL ) return e;
+        }
+        return NULL;
+    }
+
+    // the recipe of a part created with the class @c c, if the catalog records them
+    template < class P1, class P2 >
+    Recipe Record( const Class< P1, P2 >& c, const P1& p1, const P2& p2 ) const
+    {
+        if ( ! cloning.load( cxx0x::memory_order_relaxed ) ) return Recipe();
+        return Recipe( new detail::ClassRecipe< P1, P2 >( c, p1, p2 ) );
+    }
+    template < class P >
+    Recipe Record( const Class< P, void >& c, const P& p ) const
+    {
+        if ( ! cloning.load( cxx0x::memory_order_relaxed ) ) return Recipe();
+        return Recipe( new detail::ClassRecipe< P, void >( c, p ) );
+    }
+    Recipe Record( const Class< void, void >& c ) const
+    {
+        if ( ! cloning.load( cxx0x::memory_order_relaxed ) ) return Recipe();
+        return Recipe( new detail::ClassRecipe< void, void >( c ) );
+    }
+
+    // add a part, with the way it's been created (if known)
+    // NOTE: with WALLAROO_INTRUSIVE_PARTS, a part not created by wallaroo
+    //       (i.e., with make_shared) is adopted (see detail::Adopt).
+    void Add( const Symbol& id, const cxx0x::shared_ptr< Part >& dev, const Recipe& recipe )
+    {
+        cxx0x::lock_guard< cxx0x::mutex > lock( declarationsMutex );
+        if ( declarations.find( id ) != declarations.end() ) throw DuplicatedElement( id.Name() );
+        Insert( id, detail::Adopt( dev ), recipe );
+    }
+
+    // add a part (the caller checks that it has not been declared)
+    void Insert( const Symbol& id, const cxx0x::shared_ptr< Part >& dev, const Recipe& recipe )
+    {
+        cxx0x::lock_guard< cxx0x::mutex > lock( mutex );
+
+        if ( frozen.load( cxx0x::memory_order_relaxed ) != NULL ) throw FrozenCatalog( id.Name() );
+        const std::size_t hash = Symbol::Hash()( id );
+        if ( index.Find( hash, SameId( id ) ) != NULL ) throw DuplicatedElement( id.Name() );
+        if ( sealed ) dev -> Pin();
+        types.Add( dev );
+        try
+        {
+            parts.push_back( Entry( id, dev, recipe ) );
+        }
+        catch ( ... )
+        {
+            types.RemoveLast( dev.get() );
+            throw;
+        }
+        try
+        {
+            index.Insert( hash, &parts.back() );
+        }
+        catch ( ... )
+        {
+            parts.pop_back();
+            types.RemoveLast( dev.get() );
+            throw;
+        }
+    }
+
+    // Instantiate the declared part @c id together with the declared parts
+    // reachable from it through the declared wiring, and return it (or an
+    // empty pointer if @c id has not been declared). If @c recipes is true,
+    // the recipes of the parts are recorded even if cloning is not enabled.
+    // The parts are created and wired in a staging catalog, and then added
+    // to this one: the other threads never see a part before it's wired,
+    // and if something fails the declarations are left untouched.
+    cxx0x::shared_ptr< Part > Instantiate( const Symbol& id, bool recipes = false ) const
+    {
+        // the lookups of the parts of the parent don't lock if no declaration is pending
+        if ( ! declared.load( cxx0x::memory_order_acquire ) ) return Instantiated( id );
+        cxx0x::lock_guard< cxx0x::mutex > lock( declarationsMutex );
+        if ( declarations.find( id ) == declarations.end() ) return Instantiated( id );
+
+        std::vector< Declarations::iterator > closure;
+        std::set< Symbol > visited;
+        std::vector< Symbol > toVisit( 1, id );
+        while ( ! toVisit.empty() )
+        {
+            const Symbol s = toVisit.back();
+            toVisit.pop_back();
+            if ( ! visited.insert( s ).second ) continue;
+            const Declarations::iterator d = declarations.find( s );
+            if ( d == declarations.end() ) continue; // already instantiated (or missing)
+            closure.push_back( d );
+            const Declaration::Wiring& wiring = d -> second.wiring;
+            for ( Declaration::Wiring::const_iterator w = wiring.begin(); w != wiring.end(); ++w )
+                toVisit.push_back( w -> second );
+        }
+
+        Catalog staging( arena );
+        staging.cloning.store( recipes || cloning.load(), cxx0x::memory_order_relaxed );
+        for ( std::size_t i = 0; i < closure.size(); ++i )
+            closure[ i ] -> second.build( staging, closure[ i ] -> first );
+        for ( std::size_t i = 0; i < closure.size(); ++i )
+        {
+            const Entry* source = staging.Lookup( closure[ i ] -> first );
+            if ( source == NULL ) throw ElementNotFound( closure[ i ] -> first.Name() );
+            const Declaration::Wiring& wiring = closure[ i ] -> second.wiring;
+            for ( Declaration::Wiring::const_iterator w = wiring.begin(); w != wiring.end(); ++w )
+            {
+                const Entry* dest = staging.Lookup( w -> second );
+                if ( dest == NULL ) dest = Lookup( w -> second );
+                if ( dest != NULL )
+                    source -> part -> Wire( w -> first, dest -> part );
+                else if ( parent != NULL )
+                    source -> part -> Wire( w -> first, ( *parent )[ w -> second ] );
+                else
+                    throw ElementNotFound( w -> second.Name() );
+            }
+        }
+
+        // instantiating a declared part doesn't change the content of the
+        // catalog seen from outside, so this method is const
+        Catalog& self = const_cast< Catalog& >( *this );
+        for ( Parts::const_iterator p = staging.parts.begin(); p != staging.parts.end(); ++p )
+            self.Insert( p -> id, p -> part, p -> recipe );
+        for ( std::size_t i = 0; i < closure.size(); ++i )
+            declarations.erase( closure[ i ] );
+        if ( declarations.empty() ) declared.store( false, cxx0x::memory_order_release );
+        return Lookup( id ) -> part;
+    }
+
+    // the part @c id, if it has been instantiated by another thread in the
+    // meantime (the flag declared is cleared after the insertion)
+    cxx0x::shared_ptr< Part > Instantiated( const Symbol& id ) const
+    {
+        const Entry* e = Lookup( id );
+        return ( e == NULL ? cxx0x::shared_ptr< Part >() : e -> part );
+    }
+
+    // the memory of the parts created by the catalog (the arena is released
+    // when both the catalog and those parts have been destroyed)
+    const cxx0x::shared_ptr< detail::Arena > arena;
+    const Catalog* const parent; // not owned
     Parts parts;
+    // the lookups read the index (or the frozen index, once built) without
+    // locking, while the insertions (and the iterations over the parts)
+    // are serialized by the mutex.
+    detail::ConcurrentIndex< Entry > index;
+    detail::TypeIndex types; // the parts by type, built on request (protected by the mutex)
+    cxx0x::atomic< const Frozen* > frozen;
+    mutable cxx0x::mutex mutex;
+    bool sealed;
+    cxx0x::atomic< bool > cloning; // true if the recipes of the parts are recorded
+    std::set< Symbol > shared; // the parts not to replicate (see Replicas)
+    // the declared parts, protected by their mutex (that is always
+    // locked before the other one)
+    mutable Declarations declarations;
+    mutable cxx0x::mutex declarationsMutex;
+    mutable cxx0x::atomic< bool > declared; // true while some declared part has not been instantiated yet
+    mutable cxx0x::atomic< std::size_t > children; // the number of child catalogs alive
 
     friend class Context;
+    friend class Prototype;
+    friend class Replicas;
     friend class UseAsExpression;
     friend class SetExpression;
     friend UseExpression use( const std::string& destClass );
+    friend UseExpression use( const Symbol& destClass );
     friend bool IsWiringOk();
     friend void CheckWiring();
 
@@ -230,7 +963,7 @@ private:
 class UseAsExpression
 {
 public:
-    UseAsExpression( detail::PartShell& _destClass, const std::string& _attribute ) :
+    UseAsExpression( detail::PartShell& _destClass, const Symbol& _attribute ) :
       destClass( _destClass ),
       attribute( _attribute )
     {
@@ -248,9 +981,17 @@ public:
         if ( ! current ) throw CatalogNotSpecified();
         of( ( *current )[ srcClass ] );
     }
+    // throw CatalogNotSpecified if the current catalog has not been selected with wallaroo_within
+    void of ( const Symbol& srcClass )
+    {
+        // default container case
+        Catalog* current = Catalog::Current();
+        if ( ! current ) throw CatalogNotSpecified();
+        of( ( *current )[ srcClass ] );
+    }
 private:
     const detail::PartShell destClass;
-    const std::string attribute;
+    const Symbol attribute;
 };
 
 // This is a helper class that provides the result of the use() function
@@ -263,6 +1004,10 @@ public:
     {
     }
     UseAsExpression as( const std::string& attribute )
+    {
+        return UseAsExpression( destClass, Symbol( attribute ) );
+    }
+    UseAsExpression as( const Symbol& attribute )
     {
         return UseAsExpression( destClass, attribute );
     }
@@ -293,13 +1038,27 @@ inline UseExpression use( const std::string& destClass )
     return use( ( *current )[ destClass ] );
 }
 
+/**
+ * This function provides the "use" part in the syntax @c use( part1 ).as( collaborator ).of( part2 )
+ * where the names are Symbol objects.
+ * @throw CatalogNotSpecified if the current catalog has not been selected including
+ * this function in a wallaroo_within section
+ */
+inline UseExpression use( const Symbol& destClass )
+{
+    // default container case
+    Catalog* current = Catalog::Current();
+    if ( ! current ) throw CatalogNotSpecified();
+    return use( ( *current )[ destClass ] );
+}
+
 
 // This is a helper class that provides the result of the set_attribute().of() function
 // useful to concatenate set_attribute().of() with to().
 class SetOfExpression
 {
 public:
-    SetOfExpression( const detail::PartShell& _part, const std::string& _attribute ) :
+    SetOfExpression( const detail::PartShell& _part, const Symbol& _attribute ) :
         part( _part ), attribute( _attribute ) {}
     template < typename T >
     void to( const T& value )
@@ -307,9 +1066,14 @@ public:
         // perform the final assignment:
         part.SetAttribute( attribute, value );
     }
+    // a C string literal is assigned as string representation
+    void to( const char* value )
+    {
+        part.SetAttribute( attribute, StringView( value ) );
+    }
 private:
     const detail::PartShell part;
-    const std::string attribute;
+    const Symbol attribute;
 };
 
 // This is a helper class that provides the result of the set_attribute() function
@@ -317,7 +1081,7 @@ private:
 class SetExpression
 {
 public:
-    explicit SetExpression( const std::string& att ) : attribute( att ) {}
+    explicit SetExpression( const Symbol& att ) : attribute( att ) {}
     SetOfExpression of( const detail::PartShell& part ) { return SetOfExpression( part, attribute ); }
     // throw CatalogNotSpecified if the current catalog has not been selected including
     // this function in a wallaroo_within section
@@ -328,8 +1092,17 @@ public:
         if ( !current ) throw CatalogNotSpecified( );
         return SetOfExpression( ( *current )[ part ], attribute );
     }
+    // throw CatalogNotSpecified if the current catalog has not been selected including
+    // this function in a wallaroo_within section
+    SetOfExpression of( const Symbol& part )
+    {
+        // default container case
+        Catalog* current = Catalog::Current( );
+        if ( !current ) throw CatalogNotSpecified( );
+        return SetOfExpression( ( *current )[ part ], attribute );
+    }
 private:
-    const std::string attribute;
+    const Symbol attribute;
 };
 
 /**
@@ -337,7 +1110,15 @@ private:
 * @throw CatalogNotSpecified if the current catalog has not been selected including
 * this function in a wallaroo_within section
 */
-inline SetExpression set_attribute( const std::string& attribute ) { return SetExpression( attribute ); }
+inline SetExpression set_attribute( const std::string& attribute ) { return SetExpression( Symbol( attribute ) ); }
+
+/**
+* This function provides the "set_attribute" part in the syntax @c set_attribute( attribute ).of( part ).to( value )
+* where the names are Symbol objects.
+* @throw CatalogNotSpecified if the current catalog has not been selected including
+* this function in a wallaroo_within section
+*/
+inline SetExpression set_attribute( const Symbol& attribute ) { return SetExpression( attribute ); }
 
 
 // Helper class that changes the current catalog on the ctor and
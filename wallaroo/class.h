@@ -35,8 +35,10 @@
 
 #include <string>
 #include "detail/factory.h"
+#include "detail/arena.h"
 #include "cxx0x.h"
 #include "part.h"
+#include "symbol.h"
 
 namespace wallaroo
 {
@@ -57,6 +59,7 @@ class Class
 
         typedef cxx0x::shared_ptr< Part > Ptr;
         typedef cxx0x::function< Ptr( const P1& p1, const P2& p2 ) > FactoryMethod;
+        typedef cxx0x::function< Ptr( const cxx0x::shared_ptr< detail::Arena >& arena, const P1& p1, const P2& p2 ) > ArenaFactoryMethod;
 
         /** Create an instance of the class described by this object.
         * @param p1 The first parameter to pass to the constructor
@@ -72,9 +75,34 @@ class Class
                 return( Ptr() ) ;
         }
 
+        /** Create an instance of the class described by this object inside
+        * the memory arena @c arena.
+        * @param arena The arena that provides the memory
+        * @param p1 The first parameter to pass to the constructor
+        * @param p2 The second parameter to pass to the constructor
+        * @return A shared_ptr to the new instance (or the empty
+        * shared_ptr if the descriptor is not valid)
+        */
+        Ptr NewInstance( const cxx0x::shared_ptr< detail::Arena >& arena, const P1& p1, const P2& p2 ) const
+        {
+            if( afm )
+                return( afm( arena, p1, p2 ) ) ;
+            else
+                return( NewInstance( p1, p2 ) ) ;
+        }
+
         /** Return the @c Class< P1, P2 > registered with the name @c name.
         */
         static Class ForName( const std::string& name )
+        {
+            Symbol s;
+            if ( ! Symbol::Find( name, s ) ) return Class(); // default value
+            return ForName( s );
+        }
+
+        /** Return the @c Class< P1, P2 > registered with the name @c name.
+        */
+        static Class ForName( const Symbol& name )
         {
             typename Classes::const_iterator i = Registry().find( name );
             if ( i != Registry().end() )
@@ -83,11 +111,12 @@ class Class
         }
     private :
         FactoryMethod fm;
-        typedef cxx0x::unordered_map< std::string, Class< P1, P2 > > Classes;
+        ArenaFactoryMethod afm; // empty if the class can only be allocated on the heap
+        typedef cxx0x::unordered_map< Symbol, Class< P1, P2 >, Symbol::Hash > Classes;
         template < class T, class T1, class T2 > friend class Registration;
-        static void Register( const std::string& s, const FactoryMethod& m )
+        static void Register( const std::string& s, const FactoryMethod& m, const ArenaFactoryMethod& am )
         {
-            Registry().insert( std::make_pair( s, Class( m ) ) );
+            Registry().insert( std::make_pair( Symbol( s ), Class( m, am ) ) );
         }
         static Classes& Registry()
         {
@@ -97,8 +126,9 @@ class Class
         Class()
         {
         }
-        Class( FactoryMethod m ) :
-            fm( m )
+        Class( FactoryMethod m, ArenaFactoryMethod am ) :
+            fm( m ),
+            afm( am )
         {
         }
 };
@@ -116,6 +146,7 @@ class Class< P, void >
 
         typedef cxx0x::shared_ptr< Part > Ptr;
         typedef cxx0x::function< Ptr( const P& p ) > FactoryMethod;
+        typedef cxx0x::function< Ptr( const cxx0x::shared_ptr< detail::Arena >& arena, const P& p ) > ArenaFactoryMethod;
 
         /** Create an instance of the class described by this object.
         * @param p The parameter to pass to the constructor
@@ -130,9 +161,33 @@ class Class< P, void >
                 return( Ptr() ) ;
         }
 
+        /** Create an instance of the class described by this object inside
+        * the memory arena @c arena.
+        * @param arena The arena that provides the memory
+        * @param p The parameter to pass to the constructor
+        * @return a shared_ptr to the new instance (or the empty
+        * shared_ptr if the descriptor is not valid)
+        */
+        Ptr NewInstance( const cxx0x::shared_ptr< detail::Arena >& arena, const P& p ) const
+        {
+            if( afm )
+                return( afm( arena, p ) ) ;
+            else
+                return( NewInstance( p ) ) ;
+        }
+
         /** Return the @c Class< P, void > registered with the name @c name.
         */
         static Class ForName( const std::string& name )
+        {
+            Symbol s;
+            if ( ! Symbol::Find( name, s ) ) return Class(); // default value
+            return ForName( s );
+        }
+
+        /** Return the @c Class< P, void > registered with the name @c name.
+        */
+        static Class ForName( const Symbol& name )
         {
             typename Classes::const_iterator i = Registry().find( name );
             if ( i != Registry().end() )
@@ -141,11 +196,12 @@ class Class< P, void >
         }
     private :
         FactoryMethod fm;
-        typedef cxx0x::unordered_map< std::string, Class< P, void > > Classes;
+        ArenaFactoryMethod afm; // empty if the class can only be allocated on the heap
+        typedef cxx0x::unordered_map< Symbol, Class< P, void >, Symbol::Hash > Classes;
         template < class T, class T1, class T2 > friend class Registration;
-        static void Register( const std::string& s, const FactoryMethod& m )
+        static void Register( const std::string& s, const FactoryMethod& m, const ArenaFactoryMethod& am )
         {
-            Registry().insert( std::make_pair( s, Class( m ) ) );
+            Registry().insert( std::make_pair( Symbol( s ), Class( m, am ) ) );
         }
         static Classes& Registry()
         {
@@ -155,8 +211,9 @@ class Class< P, void >
         Class()
         {
         }
-        Class( FactoryMethod m ) :
-            fm( m )
+        Class( FactoryMethod m, ArenaFactoryMethod am ) :
+            fm( m ),
+            afm( am )
         {
         }
 };
@@ -175,6 +232,7 @@ class Class< void, void >
 
         typedef cxx0x::shared_ptr< Part > Ptr;
         typedef cxx0x::function< Ptr() > FactoryMethod;
+        typedef cxx0x::function< Ptr( const cxx0x::shared_ptr< detail::Arena >& arena ) > ArenaFactoryMethod;
 
         /** Create an instance of the class described by this object.
         * @return a shared_ptr to the new instance (or the empty
@@ -192,9 +250,34 @@ class Class< void, void >
                 return( Ptr() );
         }
 
+        /** Create an instance of the class described by this object inside
+        * the memory arena @c arena.
+        * The classes loaded from a shared library are always allocated
+        * on the heap, because their destructor can unload the library.
+        * @param arena The arena that provides the memory
+        * @return a shared_ptr to the new instance (or the empty
+        * shared_ptr if the descriptor is not valid)
+        */
+        Ptr NewInstance( const cxx0x::shared_ptr< detail::Arena >& arena ) const
+        {
+            if( afm )
+                return( afm( arena ) );
+            else
+                return( NewInstance() );
+        }
+
         /** Return the @c Class< void, void > registered with the name @c name.
         */
         static Class ForName( const std::string& name )
+        {
+            Symbol s;
+            if ( ! Symbol::Find( name, s ) ) return Class(); // default value
+            return ForName( s );
+        }
+
+        /** Return the @c Class< void, void > registered with the name @c name.
+        */
+        static Class ForName( const Symbol& name )
         {
             Classes::const_iterator i = Registry().find( name );
             if ( i != Registry().end() )
@@ -203,17 +286,18 @@ class Class< void, void >
         }
     private :
         FactoryMethod fm;
+        ArenaFactoryMethod afm; // empty if the class can only be allocated on the heap
         cxx0x::shared_ptr< Plugin > plugin; // optional shared ptr to plugin, to release the shared library when is no more used
-        typedef cxx0x::unordered_map< std::string, Class< void, void > > Classes;
+        typedef cxx0x::unordered_map< Symbol, Class< void, void >, Symbol::Hash > Classes;
         template < class T, class T1, class T2 > friend class Registration;
         friend class Plugin;
-        static void Register( const std::string& s, const FactoryMethod& m )
+        static void Register( const std::string& s, const FactoryMethod& m, const ArenaFactoryMethod& am )
         {
-            Registry().insert( std::make_pair( s, Class( m ) ) );
+            Registry().insert( std::make_pair( Symbol( s ), Class( m, am ) ) );
         }
         static void Register( const std::string& s, const FactoryMethod& m, const cxx0x::shared_ptr< Plugin >& plugin )
         {
-            Registry().insert( std::make_pair( s, Class( m, plugin ) ) );
+            Registry().insert( std::make_pair( Symbol( s ), Class( m, plugin ) ) );
         }
         static Classes& Registry()
         {
@@ -223,8 +307,9 @@ class Class< void, void >
         Class()
         {
         }
-        Class( FactoryMethod m ) :
-            fm( m )
+        Class( FactoryMethod m, ArenaFactoryMethod am ) :
+            fm( m ),
+            afm( am )
         {
         }
         Class( FactoryMethod m, const cxx0x::shared_ptr< Plugin >& p ) :
@@ -248,7 +333,8 @@ public:
     Registration( const std::string& name )
     {
         typename Class< P1, P2 >::FactoryMethod fm( &detail::Factory< T, P1, P2 >::Create );
-        Class< P1, P2 >::Register( name, fm );
+        typename Class< P1, P2 >::ArenaFactoryMethod afm( &detail::Factory< T, P1, P2 >::CreateIn );
+        Class< P1, P2 >::Register( name, fm, afm );
     }
 };
 
@@ -0,0 +1,380 @@
+/*******************************************************************************
+ * wallaroo - A library for configurable creation and wiring of C++ classes.
+ * Copyright (C) 2012 Daniele Pallastrelli
+ *
+ * This file is part of wallaroo.
+ * For more information, see http://wallaroo.googlecode.com/
+ *
+ * Boost Software License - Version 1.0 - August 17th, 2003
+ *
+ * Permission is hereby granted, free of charge, to any person or organization
+ * obtaining a copy of the software and accompanying documentation covered by
+ * this license (the "Software") to use, reproduce, display, distribute,
+ * execute, and transmit the Software, and to prepare derivative works of the
+ * Software, and to permit third-parties to whom the Software is furnished to
+ * do so, all subject to the following:
+ *
+ * The copyright notices in the Software and this entire statement, including
+ * the above license grant, this restriction and the following disclaimer,
+ * must be included in all copies of the Software, in whole or in part, and
+ * all derivative works of the Software, unless such copies or derivative
+ * works are solely in the form of machine-executable object code generated by
+ * a source language processor.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT
+ * SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE
+ * FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE,
+ * ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ ******************************************************************************/
+
+#ifndef WALLAROO_CODEC_H_
+#define WALLAROO_CODEC_H_
+
+#include <string>
+#include <sstream>
+#include <limits>
+#include <cstring>
+#include <cstdlib>
+#include <cerrno>
+#include <cstdio>
+#include <cstddef>
+#include "cxx0x.h"
+
+// std::from_chars for the floating point types is available since C++17
+// (gcc >= 11, visual studio >= 2019). Otherwise strtod & co. are used.
+#if defined( __has_include )
+    #if __has_include( <charconv> )
+        #if ( defined( __cplusplus ) && __cplusplus >= 201703L ) || ( defined( _MSVC_LANG ) && _MSVC_LANG >= 201703L )
+            #include <charconv>
+        #endif
+    #endif
+#endif
+#if defined( __cpp_lib_to_chars )
+    #define WALLAROO_HAS_FROM_CHARS
+#endif
+
+namespace wallaroo
+{
+
+/**
+ * A non owning reference to a sequence of characters (i.e., a part of
+ * a std::string or of a buffer). The characters are not null terminated.
+ * It's used to convert the textual representation of attributes and
+ * constructor parameters without copying it.
+ */
+class StringView
+{
+public:
+    StringView() : first( "" ), length( 0 ) {}
+    StringView( const char* s ) : first( s ), length( std::strlen( s ) ) {}
+    StringView( const std::string& s ) : first( s.data() ), length( s.size() ) {}
+    StringView( const char* s, std::size_t n ) : first( s ), length( n ) {}
+
+    const char* data() const { return first; }
+    std::size_t size() const { return length; }
+    bool empty() const { return length == 0; }
+    const char* begin() const { return first; }
+    const char* end() const { return first + length; }
+
+    /** @return a std::string with a copy of the characters */
+    std::string str() const { return std::string( first, length ); }
+
+    bool operator == ( const char* s ) const
+    {
+        return std::strlen( s ) == length && std::memcmp( s, first, length ) == 0;
+    }
+
+private:
+    const char* first;
+    std::size_t length;
+};
+
+namespace detail
+{
+
+// ********************************************************
+// Conversion of a value from its textual representation.
+// The rules are the same for every type, both for the attributes and for the
+// constructor parameters: leading and trailing whitespaces are skipped
+// (except for std::string) and the rest of the string must be consumed;
+// the numbers are in decimal notation and do not depend on the locale;
+// bool accepts 0/1 and true/false; char, signed char and unsigned char are
+// a single (non blank) character, like their operator>> reads them.
+// NOTE: the constructor parameters of type "unsigned char" are an exception,
+// kept for compatibility: they're read as numbers (see parameters.h).
+
+inline bool IsSpace( char c )
+{
+    return c == ' ' || c == '\t' || c == '\n' || c == '\v' || c == '\f' || c == '\r';
+}
+
+// v without leading and trailing whitespaces
+inline StringView Trim( StringView v )
+{
+    const char* first = v.begin();
+    const char* last = v.end();
+    while ( first != last && IsSpace( *first ) ) ++first;
+    while ( last != first && IsSpace( *( last - 1 ) ) ) --last;
+    return StringView( first, last - first );
+}
+
+inline bool IsDigit( char c ) { return c >= '0' && c <= '9'; }
+
+// An integer with an optional sign (only '+' for the unsigned types).
+// Return false if v is not a valid representation or if the value
+// exceeds the range of T.
+template < typename T >
+inline bool DecodeInteger( StringView v, T& value )
+{
+    v = Trim( v );
+    const char* i = v.begin();
+    bool negative = false;
+    if ( i != v.end() && ( *i == '+' || *i == '-' ) )
+    {
+        negative = ( *i == '-' );
+        ++i;
+    }
+    if ( i == v.end() ) return false;
+    if ( negative && ! std::numeric_limits< T >::is_signed ) return false;
+    T result = 0;
+    for ( ; i != v.end(); ++i )
+    {
+        if ( ! IsDigit( *i ) ) return false;
+        const T digit = static_cast< T >( *i - '0' );
+        if ( negative )
+        {
+            // accumulate as negative number, to reach the minimum value
+            if ( result < ( std::numeric_limits< T >::min() + digit ) / 10 ) return false;
+            result = static_cast< T >( result * 10 - digit );
+        }
+        else
+        {
+            if ( result > ( std::numeric_limits< T >::max() - digit ) / 10 ) return false;
+            result = static_cast< T >( result * 10 + digit );
+        }
+    }
+    value = result;
+    return true;
+}
+
+// the end of the decimal floating point number starting at i:
+// digits [ '.' digits ] [ ( 'e' | 'E' ) [ sign ] digits ],
+// with at least a digit in the mantissa. Return NULL if there is no number.
+inline const char* ScanFloat( const char* i, const char* end )
+{
+    const char* start = i;
+    while ( i != end && IsDigit( *i ) ) ++i;
+    bool digits = ( i != start );
+    if ( i != end && *i == '.' )
+    {
+        const char* fraction = ++i;
+        while ( i != end && IsDigit( *i ) ) ++i;
+        digits = digits || ( i != fraction );
+    }
+    if ( ! digits ) return NULL;
+    if ( i != end && ( *i == 'e' || *i == 'E' ) )
+    {
+        const char* exponent = i + 1;
+        if ( exponent != end && ( *exponent == '+' || *exponent == '-' ) ) ++exponent;
+        const char* e = exponent;
+        while ( e != end && IsDigit( *e ) ) ++e;
+        if ( e != exponent ) i = e;
+    }
+    return i;
+}
+
+#ifndef WALLAROO_HAS_FROM_CHARS
+inline void StrTo( const char* s, char** stop, float& value ) { value = ::strtof( s, stop ); }
+inline void StrTo( const char* s, char** stop, double& value ) { value = std::strtod( s, stop ); }
+inline void StrTo( const char* s, char** stop, long double& value ) { value = ::strtold( s, stop ); }
+#endif
+
+// A floating point number in decimal notation with an optional sign.
+// Return false if v is not a valid representation or if the value
+// exceeds the range of T (it overflows or underflows to zero:
+// the subnormal values are accepted).
+template < typename T >
+inline bool DecodeFloat( StringView v, T& value )
+{
+    v = Trim( v );
+    const char* first = v.begin();
+    const char* mantissa = first;
+    if ( first != v.end() && *first == '+' )
+        mantissa = ++first; // not accepted by from_chars
+    else if ( first != v.end() && *first == '-' )
+        ++mantissa;
+    if ( ScanFloat( mantissa, v.end() ) != v.end() ) return false;
+#ifdef WALLAROO_HAS_FROM_CHARS
+    T result;
+    const std::from_chars_result r = std::from_chars( first, v.end(), result );
+    if ( r.ec != std::errc() || r.ptr != v.end() ) return false;
+    value = result;
+    return true;
+#else
+    // strtod needs a null terminated string and uses the decimal point of the locale
+    const std::size_t size = v.end() - first;
+    char buffer[ 64 ];
+    std::string heap; // only for very long numbers
+    char* s = buffer;
+    if ( size >= sizeof( buffer ) )
+    {
+        heap.resize( size + 1 );
+        s = &heap[ 0 ];
+    }
+    std::memcpy( s, first, size );
+    s[ size ] = '\0';
+    char* stop = NULL;
+    T result;
+    errno = 0;
+    StrTo( s, &stop, result );
+    if ( stop != s + size && *stop == '.' )
+    {
+        // the locale has another decimal point: get it from the formatting
+        // of a number (localeconv is not thread safe)
+        char formatted[ 8 ];
+        std::sprintf( formatted, "%.1f", 0.5 );
+        *stop = formatted[ 1 ];
+        errno = 0;
+        StrTo( s, &stop, result );
+    }
+    if ( stop != s + size ) return false;
+    // ERANGE is also set for the subnormal values, that are accepted like from_chars does
+    if ( errno == ERANGE )
+    {
+        if ( result == 0 || result > std::numeric_limits< T >::max() || result < -std::numeric_limits< T >::max() )
+            return false;
+    }
+    else if ( errno != 0 )
+        return false;
+    value = result;
+    return true;
+#endif
+}
+
+// The built-in codecs.
+// Generic conversion: use the operator>> of T (and the global locale).
+template < typename T >
+struct Codec
+{
+    static bool Decode( StringView v, T& value )
+    {
+        std::istringstream istream( v.str() );
+        istream >> std::boolalpha >> value;
+        if ( ! istream.eof() ) istream >> std::ws;
+        return ! istream.fail() && istream.get() == std::char_traits< char >::eof();
+    }
+};
+
+template < typename T >
+struct IntegerCodec
+{
+    static bool Decode( StringView v, T& value ) { return DecodeInteger( v, value ); }
+};
+
+template < typename T >
+struct FloatCodec
+{
+    static bool Decode( StringView v, T& value ) { return DecodeFloat( v, value ); }
+};
+
+template <> struct Codec< short > : IntegerCodec< short > {};
+template <> struct Codec< unsigned short > : IntegerCodec< unsigned short > {};
+template <> struct Codec< int > : IntegerCodec< int > {};
+template <> struct Codec< unsigned int > : IntegerCodec< unsigned int > {};
+template <> struct Codec< long > : IntegerCodec< long > {};
+template <> struct Codec< unsigned long > : IntegerCodec< unsigned long > {};
+#ifdef WALLAROO_HAS_CXX0X
+template <> struct Codec< long long > : IntegerCodec< long long > {};
+template <> struct Codec< unsigned long long > : IntegerCodec< unsigned long long > {};
+#endif
+template <> struct Codec< float > : FloatCodec< float > {};
+template <> struct Codec< double > : FloatCodec< double > {};
+template <> struct Codec< long double > : FloatCodec< long double > {};
+
+// A single character
+template < typename C >
+struct CharacterCodec
+{
+    static bool Decode( StringView v, C& value )
+    {
+        v = Trim( v );
+        if ( v.size() != 1 ) return false;
+        value = static_cast< C >( v.data()[ 0 ] );
+        return true;
+    }
+};
+
+template <> struct Codec< char > : CharacterCodec< char > {};
+template <> struct Codec< signed char > : CharacterCodec< signed char > {};
+template <> struct Codec< unsigned char > : CharacterCodec< unsigned char > {};
+
+template <>
+struct Codec< bool >
+{
+    static bool Decode( StringView v, bool& value )
+    {
+        v = Trim( v );
+        if ( v == "1" || v == "true" ) value = true;
+        else if ( v == "0" || v == "false" ) value = false;
+        else return false;
+        return true;
+    }
+};
+
+// T is a string. No conversion needed
+template <>
+struct Codec< std::string >
+{
+    static bool Decode( StringView v, std::string& value )
+    {
+        value.assign( v.data(), v.size() );
+        return true;
+    }
+};
+
+// The codec registered by the application for the type T (see RegisterCodec), if any.
+template < typename T >
+struct UserCodec
+{
+    typedef bool ( *Function )( StringView v, T& value );
+    static Function& Get()
+    {
+        static Function function = NULL;
+        return function;
+    }
+};
+
+// Convert v into a value of type T using the codec registered for T,
+// or the built-in one. Return false if v is not a valid representation.
+template < typename T >
+inline bool Decode( StringView v, T& value )
+{
+    const typename UserCodec< T >::Function decode = UserCodec< T >::Get();
+    return ( decode == NULL ? Codec< T >::Decode( v, value ) : decode( v, value ) );
+}
+
+} // namespace detail
+
+/** Register the function @c decode to convert the textual representation of
+ * the values of type @c T, that is the attributes of type @c T and the
+ * constructor parameters of type @c T read from the configuration files
+ * (or assigned using a string). It replaces the built-in conversion:
+ * without a registered codec, the numeric types and bool are converted
+ * without using the locale, and the other types using their operator>>.
+ * The codecs should be registered before loading the configuration files,
+ * because the registration is not thread safe.
+ * @param decode The function that converts a string into a value of type @c T.
+ *               It returns false if the string is not a valid representation.
+ */
+template < typename T >
+void RegisterCodec( bool ( *decode )( StringView v, T& value ) )
+{
+    detail::UserCodec< T >::Get() = decode;
+}
+
+} // namespace wallaroo
+
+#endif // WALLAROO_CODEC_H_
@@ -36,27 +36,71 @@
 #include <string>
 #include <typeinfo>
 #include <vector>
+#include <cassert>
 #include "cxx0x.h"
 #include "dependency.h"
 #include "part.h"
 #include "exceptions.h"
+#include "detail/rcu.h"
+#include "detail/parallel_for.h"
+#include "detail/type_index.h"
 
 namespace wallaroo
 {
 
+namespace detail
+{
+    // This class is returned by Collaborator::operator-> to give access
+    // to the linked part. When the collaborator is not pinned it keeps the
+    // part alive during the call: with the strong reference locked from
+    // the link, or with WALLAROO_INTRUSIVE_PARTS with an EpochGuard that
+    // keeps alive the link (that owns a reference of the part).
+    // Otherwise it's a plain pointer.
+    template < typename T >
+    class CollaboratorPtr
+    {
+    public:
+#ifdef WALLAROO_INTRUSIVE_PARTS
+        explicit CollaboratorPtr( T* p ) : guard( EpochGuard::None() ), ptr( p ) {}
+        CollaboratorPtr( T* p, const EpochGuard& g ) : guard( g ), ptr( p ) {}
+#else
+        explicit CollaboratorPtr( T* p ) : ptr( p ) {}
+        explicit CollaboratorPtr( const cxx0x::weak_ptr< T >& p ) : keeper( p.lock() ), ptr( keeper.get() ) {}
+#endif
+        T* operator -> () const { return ptr; }
+        T& operator * () const { return *ptr; }
+        bool Empty() const { return ptr == NULL; }
+    private:
+#ifdef WALLAROO_INTRUSIVE_PARTS
+        EpochGuard guard;
+#else
+        cxx0x::shared_ptr< T > keeper;
+#endif
+        T* ptr;
+    };
+
+    // The mutex that serializes the changes of the wiring of all the
+    // collaborators: the readers don't use it.
+    inline cxx0x::mutex& WiringMutex()
+    {
+        static cxx0x::mutex mutex;
+        return mutex;
+    }
+}
+
 /// This type should be used as second template parameter in Collaborator class to specify 
 /// that the Collaborator is optional (i.e.: you can omit to link a part to the collaborator)
 struct optional
 {
-    template < typename T >
-    static bool WiringOk( const cxx0x::weak_ptr< T >& ) { return true; }
+    template < typename W >
+    static bool WiringOk( const W& ) { return true; }
 };
 /// This type should be used as second template parameter in Collaborator class to specify
 /// that the Collaborator is mandatory (i.e.: you cannot omit to link a part to the collaborator)
 struct mandatory
 {
-    template < typename T >
-    static bool WiringOk( const cxx0x::weak_ptr< T >& t ) { return !t.expired(); }
+    template < typename W >
+    static bool WiringOk( const W& t ) { return !t.expired(); }
 };
 /// This type should be used as second template parameter in Collaborator class to specify
 /// that the Collaborator is a collection and you can wire the collaborator with a number 
@@ -117,6 +161,24 @@ typedef bounded_collection<> collection;
  *           @ref collection if you can link many parts to this collaborator)
  * @tparam Container If P = @ref collection, this represents the std container
  *           the Collaborator will derive from.
+ *
+ * If the symbol WALLAROO_INTRUSIVE_PARTS is defined, the collaborator
+ * holds an intrusive reference to the linked part (instead of a weak_ptr)
+ * and keeps it alive: the access through operator-> doesn't touch any
+ * reference count, and the wiring increments the count only once.
+ * Since the parts linked don't expire, the wiring of the parts must not
+ * contain cycles (see Catalog::Init) and the parts added to a catalog with
+ * Catalog::Add must outlive their collaborators.
+ * The collections are not affected: they contain weak_ptr in both cases.
+ *
+ * The collaborator can be rewired (see Link, Unlink and Replace) while other
+ * threads are calling the linked part through it: the readers don't lock,
+ * and every rewiring publishes a new immutable link, while the calls in
+ * progress complete on the previous part. With WALLAROO_INTRUSIVE_PARTS
+ * a link replaced is freed as soon as the last call in progress on it
+ * completes; otherwise it's a weak pointer, that is kept until the
+ * collaborator is destroyed.
+ * The collections can be iterated during a rewiring only through Snapshot().
  */
 template <
     typename T,
@@ -127,20 +189,28 @@ class Collaborator  : public Dependency
 {
 public:
 
+#ifdef WALLAROO_INTRUSIVE_PARTS
+    typedef detail::IntrusivePtr< T > WeakPtr;
+#else
     typedef cxx0x::weak_ptr< T > WeakPtr;
+#endif
     typedef cxx0x::shared_ptr< T > SharedPtr;
 
     /** Create a Collaborator and register it to its Part for later wiring.
     * @param name The name of this collaborator
     * @param token The registration token you can get by calling Part::RegistrationToken()
     */
-    Collaborator( const std::string& name, const RegToken& token )
+    Collaborator( const std::string& name, const RegToken& token ) :
+        pinned( NULL ),
+        pinning( false )
     {
         Part* owner = token.GetPart();
         owner -> Register( name, this );
     }
 
-    /** Link this collaborator with a Part
+    /** Link this collaborator with a Part, replacing the Part previously linked.
+    * It can be called while other threads are using the collaborator:
+    * the calls in progress complete on the previous Part.
     * @param dev The part you want link with this collaborator
     * @throw WrongType If @c dev is not a subclass of @c T
     */
@@ -149,30 +219,64 @@ public:
         cxx0x::shared_ptr< T > _dev = cxx0x::dynamic_pointer_cast< T >( dev );
         if ( ! _dev ) // bad type!
             throw WrongType();
-        else
-            part = _dev;
+        cxx0x::lock_guard< cxx0x::mutex > lock( detail::WiringMutex() );
+        Set( _dev );
+    }
+
+    /** Remove the link with the Part @c dev, if it's linked to this collaborator.
+    * It can be called while other threads are using the collaborator.
+    * @return false If @c dev was not linked to this collaborator.
+    */
+    virtual bool Unlink( const cxx0x::shared_ptr< Part >& dev )
+    {
+        cxx0x::lock_guard< cxx0x::mutex > lock( detail::WiringMutex() );
+        if ( ! Linked( dev ) ) return false;
+        Clear();
+        return true;
+    }
+
+    /** Remove the link with the Part linked to this collaborator, if any.
+    * It can be called while other threads are using the collaborator.
+    */
+    void Unlink()
+    {
+        cxx0x::lock_guard< cxx0x::mutex > lock( detail::WiringMutex() );
+        Clear();
+    }
+
+    /** Atomically link this collaborator with the Part @c dev in place of the Part @c old.
+    * It can be called while other threads are using the collaborator:
+    * the calls in progress complete on @c old.
+    * @return false If @c old was not linked to this collaborator (nothing is changed).
+    * @throw WrongType If @c dev is not a subclass of @c T
+    */
+    virtual bool Replace( const cxx0x::shared_ptr< Part >& old, const cxx0x::shared_ptr< Part >& dev )
+    {
+        cxx0x::shared_ptr< T > _dev = cxx0x::dynamic_pointer_cast< T >( dev );
+        if ( ! _dev ) // bad type!
+            throw WrongType();
+        cxx0x::lock_guard< cxx0x::mutex > lock( detail::WiringMutex() );
+        if ( ! Linked( old ) ) return false;
+        Set( _dev );
+        return true;
     }
 
     /** Give access to the embedded part.
+    * If the collaborator has been pinned (see Catalog::Seal) no locking is performed.
     * @throw DeletedPartError If the embedded part has been deleted.
     */
-    SharedPtr operator -> ()
+    detail::CollaboratorPtr< T > operator -> ()
     {
-        SharedPtr result = part.lock();
-        if ( ! result ) 
-            throw DeletedPartError();
-        return result;
+        return Access();
     }
 
     /** Give access to the embedded part as const.
+    * If the collaborator has been pinned (see Catalog::Seal) no locking is performed.
     * @throw DeletedPartError If the embedded part has been deleted.
     */
-    const SharedPtr operator -> () const
+    const detail::CollaboratorPtr< T > operator -> () const
     {
-        const SharedPtr result = part.lock();
-        if ( ! result )
-            throw DeletedPartError();
-        return result;
+        return Access();
     }
 
     /** Convert to a shared ptr.
@@ -180,7 +284,7 @@ public:
     */
     operator SharedPtr()
     {
-        SharedPtr result = part.lock();
+        SharedPtr result = Lock();
         if ( ! result )
             throw DeletedPartError();
         return result;
@@ -191,7 +295,7 @@ public:
     */
     operator const SharedPtr() const
     {
-        const SharedPtr result = part.lock();
+        const SharedPtr result = Lock();
         if ( ! result )
             throw DeletedPartError();
         return result;
@@ -203,7 +307,9 @@ public:
     */
     operator bool() const
     {
-        return !part.expired();
+        typename TargetPtr::Guard guard;
+        const Target* t = target.Get();
+        return t != NULL && !t -> part.expired();
     }
 
    /** Check if this Collaborator is correctly wired according to the
@@ -212,11 +318,148 @@ public:
     */
     virtual bool WiringOk() const
     {
-        return P::WiringOk( part );
+        typename TargetPtr::Guard guard;
+        const Target* t = target.Get();
+        return P::WiringOk( t == NULL ? WeakPtr() : t -> part );
+    }
+
+    /** Cache a plain pointer to the linked part, so that operator->
+    * does not need to lock the weak pointer anymore.
+    * The lifetime of the linked part must be guaranteed by its owner
+    * (i.e., the Catalog). In debug builds the access to a deleted part
+    * is still detected by an assertion.
+    */
+    virtual void Pin()
+    {
+        cxx0x::lock_guard< cxx0x::mutex > lock( detail::WiringMutex() );
+        pinning = true;
+        const SharedPtr linked = Lock();
+        if ( linked ) Set( linked );
+    }
+
+    /** Append to @c targets the linked part, if any.
+    */
+    virtual void Targets( std::vector< Part* >& targets ) const
+    {
+        T* linked = Lock().get();
+        if ( linked ) targets.push_back( linked );
+    }
+
+    // Dependency implementation
+    virtual void LinkedParts( std::vector< cxx0x::shared_ptr< Part > >& parts ) const
+    {
+        const SharedPtr linked = Lock();
+        if ( linked ) parts.push_back( linked );
+    }
+
+    // Dependency implementation
+    virtual bool Autowire( const detail::TypeIndex& index, const Part* owner, std::vector< const Part* >& candidates )
+    {
+        if ( target.Get() != NULL ) return true; // already wired
+        const cxx0x::shared_ptr< const detail::TypeIndex::Matches< T > > matches = index.All< T >();
+        const std::vector< const Part* >& sources = matches -> sources;
+        std::size_t match = sources.size();
+        for ( std::size_t i = 0; i < sources.size(); ++i )
+        {
+            if ( sources[ i ] == owner ) continue;
+            if ( match != sources.size() )
+            {
+                for ( std::size_t j = 0; j < sources.size(); ++j )
+                    if ( sources[ j ] != owner ) candidates.push_back( sources[ j ] );
+                return false;
+            }
+            match = i;
+        }
+        if ( match == sources.size() ) return true; // no part to link
+        cxx0x::lock_guard< cxx0x::mutex > lock( detail::WiringMutex() );
+        if ( target.Get() == NULL ) Set( matches -> parts[ match ] );
+        return true;
     }
 
 private:
-    WeakPtr part;
+    // The part linked. Every change of the wiring publishes a new
+    // Target, so that the readers don't need any lock (see TargetPtr).
+    struct Target
+    {
+        explicit Target( const SharedPtr& p ) : part( p ) {}
+        WeakPtr part;
+    };
+
+    detail::CollaboratorPtr< T > Access() const
+    {
+        T* p = pinned.load( cxx0x::memory_order_acquire );
+        if ( p )
+        {
+            assert( Alive() ); // the catalog has been deleted before this part
+            return detail::CollaboratorPtr< T >( p );
+        }
+        typename TargetPtr::Guard guard;
+        const Target* t = target.Get();
+        if ( t == NULL )
+            throw DeletedPartError();
+#ifdef WALLAROO_INTRUSIVE_PARTS
+        // the link holds the part until the guard is released, after the call
+        if ( t -> part.expired() )
+            throw DeletedPartError();
+        return detail::CollaboratorPtr< T >( t -> part.get(), guard );
+#else
+        // the weak pointer is locked once, straight into the result
+        detail::CollaboratorPtr< T > result( t -> part );
+        if ( result.Empty() )
+            throw DeletedPartError();
+        return result;
+#endif
+    }
+
+    SharedPtr Lock() const
+    {
+        typename TargetPtr::Guard guard;
+        const Target* t = target.Get();
+        return ( t == NULL ? SharedPtr() : SharedPtr( t -> part.lock() ) );
+    }
+
+    // false if the part linked has been deleted
+    // (the link can be NULL after a concurrent Unlink)
+    bool Alive() const
+    {
+        typename TargetPtr::Guard guard;
+        const Target* t = target.Get();
+        return t == NULL || !t -> part.expired();
+    }
+
+    // link p (must be called with the wiring mutex locked)
+    void Set( const SharedPtr& p )
+    {
+        target.Publish( Target( p ) );
+        pinned.store( pinning ? p.get() : NULL, cxx0x::memory_order_release );
+    }
+
+    // remove the link (must be called with the wiring mutex locked)
+    void Clear()
+    {
+        pinned.store( NULL, cxx0x::memory_order_release );
+        target.Reset();
+    }
+
+    // true if dev is the part linked (must be called with the wiring mutex locked)
+    bool Linked( const cxx0x::shared_ptr< Part >& dev ) const
+    {
+        const SharedPtr linked = Lock();
+        return linked && linked.get() == dynamic_cast< T* >( dev.get() );
+    }
+
+#ifdef WALLAROO_INTRUSIVE_PARTS
+    // the link owns a reference of the part, so it's destroyed only when
+    // no reader can be using it
+    typedef detail::RcuPtr< Target > TargetPtr;
+#else
+    // the readers lock the weak pointer of the link, and the links
+    // replaced are kept with the collaborator: they don't need a guard
+    typedef detail::RetainPtr< Target > TargetPtr;
+#endif
+    TargetPtr target; // NULL if not linked
+    cxx0x::atomic< T* > pinned; // plain pointer to the part linked (NULL if not pinned)
+    bool pinning; // true when the collaborator has been pinned (accessed with the wiring mutex locked)
 
     // copy ctor and assignment operator disabled
     Collaborator( const Collaborator& );
@@ -238,6 +481,17 @@ private:
 
 public:
 
+    /** The type of the container of the links, returned by Snapshot(). */
+    typedef C Links;
+    /** The type of the array of plain pointers returned by Pointers(). */
+    typedef std::vector< T* > RawPointers;
+    /** The type of the array of shared pointers returned by Lock(). */
+    typedef std::vector< cxx0x::shared_ptr< T > > SharedPointers;
+    /** The pointer to the immutable copy of the links returned by Snapshot(). */
+    typedef cxx0x::shared_ptr< const Links > LinksPtr;
+    /** The pointer to the immutable array returned by Pointers(). */
+    typedef cxx0x::shared_ptr< const RawPointers > RawPointersPtr;
+
     /** Create a Collaborator and register it to its Part for future wiring.
     * @param name The name of this collaborator
     * @param token The registration token you can get by calling Part::RegistrationToken()
@@ -257,8 +511,213 @@ public:
         cxx0x::shared_ptr< T > obj = cxx0x::dynamic_pointer_cast< T >( part );
         if ( ! obj ) // bad type!
             throw WrongType();
-        else
-            C::push_back( obj );
+        cxx0x::lock_guard< cxx0x::mutex > lock( detail::WiringMutex() );
+        C::push_back( obj );
+        // while the collaborator is being wired nobody reads the snapshot
+        if ( view.Get() != NULL ) Update();
+    }
+
+    /** Remove the Part @c part from this (collection) collaborator.
+    * It can be called while other threads are iterating over the Snapshot()
+    * of the collaborator.
+    * @return false If @c part was not in the collection.
+    */
+    virtual bool Unlink( const cxx0x::shared_ptr< Part >& part )
+    {
+        cxx0x::lock_guard< cxx0x::mutex > lock( detail::WiringMutex() );
+        T* const removed = dynamic_cast< T* >( part.get() );
+        bool found = false;
+        for ( typename C::iterator i = C::begin(); i != C::end(); )
+        {
+            if ( removed != NULL && i -> lock().get() == removed )
+            {
+                i = C::erase( i );
+                found = true;
+            }
+            else
+                ++i;
+        }
+        if ( found ) Update();
+        return found;
+    }
+
+    /** Atomically replace the Part @c old with the Part @c part in this (collection) collaborator.
+    * It can be called while other threads are iterating over the Snapshot()
+    * of the collaborator: they complete the iteration with @c old.
+    * @return false If @c old was not in the collection (nothing is changed).
+    * @throw WrongType If @c part is not a subclass of @c T
+    */
+    virtual bool Replace( const cxx0x::shared_ptr< Part >& old, const cxx0x::shared_ptr< Part >& part )
+    {
+        cxx0x::shared_ptr< T > obj = cxx0x::dynamic_pointer_cast< T >( part );
+        if ( ! obj ) // bad type!
+            throw WrongType();
+        cxx0x::lock_guard< cxx0x::mutex > lock( detail::WiringMutex() );
+        T* const replaced = dynamic_cast< T* >( old.get() );
+        bool found = false;
+        for ( typename C::iterator i = C::begin(); i != C::end(); ++i )
+            if ( replaced != NULL && i -> lock().get() == replaced )
+            {
+                *i = obj;
+                found = true;
+            }
+        if ( found ) Update();
+        return found;
+    }
+
+    /** Return a copy of the collection that never changes, and remains valid
+    * while the pointer returned is held: unlike the collaborator itself,
+    * it can be iterated while other threads rewire the collaborator
+    * (with Link, Unlink or Replace). The copy is made only when the collection
+    * changes, and without locks after Catalog::Seal.
+    */
+    LinksPtr Snapshot() const
+    {
+        const ViewPtr v = Current();
+        return LinksPtr( v, &v -> links );
+    }
+
+    /** Return a contiguous array with the plain pointers to the parts of the
+    * collection, so that a loop over the parts doesn't touch any weak pointer
+    * or reference count. Like Snapshot(), the array never changes and remains
+    * valid while the pointer returned is held, and it's built only when the
+    * collection changes.
+    * The lifetime of the parts must be guaranteed by their owner (i.e., the Catalog):
+    * the parts already deleted when the array is built are skipped.
+    */
+    RawPointersPtr Pointers() const
+    {
+        const ViewPtr v = Current();
+        return RawPointersPtr( v, &v -> pointers );
+    }
+
+    /** Return an array with the shared pointers to the parts of the
+    * collection not yet deleted: it keeps the parts alive while the caller
+    * iterates over it, without locking every element at each pass.
+    */
+    SharedPointers Lock() const
+    {
+        const ViewPtr v = Current();
+        const Links& links = v -> links;
+        SharedPointers parts;
+        parts.reserve( links.size() );
+        for ( typename C::const_iterator i = links.begin(); i != links.end(); ++i )
+        {
+            cxx0x::shared_ptr< T > part = i -> lock();
+            if ( part ) parts.push_back( part );
+        }
+        return parts;
+    }
+
+    /** Call @c f( p ) for every pointer @c p returned by Pointers(), in parallel
+    * on the calling thread and on a pool of threads shared by the whole process.
+    * The parts are split in chunks adaptively and the idle threads take the
+    * next chunk, so the load is balanced even if the calls have different durations.
+    * It returns when all the calls are done.
+    * All the threads call the same @c f, through a const reference: its
+    * operator() must be const, and safe to call concurrently.
+    * @throw If a call throws, the parts not yet started are skipped and the
+    *        first exception is rethrown.
+    */
+    template < typename F >
+    void ParallelForEach( F f ) const
+    {
+        const RawPointersPtr pointers = Pointers();
+        const RawPointers& parts = *pointers;
+        detail::ParallelFor::Run( parts.size(), detail::ForEachChunk< T, F >( Data( parts ), f ) );
+    }
+
+    /** Call the method @c m on every part of the collection, in parallel
+    * (see ParallelForEach(F)). I.e. <tt>shapes.ParallelForEach( &Shape::Align )</tt>
+    */
+    template < typename R >
+    void ParallelForEach( R ( T::*m )() ) const
+    {
+        ParallelForEach( detail::MethodCall0< R, T, R ( T::* )() >( m ) );
+    }
+
+    /** Call the const method @c m on every part of the collection, in parallel
+    * (see ParallelForEach(F)).
+    */
+    template < typename R >
+    void ParallelForEach( R ( T::*m )() const ) const
+    {
+        ParallelForEach( detail::MethodCall0< R, T, R ( T::* )() const >( m ) );
+    }
+
+    /** Call the method @c m with the argument @c a1 on every part of the collection,
+    * in parallel (see ParallelForEach(F)). I.e. <tt>shapes.ParallelForEach( &Shape::Draw, canvas )</tt>
+    * The argument is converted to the type of the parameter of @c m: if it's a
+    * reference (const or not), every call receives @c a1 itself.
+    */
+    template < typename R, typename P1 >
+    void ParallelForEach( R ( T::*m )( P1 ), typename detail::NonDeduced< P1 >::Type a1 ) const
+    {
+        ParallelForEach( detail::MethodCall1< R, T, R ( T::* )( P1 ), P1 >( m, a1 ) );
+    }
+
+    /** Call the const method @c m with the argument @c a1 on every part of the
+    * collection, in parallel (see ParallelForEach(F)).
+    */
+    template < typename R, typename P1 >
+    void ParallelForEach( R ( T::*m )( P1 ) const, typename detail::NonDeduced< P1 >::Type a1 ) const
+    {
+        ParallelForEach( detail::MethodCall1< R, T, R ( T::* )( P1 ) const, P1 >( m, a1 ) );
+    }
+
+    /** Call the method @c m with the arguments @c a1 and @c a2 on every part of
+    * the collection, in parallel (see ParallelForEach(F)).
+    */
+    template < typename R, typename P1, typename P2 >
+    void ParallelForEach( R ( T::*m )( P1, P2 ), typename detail::NonDeduced< P1 >::Type a1, typename detail::NonDeduced< P2 >::Type a2 ) const
+    {
+        ParallelForEach( detail::MethodCall2< R, T, R ( T::* )( P1, P2 ), P1, P2 >( m, a1, a2 ) );
+    }
+
+    /** Call the const method @c m with the arguments @c a1 and @c a2 on every part
+    * of the collection, in parallel (see ParallelForEach(F)).
+    */
+    template < typename R, typename P1, typename P2 >
+    void ParallelForEach( R ( T::*m )( P1, P2 ) const, typename detail::NonDeduced< P1 >::Type a1, typename detail::NonDeduced< P2 >::Type a2 ) const
+    {
+        ParallelForEach( detail::MethodCall2< R, T, R ( T::* )( P1, P2 ) const, P1, P2 >( m, a1, a2 ) );
+    }
+
+    /** Call @c f( p ) for every pointer @c p returned by Pointers() in parallel
+    * (see ParallelForEach(F)), and combine the results with @c op, starting from @c init.
+    * @c op must be associative and commutative, because the order of the
+    * combinations is not specified. I.e. <tt>sensors.ParallelReduce( Read(), 0, std::plus< int >() )</tt>
+    * Like @c f, @c op is shared by all the threads: its operator() must be
+    * const, and safe to call concurrently.
+    * @throw If a call throws, the first exception is rethrown.
+    */
+    template < typename R, typename F, typename Op >
+    R ParallelReduce( F f, R init, Op op ) const
+    {
+        const RawPointersPtr pointers = Pointers();
+        const RawPointers& parts = *pointers;
+        cxx0x::mutex mutex;
+        detail::ParallelFor::Run( parts.size(), detail::ReduceChunk< T, R, F, Op >( Data( parts ), f, op, &init, &mutex ) );
+        return init;
+    }
+
+    /** Call the method @c m on every part of the collection in parallel,
+    * and combine the results with @c op, starting from @c init (see ParallelReduce(F,R,Op)).
+    * I.e. <tt>sensors.ParallelReduce( &Sensor::Level, 0, std::plus< int >() )</tt>
+    */
+    template < typename R, typename Op >
+    R ParallelReduce( R ( T::*m )(), R init, Op op ) const
+    {
+        return ParallelReduce( detail::MethodCall0< R, T, R ( T::* )() >( m ), init, op );
+    }
+
+    /** Call the const method @c m on every part of the collection in parallel,
+    * and combine the results with @c op, starting from @c init (see ParallelReduce(F,R,Op)).
+    */
+    template < typename R, typename Op >
+    R ParallelReduce( R ( T::*m )() const, R init, Op op ) const
+    {
+        return ParallelReduce( detail::MethodCall0< R, T, R ( T::* )() const >( m ), init, op );
     }
 
     /** Check if this Collaborator is correctly wired (i.e. the size of the collection
@@ -270,7 +729,97 @@ public:
         return bounded_collection< MIN, MAX >::WiringOk( this );
     }
 
+    /** Make the snapshot of the collection, so that the following calls
+    * of Snapshot() and Pointers() don't need to lock.
+    */
+    virtual void Pin()
+    {
+        cxx0x::lock_guard< cxx0x::mutex > lock( detail::WiringMutex() );
+        Update();
+    }
+
+    /** Append to @c targets the parts of the collection not yet deleted.
+    */
+    virtual void Targets( std::vector< Part* >& targets ) const
+    {
+        const LinksPtr links = Snapshot();
+        const Links& parts = *links;
+        for ( typename C::const_iterator i = parts.begin(); i != parts.end(); ++i )
+        {
+            T* target = i -> lock().get();
+            if ( target ) targets.push_back( target );
+        }
+    }
+
+    // Dependency implementation
+    virtual void LinkedParts( std::vector< cxx0x::shared_ptr< Part > >& targets ) const
+    {
+        const LinksPtr links = Snapshot();
+        const Links& parts = *links;
+        for ( typename C::const_iterator i = parts.begin(); i != parts.end(); ++i )
+        {
+            const cxx0x::shared_ptr< T > target = i -> lock();
+            if ( target ) targets.push_back( target );
+        }
+    }
+
+    // Dependency implementation
+    virtual bool Autowire( const detail::TypeIndex& index, const Part* owner, std::vector< const Part* >& )
+    {
+        const cxx0x::shared_ptr< const detail::TypeIndex::Matches< T > > matches = index.All< T >();
+        cxx0x::lock_guard< cxx0x::mutex > lock( detail::WiringMutex() );
+        if ( ! C::empty() ) return true; // already wired
+        for ( std::size_t i = 0; i < matches -> sources.size(); ++i )
+            if ( matches -> sources[ i ] != owner )
+                C::push_back( matches -> parts[ i ] );
+        if ( view.Get() != NULL ) Update();
+        return true;
+    }
+
 private:
+    // The immutable copy of the collection published to the readers
+    // (see detail::RcuPtr), with the array of the plain pointers.
+    struct View
+    {
+        explicit View( const C& c ) : links( c )
+        {
+            pointers.reserve( links.size() );
+            for ( typename C::const_iterator i = links.begin(); i != links.end(); ++i )
+            {
+                T* part = i -> lock().get();
+                if ( part ) pointers.push_back( part );
+            }
+        }
+        const C links;
+        RawPointers pointers;
+    };
+    typedef cxx0x::shared_ptr< const View > ViewPtr;
+
+    static T* const* Data( const RawPointers& parts )
+    {
+        return ( parts.empty() ? NULL : &parts[ 0 ] );
+    }
+
+    ViewPtr Current() const
+    {
+        {
+            detail::EpochGuard guard;
+            const ViewPtr* v = view.Get();
+            if ( v != NULL ) return *v;
+        }
+        cxx0x::lock_guard< cxx0x::mutex > lock( detail::WiringMutex() );
+        if ( view.Get() == NULL ) Update();
+        return *view.Get();
+    }
+
+    // publish a copy of the collection (must be called with the wiring mutex locked)
+    void Update() const
+    {
+        view.Publish( ViewPtr( new View( static_cast< const C& >( *this ) ) ) );
+    }
+
+    mutable detail::RcuPtr< ViewPtr > view; // NULL until the first access or Pin()
+
     // copy ctor and assignment operator disabled
     Collaborator( const Collaborator& );
     Collaborator& operator = ( const Collaborator& );
@@ -64,12 +64,25 @@
 #endif
 
 
+// single threaded programs: with boost, the shared_ptr reference counts
+// become non-atomic (must be defined before including any boost header).
+// NOTE: the std::shared_ptr counts cannot be changed, so in the std build
+// (WALLAROO_HAS_CXX0X) this macro has effect only together with
+// WALLAROO_INTRUSIVE_PARTS, on the intrusive counts. Define also
+// WALLAROO_FORCE_USE_BOOST to make the shared_ptr counts non-atomic.
+#if defined(WALLAROO_SINGLE_THREADED) && !defined(WALLAROO_HAS_CXX0X) && !defined(BOOST_SP_DISABLE_THREADS)
+    #define BOOST_SP_DISABLE_THREADS
+#endif
+
 // using the right headers and namespace
 #ifdef WALLAROO_HAS_CXX0X
     #include <memory>
     #include <type_traits>
     #include <functional>
     #include <unordered_map>
+    #include <mutex>
+    #include <atomic>
+    #include <cstdint>
     namespace cxx0x = std;
 #else
     #include <boost/shared_ptr.hpp>
@@ -78,6 +91,10 @@
     #include <boost/function.hpp>
     #include <boost/make_shared.hpp>
     #include <boost/unordered_map.hpp>
+    #include <boost/thread/mutex.hpp>
+    #include <boost/thread/lock_guard.hpp>
+    #include <boost/atomic.hpp>
+    #include <boost/cstdint.hpp>
     namespace cxx0x = boost;
 #endif
 
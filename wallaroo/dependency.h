@@ -33,13 +33,15 @@
 #ifndef WALLAROO_DEPENDENCY_H_
 #define WALLAROO_DEPENDENCY_H_
 
+#include <vector>
 #include "cxx0x.h"
 
 namespace wallaroo
 {
 
-// forward declaration:
+// forward declarations:
 class Part;
+namespace detail { class TypeIndex; }
 
 /**
  * This represents the base class for every Collaborator template.
@@ -55,11 +57,52 @@ public:
     * @throw WrongType If this Dependency could not be wire with Part @c part 
     */
     virtual void Link( const cxx0x::shared_ptr< Part >& part ) = 0;
+    /** Remove the link of this Dependency with a Part.
+    * It can be called while other threads are using this Dependency.
+    * The default implementation doesn't support the unlinking and returns false.
+    * @param part The Part you want to unlink from this Dependency.
+    * @return false If @c part was not linked to this Dependency.
+    */
+    virtual bool Unlink( const cxx0x::shared_ptr< Part >& ) { return false; }
+    /** Atomically replace the link of this Dependency with the Part @c old
+    * with a link with the Part @c part. It can be called while other threads
+    * are using this Dependency: the calls in progress complete on @c old.
+    * The default implementation doesn't support the replacement and returns false.
+    * @param old The Part currently linked to this Dependency.
+    * @param part The Part you want to link in place of @c old.
+    * @return false If @c old was not linked to this Dependency (nothing is changed).
+    * @throw WrongType If this Dependency could not be wire with Part @c part
+    */
+    virtual bool Replace( const cxx0x::shared_ptr< Part >&, const cxx0x::shared_ptr< Part >& ) { return false; }
     /** Check if this Dependency is correctly wired according to the
     * constraints specified as template parameters in the derived class.
     * @return true If the check pass.
     */
     virtual bool WiringOk() const = 0;
+    /** Cache a plain pointer to the linked Part, so that the following
+    * accesses don't need to lock it. It gets called by Catalog::Seal().
+    * The default implementation does nothing.
+    */
+    virtual void Pin() {}
+    /** Append to @c targets the parts currently linked to this Dependency.
+    * It's used by Catalog::Init() to initialize the collaborators of a part before the part.
+    * The default implementation appends nothing.
+    */
+    virtual void Targets( std::vector< Part* >& ) const {}
+    /** Append to @c parts the parts currently linked to this Dependency.
+    * It's used by Prototype to copy the wiring of a part.
+    * The default implementation appends nothing.
+    */
+    virtual void LinkedParts( std::vector< cxx0x::shared_ptr< Part > >& ) const {}
+    /** If this Dependency is not wired yet, link it with the parts of @c index
+    * assignable to its type, except @c owner (the part containing this Dependency).
+    * It's used by Catalog::Autowire().
+    * The default implementation links nothing.
+    * @return false If this Dependency can be linked with one part only and
+    *         more than one part is assignable to it: nothing is linked and
+    *         the parts are appended to @c candidates.
+    */
+    virtual bool Autowire( const detail::TypeIndex&, const Part*, std::vector< const Part* >& ) { return true; }
 };
 
 } // namespace
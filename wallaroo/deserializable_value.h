@@ -35,6 +35,8 @@
 
 #include "cxx0x.h"
 #include <string>
+#include <typeinfo>
+#include "codec.h"
 
 namespace wallaroo
 {
@@ -49,10 +51,26 @@ class DeserializableValue
 public:
     virtual ~DeserializableValue() {}
     /** Set this attribute value from a string representation.
-    * @param value A string representation of the value to be assigned.
+    * @param value A string representation of the value to be assigned
+    *              (see RegisterCodec for the conversion rules).
     * @throw WrongType If the string representation is not valid for this object.
     */
-    virtual void Value( const std::string& value ) = 0;
+    virtual void Value( StringView value ) = 0;
+    /** Set this attribute value from a value of the type @c type, if
+    * it's exactly the type of this object. No conversion is performed.
+    * The default implementation assigns nothing and returns false, so that the
+    * value gets converted through its string representation.
+    * @param type The type of the value pointed by @c value.
+    * @param value A pointer to the value to be assigned.
+    * @return false If @c type is not the type of this object (the value is not assigned).
+    */
+    virtual bool Assign( const std::type_info&, const void* ) { return false; }
+    /** Assign the value of this object to @c other, if they have the same type.
+    * The default implementation assigns nothing and returns false.
+    * @param other The object to assign.
+    * @return false If @c other has not the type of this object (the value is not assigned).
+    */
+    virtual bool CopyTo( DeserializableValue& ) const { return false; }
 };
 
 
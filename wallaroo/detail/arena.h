@@ -0,0 +1,156 @@
+/*******************************************************************************
+ * wallaroo - A library for configurable creation and wiring of C++ classes.
+ * Copyright (C) 2012 Daniele Pallastrelli
+ *
+ * This file is part of wallaroo.
+ * For more information, see http://wallaroo.googlecode.com/
+ *
+ * Boost Software License - Version 1.0 - August 17th, 2003
+ *
+ * Permission is hereby granted, free of charge, to any person or organization
+ * obtaining a copy of the software and accompanying documentation covered by
+ * this license (the "Software") to use, reproduce, display, distribute,
+ * execute, and transmit the Software, and to prepare derivative works of the
+ * Software, and to permit third-parties to whom the Software is furnished to
+ * do so, all subject to the following:
+ *
+ * The copyright notices in the Software and this entire statement, including
+ * the above license grant, this restriction and the following disclaimer,
+ * must be included in all copies of the Software, in whole or in part, and
+ * all derivative works of the Software, unless such copies or derivative
+ * works are solely in the form of machine-executable object code generated by
+ * a source language processor.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT
+ * SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE
+ * FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE,
+ * ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ ******************************************************************************/
+
+#ifndef WALLAROO_DETAIL_ARENA_H_
+#define WALLAROO_DETAIL_ARENA_H_
+
+#include <vector>
+#include <cstddef>
+#include "wallaroo/cxx0x.h"
+
+namespace wallaroo
+{
+namespace detail
+{
+
+// A monotonic memory arena: the memory is carved sequentially from big
+// chunks, it's never released piecewise and all the chunks are freed
+// together by the destructor.
+// The objects allocated close in time are close in memory.
+// It's thread safe.
+class Arena
+{
+public:
+    explicit Arena( std::size_t _chunkSize = 16 * 1024 ) :
+        chunkSize( _chunkSize ),
+        current( NULL ),
+        left( 0 )
+    {
+    }
+
+    ~Arena()
+    {
+        for ( std::size_t i = 0; i < chunks.size(); ++i )
+            delete[] chunks[ i ];
+    }
+
+    // Return @c size bytes aligned to @c alignment (must be a power of 2).
+    void* Allocate( std::size_t size, std::size_t alignment )
+    {
+        cxx0x::lock_guard< cxx0x::mutex > lock( mutex );
+        std::size_t padding = Padding( current, alignment );
+        if ( current == NULL || padding + size > left )
+        {
+            const std::size_t needed = size + alignment;
+            const std::size_t chunk = ( needed > chunkSize ? needed : chunkSize );
+            chunks.reserve( chunks.size() + 1 ); // so that push_back cannot throw after new
+            current = new char[ chunk ];
+            chunks.push_back( current );
+            left = chunk;
+            padding = Padding( current, alignment );
+        }
+        char* result = current + padding;
+        current = result + size;
+        left -= padding + size;
+        return result;
+    }
+
+private:
+    static std::size_t Padding( const char* p, std::size_t alignment )
+    {
+        const std::size_t misalignment = reinterpret_cast< std::size_t >( p ) & ( alignment - 1 );
+        return ( misalignment == 0 ? 0 : alignment - misalignment );
+    }
+
+    const std::size_t chunkSize;
+    std::vector< char* > chunks;
+    char* current; // the first free byte of the last chunk
+    std::size_t left; // the free bytes of the last chunk
+    cxx0x::mutex mutex;
+
+    // copy ctor and assignment operator disabled
+    Arena( const Arena& );
+    Arena& operator = ( const Arena& );
+};
+
+// A standard allocator that takes the memory from an Arena.
+// The allocator keeps the arena alive, so the objects allocated through
+// allocate_shared can outlive the owner of the arena.
+// NOTE: construct and destroy are omitted on purpose, so that allocate_shared
+// constructs the object in place with the constructor parameters
+// (a construct( p, const T& ) would require a copy constructor).
+template < typename T >
+class ArenaAllocator
+{
+public:
+    typedef T value_type;
+    typedef T* pointer;
+    typedef const T* const_pointer;
+    typedef T& reference;
+    typedef const T& const_reference;
+    typedef std::size_t size_type;
+    typedef std::ptrdiff_t difference_type;
+
+    template < typename U >
+    struct rebind
+    {
+        typedef ArenaAllocator< U > other;
+    };
+
+    explicit ArenaAllocator( const cxx0x::shared_ptr< Arena >& a ) : arena( a ) {}
+    template < typename U >
+    ArenaAllocator( const ArenaAllocator< U >& other ) : arena( other.arena ) {}
+
+    pointer allocate( size_type n, const void* = 0 )
+    {
+        return static_cast< pointer >( arena -> Allocate( n * sizeof( T ), cxx0x::alignment_of< T >::value ) );
+    }
+    void deallocate( pointer, size_type ) {} // the memory is released by the arena
+
+    size_type max_size() const { return static_cast< size_type >( -1 ) / sizeof( T ); }
+    pointer address( reference x ) const { return &x; }
+    const_pointer address( const_reference x ) const { return &x; }
+
+    template < typename U >
+    bool operator == ( const ArenaAllocator< U >& other ) const { return arena == other.arena; }
+    template < typename U >
+    bool operator != ( const ArenaAllocator< U >& other ) const { return arena != other.arena; }
+
+private:
+    template < typename U > friend class ArenaAllocator;
+    cxx0x::shared_ptr< Arena > arena;
+};
+
+} // namespace detail
+} // namespace wallaroo
+
+#endif // WALLAROO_DETAIL_ARENA_H_
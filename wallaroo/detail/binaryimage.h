@@ -0,0 +1,388 @@
+/*******************************************************************************
+ * wallaroo - A library for configurable creation and wiring of C++ classes.
+ * Copyright (C) 2012 Daniele Pallastrelli
+ *
+ * This file is part of wallaroo.
+ * For more information, see http://wallaroo.googlecode.com/
+ *
+ * Boost Software License - Version 1.0 - August 17th, 2003
+ *
+ * Permission is hereby granted, free of charge, to any person or organization
+ * obtaining a copy of the software and accompanying documentation covered by
+ * this license (the "Software") to use, reproduce, display, distribute,
+ * execute, and transmit the Software, and to prepare derivative works of the
+ * Software, and to permit third-parties to whom the Software is furnished to
+ * do so, all subject to the following:
+ *
+ * The copyright notices in the Software and this entire statement, including
+ * the above license grant, this restriction and the following disclaimer,
+ * must be included in all copies of the Software, in whole or in part, and
+ * all derivative works of the Software, unless such copies or derivative
+ * works are solely in the form of machine-executable object code generated by
+ * a source language processor.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT
+ * SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE
+ * FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE,
+ * ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ ******************************************************************************/
+
+#ifndef WALLAROO_DETAIL_BINARYIMAGE_H_
+#define WALLAROO_DETAIL_BINARYIMAGE_H_
+
+#include <string>
+#include <vector>
+#include <ostream>
+#include <cstring>
+#include <cstddef>
+#include "wallaroo/cxx0x.h"
+#include "wallaroo/exceptions.h"
+#include "wallaroo/codec.h"
+#include "wallaroo/detail/streambasedcfg.h"
+
+namespace wallaroo
+{
+namespace detail
+{
+
+// The binary image of a configuration is made of:
+//   - the header (see BinaryHeader)
+//   - the offsets of the strings in the character data (strings + 1 words)
+//   - the string indexes of the plugins (plugins words)
+//   - the parts (parts * BinaryPart)
+//   - the attributes (attributes * BinaryAttribute)
+//   - the wires (wires * BinaryWire)
+//   - the character data of the strings
+// All the fields are 32 bits words in the byte order of the machine that
+// compiled the image, and the strings are referred by their index.
+// The string with index 0 is always the empty string.
+// The checksum covers all the bytes following the header.
+// The header records the absolute path, the size and the checksum of the
+// source file compiled into the image, so that a stale image can be detected.
+
+typedef cxx0x::uint32_t BinaryWord;
+
+struct BinaryHeader
+{
+    char magic[ 8 ];
+    BinaryWord version;
+    BinaryWord byteOrder;
+    BinaryWord size; // of the whole image, in bytes
+    BinaryWord checksum;
+    BinaryWord strings;
+    BinaryWord plugins;
+    BinaryWord parts;
+    BinaryWord attributes;
+    BinaryWord wires;
+    BinaryWord source; // string index of the absolute path of the source file
+    BinaryWord sourceSize; // in bytes (modulo 2^32)
+    BinaryWord sourceChecksum;
+};
+
+struct BinaryPart
+{
+    BinaryWord name;
+    BinaryWord cl;
+    BinaryWord parameters; // number of constructor parameters
+    BinaryWord type1;
+    BinaryWord value1;
+    BinaryWord type2;
+    BinaryWord value2;
+    BinaryWord firstAttribute;
+    BinaryWord attributes;
+    BinaryWord flags; // see Flag
+    enum Flag { shared = 1 };
+};
+
+struct BinaryAttribute
+{
+    BinaryWord name;
+    BinaryWord value;
+};
+
+struct BinaryWire
+{
+    BinaryWord source;
+    BinaryWord dest;
+    BinaryWord collaborator;
+};
+
+struct BinaryFormat
+{
+    static const char* Magic() { return "WALLAROO"; }
+    static BinaryWord Version() { return 4; }
+    static BinaryWord ByteOrder() { return 0x01020304; }
+
+    // FNV-1a hash of the bytes in [begin, end)
+    static BinaryWord Checksum( const char* begin, const char* end )
+    {
+        BinaryWord hash = 2166136261U;
+        for ( ; begin != end; ++begin )
+        {
+            hash ^= static_cast< unsigned char >( *begin );
+            hash *= 16777619U;
+        }
+        return hash;
+    }
+};
+
+// This class collects the items of a configuration file (it's a sink
+// for CfgBuilder) and writes the binary image of the configuration.
+class BinaryImageWriter
+{
+public:
+    BinaryImageWriter() : source( 0 ), sourceSize( 0 ), sourceChecksum( 0 )
+    {
+        Intern( std::string() ); // index 0
+    }
+
+    // record the name and the content of the source file of the image
+    void OnSource( const std::string& name, const std::string& content )
+    {
+        source = Intern( name );
+        sourceSize = static_cast< BinaryWord >( content.size() );
+        sourceChecksum = BinaryFormat::Checksum( content.data(), content.data() + content.size() );
+    }
+
+    void OnPlugin( const std::string& shared )
+    {
+        plugins.push_back( Intern( shared ) );
+    }
+
+    void OnPart( const PartDesc& desc )
+    {
+        BinaryPart part;
+        part.name = Intern( desc.name );
+        part.cl = Intern( desc.cl );
+        part.parameters = ( desc.parameter1.present ? ( desc.parameter2.present ? 2 : 1 ) : 0 );
+        part.type1 = Intern( desc.parameter1.type );
+        part.value1 = Intern( desc.parameter1.value );
+        part.type2 = Intern( desc.parameter2.type );
+        part.value2 = Intern( desc.parameter2.value );
+        part.firstAttribute = Count( attributes );
+        part.attributes = static_cast< BinaryWord >( desc.attributes.size() );
+        part.flags = ( desc.shared ? BinaryPart::shared : 0 );
+        for (
+            std::vector< PartDesc::AttributeDesc >::const_iterator i = desc.attributes.begin();
+            i != desc.attributes.end();
+            ++i
+        )
+        {
+            BinaryAttribute attribute;
+            attribute.name = Intern( i -> first );
+            attribute.value = Intern( i -> second );
+            attributes.push_back( attribute );
+        }
+        parts.push_back( part );
+    }
+
+    void OnWire( const WireDesc& desc )
+    {
+        BinaryWire wire;
+        wire.source = Intern( desc.source );
+        wire.dest = Intern( desc.dest );
+        wire.collaborator = Intern( desc.collaborator );
+        wires.push_back( wire );
+    }
+
+    // write the image on the stream @c out.
+    // throw WrongFile if the image cannot be written.
+    void Write( std::ostream& out ) const
+    {
+        std::vector< BinaryWord > offsets;
+        offsets.reserve( strings.size() + 1 );
+        std::string chars;
+        for ( std::vector< std::string >::const_iterator i = strings.begin(); i != strings.end(); ++i )
+        {
+            offsets.push_back( Count( chars ) );
+            chars += *i;
+        }
+        offsets.push_back( Count( chars ) );
+
+        std::string payload;
+        Append( payload, offsets );
+        Append( payload, plugins );
+        Append( payload, parts );
+        Append( payload, attributes );
+        Append( payload, wires );
+        payload += chars;
+        if ( payload.size() + sizeof( BinaryHeader ) > 0xFFFFFFFFU ) throw WrongFile( "the binary image is too big" );
+
+        BinaryHeader header;
+        std::memcpy( header.magic, BinaryFormat::Magic(), sizeof( header.magic ) );
+        header.version = BinaryFormat::Version();
+        header.byteOrder = BinaryFormat::ByteOrder();
+        header.size = static_cast< BinaryWord >( sizeof( BinaryHeader ) + payload.size() );
+        header.checksum = BinaryFormat::Checksum( payload.data(), payload.data() + payload.size() );
+        header.strings = Count( strings );
+        header.plugins = Count( plugins );
+        header.parts = Count( parts );
+        header.attributes = Count( attributes );
+        header.wires = Count( wires );
+        header.source = source;
+        header.sourceSize = sourceSize;
+        header.sourceChecksum = sourceChecksum;
+
+        out.write( reinterpret_cast< const char* >( &header ), sizeof( header ) );
+        out.write( payload.data(), payload.size() );
+        if ( ! out ) throw WrongFile( "cannot write the binary image" );
+    }
+
+private:
+    BinaryWord Intern( const std::string& s )
+    {
+        Index::const_iterator i = index.find( s );
+        if ( i != index.end() ) return i -> second;
+        const BinaryWord id = Count( strings );
+        strings.push_back( s );
+        index.insert( std::make_pair( s, id ) );
+        return id;
+    }
+
+    template < typename C >
+    static BinaryWord Count( const C& container )
+    {
+        if ( container.size() > 0xFFFFFFFFU ) throw WrongFile( "the binary image is too big" );
+        return static_cast< BinaryWord >( container.size() );
+    }
+
+    template < typename T >
+    static void Append( std::string& payload, const std::vector< T >& table )
+    {
+        if ( ! table.empty() )
+            payload.append( reinterpret_cast< const char* >( &table[ 0 ] ), table.size() * sizeof( T ) );
+    }
+
+    typedef cxx0x::unordered_map< std::string, BinaryWord > Index;
+    Index index;
+    BinaryWord source;
+    BinaryWord sourceSize;
+    BinaryWord sourceChecksum;
+    std::vector< std::string > strings;
+    std::vector< BinaryWord > plugins;
+    std::vector< BinaryPart > parts;
+    std::vector< BinaryAttribute > attributes;
+    std::vector< BinaryWire > wires;
+};
+
+// This class gives access to the tables of a binary image in memory.
+// The image is validated by the constructor, so that the accessors
+// don't need to check the indexes.
+class BinaryImage
+{
+public:
+    // throw WrongFile if the image is not valid, has been compiled
+    // for another version of the format or on a machine with a different byte order.
+    BinaryImage( const char* data, std::size_t size, const std::string& name )
+    {
+        if ( size < sizeof( BinaryHeader ) ) Error( name, "too short" );
+        header = reinterpret_cast< const BinaryHeader* >( data );
+        if ( std::memcmp( header -> magic, BinaryFormat::Magic(), sizeof( header -> magic ) ) != 0 )
+            Error( name, "not a binary configuration" );
+        if ( header -> byteOrder != BinaryFormat::ByteOrder() ) Error( name, "wrong byte order" );
+        if ( header -> version != BinaryFormat::Version() ) Error( name, "wrong version" );
+        if ( header -> size != size ) Error( name, "wrong size" );
+        if ( header -> checksum != BinaryFormat::Checksum( data + sizeof( BinaryHeader ), data + size ) )
+            Error( name, "wrong checksum" );
+
+        // the tables
+        const char* end = data + size;
+        const char* p = data + sizeof( BinaryHeader );
+        offsets = Table< BinaryWord >( p, end, static_cast< std::size_t >( header -> strings ) + 1, name );
+        plugins = Table< BinaryWord >( p, end, header -> plugins, name );
+        parts = Table< BinaryPart >( p, end, header -> parts, name );
+        attributes = Table< BinaryAttribute >( p, end, header -> attributes, name );
+        wires = Table< BinaryWire >( p, end, header -> wires, name );
+        chars = p;
+
+        // the indexes
+        if ( header -> strings == 0 || offsets[ 0 ] != 0 || offsets[ 1 ] != 0 ) Error( name, "wrong string table" );
+        for ( BinaryWord i = 0; i < header -> strings; ++i )
+            if ( offsets[ i + 1 ] < offsets[ i ] ) Error( name, "wrong string table" );
+        if ( offsets[ header -> strings ] != static_cast< std::size_t >( end - chars ) ) Error( name, "wrong string table" );
+        CheckString( header -> source, name );
+        for ( BinaryWord i = 0; i < header -> plugins; ++i )
+            CheckString( plugins[ i ], name );
+        for ( BinaryWord i = 0; i < header -> parts; ++i )
+        {
+            const BinaryPart& part = parts[ i ];
+            CheckString( part.name, name );
+            CheckString( part.cl, name );
+            CheckString( part.type1, name );
+            CheckString( part.value1, name );
+            CheckString( part.type2, name );
+            CheckString( part.value2, name );
+            if ( part.parameters > 2 ) Error( name, "wrong part table" );
+            if ( part.firstAttribute > header -> attributes || part.attributes > header -> attributes - part.firstAttribute )
+                Error( name, "wrong part table" );
+        }
+        for ( BinaryWord i = 0; i < header -> attributes; ++i )
+        {
+            CheckString( attributes[ i ].name, name );
+            CheckString( attributes[ i ].value, name );
+        }
+        for ( BinaryWord i = 0; i < header -> wires; ++i )
+        {
+            CheckString( wires[ i ].source, name );
+            CheckString( wires[ i ].dest, name );
+            CheckString( wires[ i ].collaborator, name );
+        }
+    }
+
+    // the name of the source file and the size and checksum of its content
+    // when the image was compiled
+    std::string Source() const { return String( header -> source ); }
+    BinaryWord SourceSize() const { return header -> sourceSize; }
+    BinaryWord SourceChecksum() const { return header -> sourceChecksum; }
+
+    BinaryWord Strings() const { return header -> strings; }
+    std::string String( BinaryWord i ) const { return std::string( chars + offsets[ i ], chars + offsets[ i + 1 ] ); }
+    StringView View( BinaryWord i ) const { return StringView( chars + offsets[ i ], offsets[ i + 1 ] - offsets[ i ] ); }
+
+    BinaryWord Plugins() const { return header -> plugins; }
+    BinaryWord Plugin( BinaryWord i ) const { return plugins[ i ]; }
+
+    BinaryWord Parts() const { return header -> parts; }
+    const BinaryPart& Part( BinaryWord i ) const { return parts[ i ]; }
+
+    const BinaryAttribute& Attribute( BinaryWord i ) const { return attributes[ i ]; }
+
+    BinaryWord Wires() const { return header -> wires; }
+    const BinaryWire& Wire( BinaryWord i ) const { return wires[ i ]; }
+
+private:
+    template < typename T >
+    static const T* Table( const char*& p, const char* end, std::size_t count, const std::string& name )
+    {
+        if ( count > static_cast< std::size_t >( end - p ) / sizeof( T ) ) Error( name, "wrong size" );
+        const T* table = reinterpret_cast< const T* >( p );
+        p += count * sizeof( T );
+        return table;
+    }
+
+    void CheckString( BinaryWord i, const std::string& name ) const
+    {
+        if ( i >= header -> strings ) Error( name, "wrong string index" );
+    }
+
+    static void Error( const std::string& name, const std::string& msg )
+    {
+        throw WrongFile( name + ": " + msg );
+    }
+
+    const BinaryHeader* header;
+    const BinaryWord* offsets;
+    const BinaryWord* plugins;
+    const BinaryPart* parts;
+    const BinaryAttribute* attributes;
+    const BinaryWire* wires;
+    const char* chars;
+};
+
+} // namespace detail
+} // namespace wallaroo
+
+#endif // WALLAROO_DETAIL_BINARYIMAGE_H_
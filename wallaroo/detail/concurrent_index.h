@@ -0,0 +1,158 @@
+/*******************************************************************************
+ * wallaroo - A library for configurable creation and wiring of C++ classes.
+ * Copyright (C) 2012 Daniele Pallastrelli
+ *
+ * This file is part of wallaroo.
+ * For more information, see http://wallaroo.googlecode.com/
+ *
+ * Boost Software License - Version 1.0 - August 17th, 2003
+ *
+ * Permission is hereby granted, free of charge, to any person or organization
+ * obtaining a copy of the software and accompanying documentation covered by
+ * this license (the "Software") to use, reproduce, display, distribute,
+ * execute, and transmit the Software, and to prepare derivative works of the
+ * Software, and to permit third-parties to whom the Software is furnished to
+ * do so, all subject to the following:
+ *
+ * The copyright notices in the Software and this entire statement, including
+ * the above license grant, this restriction and the following disclaimer,
+ * must be included in all copies of the Software, in whole or in part, and
+ * all derivative works of the Software, unless such copies or derivative
+ * works are solely in the form of machine-executable object code generated by
+ * a source language processor.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT
+ * SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE
+ * FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE,
+ * ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ ******************************************************************************/
+
+#ifndef WALLAROO_DETAIL_CONCURRENT_INDEX_H_
+#define WALLAROO_DETAIL_CONCURRENT_INDEX_H_
+
+#include <cstddef>
+#include "wallaroo/cxx0x.h"
+
+namespace wallaroo
+{
+namespace detail
+{
+
+// An insert-only hash index of pointers to immutable items, that can be
+// read by any number of threads while one thread at a time inserts.
+// The lookups are wait-free: they never lock, and an item becomes visible
+// only after it has been completely built (the pointer is published
+// with release semantics).
+// The index does not own the items. When the index grows, the previous
+// slot arrays are kept until the destruction of the index, because some
+// reader could still be probing them (their total size is less than the
+// size of the current array).
+template < typename T >
+class ConcurrentIndex
+{
+public:
+    ConcurrentIndex() : table( new Table( 16, NULL ) ), size( 0 ) {}
+
+    ~ConcurrentIndex()
+    {
+        const Table* t = table.load( cxx0x::memory_order_relaxed );
+        while ( t != NULL )
+        {
+            const Table* previous = t -> previous;
+            delete t;
+            t = previous;
+        }
+    }
+
+    // Look for the item having hash value @c hash for which @c match returns true.
+    // Return NULL if there is no such item.
+    template < typename Match >
+    const T* Find( std::size_t hash, const Match& match ) const
+    {
+        const Table* t = table.load( cxx0x::memory_order_acquire );
+        for ( std::size_t i = hash & t -> mask; ; i = ( i + 1 ) & t -> mask )
+        {
+            const T* item = t -> slots[ i ].item.load( cxx0x::memory_order_acquire );
+            if ( item == NULL ) return NULL;
+            if ( t -> slots[ i ].hash == hash && match( *item ) ) return item;
+        }
+    }
+
+    // Add @c item, having hash value @c hash.
+    // The inserts must be serialized by the caller, and @c item must not be
+    // already in the index.
+    void Insert( std::size_t hash, const T* item )
+    {
+        Table* t = table.load( cxx0x::memory_order_relaxed );
+        if ( ( size + 1 ) * 2 > t -> mask + 1 ) // keep the load factor under 1/2
+        {
+            Table* bigger = new Table( ( t -> mask + 1 ) * 2, t );
+            for ( std::size_t i = 0; i <= t -> mask; ++i )
+            {
+                const T* old = t -> slots[ i ].item.load( cxx0x::memory_order_relaxed );
+                if ( old != NULL ) bigger -> Put( t -> slots[ i ].hash, old );
+            }
+            table.store( bigger, cxx0x::memory_order_release );
+            t = bigger;
+        }
+        t -> Put( hash, item );
+        ++size;
+    }
+
+    // The number of items in the index.
+    std::size_t Size() const { return size; }
+
+private:
+
+    struct Slot
+    {
+        cxx0x::atomic< const T* > item;
+        std::size_t hash; // written before item is published
+    };
+
+    struct Table
+    {
+        // @c capacity must be a power of 2
+        Table( std::size_t capacity, const Table* p ) :
+            mask( capacity - 1 ),
+            slots( new Slot[ capacity ] ),
+            previous( p )
+        {
+            for ( std::size_t i = 0; i < capacity; ++i )
+            {
+                slots[ i ].item.store( NULL, cxx0x::memory_order_relaxed );
+                slots[ i ].hash = 0;
+            }
+        }
+        ~Table() { delete[] slots; }
+        void Put( std::size_t hash, const T* item )
+        {
+            std::size_t i = hash & mask;
+            while ( slots[ i ].item.load( cxx0x::memory_order_relaxed ) != NULL )
+                i = ( i + 1 ) & mask;
+            slots[ i ].hash = hash;
+            slots[ i ].item.store( item, cxx0x::memory_order_release );
+        }
+        const std::size_t mask;
+        Slot* const slots;
+        const Table* const previous;
+    private:
+        Table( const Table& );
+        Table& operator = ( const Table& );
+    };
+
+    cxx0x::atomic< Table* > table;
+    std::size_t size; // accessed only by the inserting thread
+
+    // copy ctor and assignment operator disabled
+    ConcurrentIndex( const ConcurrentIndex& );
+    ConcurrentIndex& operator = ( const ConcurrentIndex& );
+};
+
+} // namespace detail
+} // namespace wallaroo
+
+#endif // WALLAROO_DETAIL_CONCURRENT_INDEX_H_
@@ -0,0 +1,515 @@
+/*******************************************************************************
+ * wallaroo - A library for configurable creation and wiring of C++ classes.
+ * Copyright (C) 2012 Daniele Pallastrelli
+ *
+ * This file is part of wallaroo.
+ * For more information, see http://wallaroo.googlecode.com/
+ *
+ * Boost Software License - Version 1.0 - August 17th, 2003
+ *
+ * Permission is hereby granted, free of charge, to any person or organization
+ * obtaining a copy of the software and accompanying documentation covered by
+ * this license (the "Software") to use, reproduce, display, distribute,
+ * execute, and transmit the Software, and to prepare derivative works of the
+ * Software, and to permit third-parties to whom the Software is furnished to
+ * do so, all subject to the following:
+ *
+ * The copyright notices in the Software and this entire statement, including
+ * the above license grant, this restriction and the following disclaimer,
+ * must be included in all copies of the Software, in whole or in part, and
+ * all derivative works of the Software, unless such copies or derivative
+ * works are solely in the form of machine-executable object code generated by
+ * a source language processor.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT
+ * SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE
+ * FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE,
+ * ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ ******************************************************************************/
+
+#ifndef WALLAROO_DETAIL_DEPENDENCY_GRAPH_H_
+#define WALLAROO_DETAIL_DEPENDENCY_GRAPH_H_
+
+#include <string>
+#include <vector>
+#include <set>
+#include <utility>
+#include <algorithm>
+#include <exception>
+#include <cstddef>
+#include "wallaroo/cxx0x.h"
+#include "wallaroo/part.h"
+#include "wallaroo/exceptions.h"
+#include "wallaroo/detail/thread_pool.h"
+
+#ifdef WALLAROO_HAS_CXX0X
+    #include <chrono>
+#else
+    #include <boost/chrono.hpp>
+#endif
+
+namespace wallaroo
+{
+namespace detail
+{
+
+// This class builds the graph of the dependencies among a set of parts
+// (a part depends on the parts linked to its collaborators) and calls
+// a method on every part after the parts it depends on (Init, Start)
+// or before them (Stop).
+// The parts linked to a collaborator but not in the set are ignored.
+// The parts are visited in name order whenever there is a choice,
+// so that the sequential visits and the cycles reported are deterministic.
+// The sequential visits accept cyclic dependencies: when only parts in
+// a cycle (or depending on one) are left, the first part in name order
+// whose dependencies left are all in its own cycle is visited.
+class DependencyGraph
+{
+public:
+    typedef std::vector< std::pair< std::string, cxx0x::shared_ptr< Part > > > Parts;
+    typedef void ( Part::*Method )();
+
+    // @c parts must be sorted by name
+    explicit DependencyGraph( const Parts& _parts ) :
+        parts( _parts ),
+        dependencies( parts.size() ),
+        dependents( parts.size() ),
+        pool( NULL ),
+        after( NULL ),
+        method( NULL ),
+        running( 0 )
+    {
+        typedef cxx0x::unordered_map< const Part*, std::size_t > Index;
+        Index index;
+        for ( std::size_t i = 0; i < parts.size(); ++i )
+            index[ parts[ i ].second.get() ] = i;
+
+        std::vector< Part* > targets;
+        for ( std::size_t i = 0; i < parts.size(); ++i )
+        {
+            targets.clear();
+            parts[ i ].second -> Collaborators( targets );
+            for ( std::vector< Part* >::const_iterator t = targets.begin(); t != targets.end(); ++t )
+            {
+                Index::const_iterator j = index.find( *t );
+                if ( j != index.end() ) dependencies[ i ].push_back( j -> second );
+            }
+            std::sort( dependencies[ i ].begin(), dependencies[ i ].end() );
+            dependencies[ i ].erase( std::unique( dependencies[ i ].begin(), dependencies[ i ].end() ), dependencies[ i ].end() );
+            for ( std::size_t d = 0; d < dependencies[ i ].size(); ++d )
+                dependents[ dependencies[ i ][ d ] ].push_back( i );
+        }
+    }
+
+    // throw CyclicDependencyError if the dependencies contain a cycle
+    void CheckCycles() const
+    {
+        std::vector< std::size_t > pending = Pending( dependencies );
+        std::set< std::size_t > ready = Ready( pending );
+        while ( ! ready.empty() )
+        {
+            const std::size_t i = *ready.begin();
+            ready.erase( ready.begin() );
+            Release( i, dependents, pending, ready );
+        }
+
+        // every part left has a dependency left: follow the first one until a part repeats
+        std::size_t start = 0;
+        while ( start < parts.size() && pending[ start ] == 0 ) ++start;
+        if ( start == parts.size() ) return;
+        std::vector< std::size_t > path;
+        std::vector< bool > visited( parts.size(), false );
+        for ( std::size_t i = start; ! visited[ i ]; )
+        {
+            visited[ i ] = true;
+            path.push_back( i );
+            std::size_t next = 0;
+            while ( pending[ dependencies[ i ][ next ] ] == 0 ) ++next;
+            i = dependencies[ i ][ next ];
+            if ( visited[ i ] ) path.push_back( i );
+        }
+        std::vector< std::string > cycle;
+        for ( std::size_t i = std::find( path.begin(), path.end(), path.back() ) - path.begin(); i < path.size(); ++i )
+            cycle.push_back( parts[ path[ i ] ].first );
+        throw CyclicDependencyError( cycle );
+    }
+
+    // Call @c m on the parts on the calling thread, each part after the parts
+    // it depends on (the cycles are broken as described above).
+    // The first exception thrown by a part is propagated.
+    void Forward( Method m )
+    {
+        Sequential( m, dependencies, dependents );
+    }
+
+    // Call @c m on the parts on the calling thread, each part before the parts
+    // it depends on (the cycles are broken as described above).
+    // The first exception thrown by a part is propagated.
+    void Backward( Method m )
+    {
+        Sequential( m, dependents, dependencies );
+    }
+
+    // Call @c m on the parts on a pool of @c threads threads, each part after
+    // the parts it depends on: the parts that don't depend on each other are
+    // visited concurrently.
+    // If a part throws, the parts depending on it are not visited, while the others are.
+    // throw CyclicDependencyError if the dependencies contain a cycle.
+    // Return the names of the parts that threw and the messages, and the names
+    // of the parts not visited because of them with the message @c skipped,
+    // sorted by name.
+    PartsError::Failures Forward( Method m, std::size_t threads, const std::string& skipped )
+    {
+        CheckCycles();
+        method = m;
+        after = &dependents;
+        pending = Pending( dependencies );
+        launched.assign( parts.size(), false );
+        {
+            ThreadPool threadPool( threads );
+            cxx0x::unique_lock< cxx0x::mutex > lock( mutex );
+            pool = &threadPool;
+            const std::set< std::size_t > ready = Ready( pending );
+            for ( std::set< std::size_t >::const_iterator i = ready.begin(); i != ready.end(); ++i )
+                Launch( *i );
+            while ( running > 0 )
+                finished.wait( lock );
+            pool = NULL;
+        }
+        for ( std::size_t i = 0; i < parts.size(); ++i )
+            if ( ! launched[ i ] ) failures.push_back( PartsError::Failure( parts[ i ].first, skipped ) );
+        std::sort( failures.begin(), failures.end() );
+        return failures;
+    }
+
+    // Call @c m on the parts, each part before the parts it depends on, running
+    // at most @c threads calls at the same time (each one on its own thread).
+    // If a call doesn't return within @c timeout milliseconds, the part is
+    // considered done and its thread is left running: the thread keeps
+    // the part and all the parts reachable through its collaborators alive
+    // until the call returns, so it can outlive the owner of the parts.
+    // A part that throws or times out is considered done as well, so that
+    // all the parts are visited in a bounded time.
+    // throw CyclicDependencyError if the dependencies contain a cycle.
+    // Return the names of the parts that threw or timed out (with the message
+    // "timeout") and the messages, sorted by name.
+    PartsError::Failures Backward( Method m, std::size_t threads, unsigned long timeout )
+    {
+        CheckCycles();
+        if ( threads == 0 ) threads = 1;
+        typedef cxx0x::chrono::steady_clock Clock;
+        const cxx0x::shared_ptr< DetachedState > state( new DetachedState( parts.size() ) );
+        std::vector< Clock::time_point > deadlines( parts.size() );
+        std::vector< std::size_t > active; // the parts whose call is in progress
+        std::vector< std::size_t > left = Pending( dependents );
+        std::set< std::size_t > ready = Ready( left );
+        PartsError::Failures errors;
+
+        cxx0x::unique_lock< cxx0x::mutex > lock( state -> mutex );
+        while ( true )
+        {
+            while ( active.size() < threads && ! ready.empty() )
+            {
+                const std::size_t i = *ready.begin();
+                ready.erase( ready.begin() );
+                state -> status[ i ] = DetachedState::running;
+                deadlines[ i ] = Clock::now() + cxx0x::chrono::milliseconds( timeout );
+                active.push_back( i );
+                cxx0x::thread( DetachedCall( state, parts[ i ].second, m, i ) ).detach();
+            }
+            if ( active.empty() ) break;
+
+            Clock::time_point first = deadlines[ active.front() ];
+            for ( std::size_t a = 1; a < active.size(); ++a )
+                first = std::min( first, deadlines[ active[ a ] ] );
+            state -> changed.wait_until( lock, first );
+
+            const Clock::time_point now = Clock::now();
+            for ( std::size_t a = 0; a < active.size(); )
+            {
+                const std::size_t i = active[ a ];
+                if ( state -> status[ i ] == DetachedState::running && now >= deadlines[ i ] )
+                {
+                    state -> status[ i ] = DetachedState::abandoned;
+                    Reachable( parts[ i ].second, state -> kept[ i ] );
+                    errors.push_back( PartsError::Failure( parts[ i ].first, "timeout" ) );
+                }
+                else if ( state -> status[ i ] == DetachedState::failed )
+                    errors.push_back( PartsError::Failure( parts[ i ].first, state -> errors[ i ] ) );
+                else if ( state -> status[ i ] == DetachedState::running )
+                {
+                    ++a;
+                    continue;
+                }
+                active.erase( active.begin() + a );
+                Release( i, dependencies, left, ready );
+            }
+        }
+        lock.unlock();
+
+        std::sort( errors.begin(), errors.end() );
+        return errors;
+    }
+
+private:
+
+    typedef std::vector< std::vector< std::size_t > > Adjacency;
+
+    // the state shared with the detached threads of Backward
+    struct DetachedState
+    {
+        enum Status { waiting, running, done, failed, abandoned };
+        explicit DetachedState( std::size_t size ) : status( size, waiting ), errors( size ), kept( size ) {}
+        cxx0x::mutex mutex;
+        cxx0x::condition_variable changed;
+        std::vector< Status > status;
+        std::vector< std::string > errors;
+        // the parts kept alive for an abandoned call, until it returns
+        std::vector< std::vector< cxx0x::shared_ptr< Part > > > kept;
+    };
+
+    // a call executed on a detached thread
+    struct DetachedCall
+    {
+        DetachedCall( const cxx0x::shared_ptr< DetachedState >& s, const cxx0x::shared_ptr< Part >& p, Method m, std::size_t i ) :
+            state( s ), part( p ), method( m ), index( i )
+        {
+        }
+        void operator()()
+        {
+            std::string error;
+            const bool ok = Call( *part, method, error );
+            std::vector< cxx0x::shared_ptr< Part > > kept; // released after the unlock
+            cxx0x::lock_guard< cxx0x::mutex > lock( state -> mutex );
+            if ( state -> status[ index ] == DetachedState::abandoned )
+            {
+                kept.swap( state -> kept[ index ] );
+                return;
+            }
+            state -> status[ index ] = ( ok ? DetachedState::done : DetachedState::failed );
+            state -> errors[ index ] = error;
+            state -> changed.notify_all();
+        }
+        cxx0x::shared_ptr< DetachedState > state;
+        cxx0x::shared_ptr< Part > part;
+        Method method;
+        std::size_t index;
+    };
+
+    // the parts reachable from @c part through the collaborators (@c part included)
+    static void Reachable( const cxx0x::shared_ptr< Part >& part, std::vector< cxx0x::shared_ptr< Part > >& result )
+    {
+        std::set< const Part* > visited;
+        std::vector< cxx0x::shared_ptr< Part > > toVisit( 1, part );
+        while ( ! toVisit.empty() )
+        {
+            const cxx0x::shared_ptr< Part > p = toVisit.back();
+            toVisit.pop_back();
+            if ( ! visited.insert( p.get() ).second ) continue;
+            result.push_back( p );
+            p -> LinkedParts( toVisit );
+        }
+    }
+
+    struct PoolTask
+    {
+        PoolTask( DependencyGraph* g, std::size_t i ) : graph( g ), index( i ) {}
+        void operator()() { graph -> Run( index ); }
+        DependencyGraph* graph;
+        std::size_t index;
+    };
+
+    // call @c m on @c part. Return false and the message in @c error if it throws.
+    static bool Call( Part& part, Method m, std::string& error )
+    {
+        try
+        {
+            ( part.*m )();
+            return true;
+        }
+        catch ( const std::exception& e )
+        {
+            error = e.what();
+        }
+        catch ( ... )
+        {
+            error = "unknown exception";
+        }
+        return false;
+    }
+
+    void Sequential( Method m, const Adjacency& before, const Adjacency& next )
+    {
+        std::vector< std::size_t > left = Pending( before );
+        std::set< std::size_t > ready = Ready( left );
+        std::vector< bool > visited( parts.size(), false );
+        std::vector< std::size_t > components; // computed at the first cycle
+        for ( std::size_t visits = 0; visits < parts.size(); ++visits )
+        {
+            std::size_t i = 0;
+            if ( ready.empty() )
+            {
+                if ( components.empty() ) components = Components();
+                i = BreakCycle( before, visited, components );
+            }
+            else
+            {
+                i = *ready.begin();
+                ready.erase( ready.begin() );
+            }
+            visited[ i ] = true;
+            ( *parts[ i ].second.*m )();
+            for ( std::size_t n = 0; n < next[ i ].size(); ++n )
+            {
+                const std::size_t j = next[ i ][ n ];
+                if ( --left[ j ] == 0 && ! visited[ j ] ) ready.insert( j );
+            }
+        }
+    }
+
+    // the part to visit when every part left waits for another one: the first
+    // in name order whose parts left in @c before are all in its own cycle
+    std::size_t BreakCycle( const Adjacency& before, const std::vector< bool >& visited, const std::vector< std::size_t >& components ) const
+    {
+        std::vector< bool > blocked( parts.size(), false ); // by component
+        for ( std::size_t i = 0; i < parts.size(); ++i )
+        {
+            if ( visited[ i ] ) continue;
+            for ( std::size_t b = 0; b < before[ i ].size(); ++b )
+            {
+                const std::size_t j = before[ i ][ b ];
+                if ( ! visited[ j ] && components[ j ] != components[ i ] ) blocked[ components[ i ] ] = true;
+            }
+        }
+        std::size_t i = 0;
+        while ( visited[ i ] || blocked[ components[ i ] ] ) ++i;
+        return i;
+    }
+
+    // the strongly connected components of the dependencies (with the
+    // Tarjan's algorithm, without recursion): the parts in the same cycle
+    // have the same component
+    std::vector< std::size_t > Components() const
+    {
+        const std::size_t none = static_cast< std::size_t >( -1 );
+        std::vector< std::size_t > order( parts.size(), none );
+        std::vector< std::size_t > low( parts.size(), 0 );
+        std::vector< std::size_t > result( parts.size(), none );
+        std::vector< std::size_t > stack;
+        std::vector< bool > stacked( parts.size(), false );
+        std::vector< std::pair< std::size_t, std::size_t > > calls; // part, next dependency
+        std::size_t counter = 0;
+        std::size_t components = 0;
+        for ( std::size_t root = 0; root < parts.size(); ++root )
+        {
+            if ( order[ root ] != none ) continue;
+            calls.push_back( std::make_pair( root, 0 ) );
+            while ( ! calls.empty() )
+            {
+                const std::size_t v = calls.back().first;
+                if ( order[ v ] == none )
+                {
+                    order[ v ] = low[ v ] = counter++;
+                    stack.push_back( v );
+                    stacked[ v ] = true;
+                }
+                if ( calls.back().second < dependencies[ v ].size() )
+                {
+                    const std::size_t w = dependencies[ v ][ calls.back().second++ ];
+                    if ( order[ w ] == none )
+                        calls.push_back( std::make_pair( w, 0 ) );
+                    else if ( stacked[ w ] )
+                        low[ v ] = std::min( low[ v ], order[ w ] );
+                    continue;
+                }
+                if ( low[ v ] == order[ v ] )
+                {
+                    std::size_t w = none;
+                    do
+                    {
+                        w = stack.back();
+                        stack.pop_back();
+                        stacked[ w ] = false;
+                        result[ w ] = components;
+                    } while ( w != v );
+                    ++components;
+                }
+                calls.pop_back();
+                if ( ! calls.empty() )
+                    low[ calls.back().first ] = std::min( low[ calls.back().first ], low[ v ] );
+            }
+        }
+        return result;
+    }
+
+    // the number of parts that must be visited before each part
+    std::vector< std::size_t > Pending( const Adjacency& before ) const
+    {
+        std::vector< std::size_t > result( parts.size() );
+        for ( std::size_t i = 0; i < parts.size(); ++i )
+            result[ i ] = before[ i ].size();
+        return result;
+    }
+
+    // the parts that can be visited first
+    static std::set< std::size_t > Ready( const std::vector< std::size_t >& left )
+    {
+        std::set< std::size_t > result;
+        for ( std::size_t i = 0; i < left.size(); ++i )
+            if ( left[ i ] == 0 ) result.insert( i );
+        return result;
+    }
+
+    // the part @c i has been visited: add to @c ready the parts in @c next that were waiting only for it
+    static void Release( std::size_t i, const Adjacency& next, std::vector< std::size_t >& left, std::set< std::size_t >& ready )
+    {
+        for ( std::size_t n = 0; n < next[ i ].size(); ++n )
+            if ( --left[ next[ i ][ n ] ] == 0 ) ready.insert( next[ i ][ n ] );
+    }
+
+    // post the visit of the part @c i (the mutex must be locked)
+    void Launch( std::size_t i )
+    {
+        launched[ i ] = true;
+        ++running;
+        pool -> Post( PoolTask( this, i ) );
+    }
+
+    // executed by the threads of the pool
+    void Run( std::size_t i )
+    {
+        std::string error;
+        const bool ok = Call( *parts[ i ].second, method, error );
+
+        cxx0x::lock_guard< cxx0x::mutex > lock( mutex );
+        if ( ! ok )
+            failures.push_back( PartsError::Failure( parts[ i ].first, error ) );
+        else
+            for ( std::size_t n = 0; n < ( *after )[ i ].size(); ++n )
+                if ( --pending[ ( *after )[ i ][ n ] ] == 0 ) Launch( ( *after )[ i ][ n ] );
+        if ( --running == 0 ) finished.notify_all();
+    }
+
+    const Parts& parts;
+    Adjacency dependencies; // the parts each part depends on
+    Adjacency dependents; // the parts depending on each part
+
+    // state of the visit on the thread pool
+    cxx0x::mutex mutex;
+    cxx0x::condition_variable finished;
+    ThreadPool* pool;
+    const Adjacency* after;
+    Method method;
+    std::vector< std::size_t > pending;
+    std::vector< bool > launched;
+    std::size_t running;
+    PartsError::Failures failures;
+};
+
+} // namespace detail
+} // namespace wallaroo
+
+#endif // WALLAROO_DETAIL_DEPENDENCY_GRAPH_H_
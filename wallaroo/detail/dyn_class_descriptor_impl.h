@@ -51,7 +51,11 @@ void Deleter( T* obj )
 template < typename T >
 cxx0x::shared_ptr< Part > Builder()
 {
+#ifdef WALLAROO_INTRUSIVE_PARTS
+    return Own( new T );
+#else
     return cxx0x::shared_ptr< Part >( new T, Deleter< T > );
+#endif
 }
 
 }
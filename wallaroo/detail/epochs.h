@@ -0,0 +1,253 @@
+/*******************************************************************************
+ * wallaroo - A library for configurable creation and wiring of C++ classes.
+ * Copyright (C) 2012 Daniele Pallastrelli
+ *
+ * This file is part of wallaroo.
+ * For more information, see http://wallaroo.googlecode.com/
+ *
+ * Boost Software License - Version 1.0 - August 17th, 2003
+ *
+ * Permission is hereby granted, free of charge, to any person or organization
+ * obtaining a copy of the software and accompanying documentation covered by
+ * this license (the "Software") to use, reproduce, display, distribute,
+ * execute, and transmit the Software, and to prepare derivative works of the
+ * Software, and to permit third-parties to whom the Software is furnished to
+ * do so, all subject to the following:
+ *
+ * The copyright notices in the Software and this entire statement, including
+ * the above license grant, this restriction and the following disclaimer,
+ * must be included in all copies of the Software, in whole or in part, and
+ * all derivative works of the Software, unless such copies or derivative
+ * works are solely in the form of machine-executable object code generated by
+ * a source language processor.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT
+ * SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE
+ * FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE,
+ * ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ ******************************************************************************/
+
+#ifndef WALLAROO_DETAIL_EPOCHS_H_
+#define WALLAROO_DETAIL_EPOCHS_H_
+
+#include <vector>
+#include <cstddef>
+#include "wallaroo/cxx0x.h"
+
+// thread_local is missing in the compilers before Visual Studio 2015
+#if defined( WALLAROO_HAS_CXX0X ) && !( defined( _MSC_VER ) && _MSC_VER < 1900 )
+    #define WALLAROO_HAS_THREAD_LOCAL
+#else
+    #include <boost/thread/tss.hpp>
+#endif
+
+namespace wallaroo
+{
+namespace detail
+{
+
+// Epoch based reclamation of the objects replaced while other threads
+// can be reading them (see RcuPtr).
+// A thread reading such objects holds an EpochGuard, that announces the
+// global epoch in a record of the thread: the readers don't lock and
+// don't write any memory shared with other threads.
+// An object replaced is retired with the global epoch of the moment, and
+// destroyed when the global epoch has advanced twice: the epoch advances
+// only when all the threads holding a guard have announced the current one.
+class Epochs
+{
+public:
+    typedef void ( *Destroy )( const void* );
+
+    // Retire the object @c p, replaced by @c owner: @c destroy will be called
+    // when no thread can be reading it.
+    static void Retire( const void* owner, const void* p, Destroy destroy )
+    {
+        State& s = Global();
+        std::vector< Retired > ready;
+        {
+            cxx0x::lock_guard< cxx0x::mutex > lock( s.mutex );
+            s.retired.push_back( Retired( owner, p, destroy, s.epoch.load() ) );
+            // two advances free the object just retired, if nobody is reading
+            if ( Advance( s ) ) Advance( s );
+            const unsigned long epoch = s.epoch.load();
+            for ( std::size_t i = 0; i < s.retired.size(); )
+                if ( s.retired[ i ].epoch + 2 <= epoch ) Take( s.retired, i, ready );
+                else ++i;
+        }
+        // outside of the lock: a destructor can retire other objects
+        for ( std::size_t i = 0; i < ready.size(); ++i )
+            ready[ i ].destroy( ready[ i ].object );
+    }
+
+    // Destroy the objects retired by @c owner, that nobody can read anymore
+    // (i.e., @c owner is being destroyed).
+    static void Release( const void* owner )
+    {
+        State& s = Global();
+        std::vector< Retired > ready;
+        {
+            cxx0x::lock_guard< cxx0x::mutex > lock( s.mutex );
+            for ( std::size_t i = 0; i < s.retired.size(); )
+                if ( s.retired[ i ].owner == owner ) Take( s.retired, i, ready );
+                else ++i;
+        }
+        for ( std::size_t i = 0; i < ready.size(); ++i )
+            ready[ i ].destroy( ready[ i ].object );
+    }
+
+private:
+    friend class EpochGuard;
+
+    // The state of a thread, reused after the thread exits.
+    struct Record
+    {
+        Record() : epoch( 0 ), nesting( 0 ), free( false ), next( NULL ) {}
+        cxx0x::atomic< unsigned long > epoch; // the epoch announced (0 if not reading)
+        unsigned long nesting; // the guards held (accessed only by the thread)
+        cxx0x::atomic< bool > free;
+        Record* next;
+        char padding[ 64 ]; // keep the records of different threads in different cache lines
+    };
+
+    struct Retired
+    {
+        Retired( const void* o, const void* p, Destroy d, unsigned long e ) :
+            owner( o ), object( p ), destroy( d ), epoch( e )
+        {}
+        const void* owner;
+        const void* object;
+        Destroy destroy;
+        unsigned long epoch;
+    };
+
+    struct State
+    {
+        State() : epoch( 1 ), records( NULL ) {}
+        cxx0x::atomic< unsigned long > epoch;
+        cxx0x::atomic< Record* > records; // the list of the records, never freed
+        cxx0x::mutex mutex; // serializes Retire and Release
+        std::vector< Retired > retired;
+    };
+
+    // Release the record when the thread exits.
+    struct Holder
+    {
+        Holder() : record( Acquire() ) {}
+        ~Holder()
+        {
+            record -> epoch.store( 0, cxx0x::memory_order_release );
+            record -> free.store( true, cxx0x::memory_order_release );
+        }
+        Record* const record;
+    };
+
+    // NOTE: the state is never destroyed, because the threads can read
+    //       until the end of the process.
+    static State& Global()
+    {
+        static State* state = new State;
+        return *state;
+    }
+
+    // the record of the calling thread
+    static Record* Local()
+    {
+#ifdef WALLAROO_HAS_THREAD_LOCAL
+        static thread_local Holder holder;
+        return holder.record;
+#else
+        static boost::thread_specific_ptr< Holder > holder;
+        if ( holder.get() == NULL ) holder.reset( new Holder );
+        return holder -> record;
+#endif
+    }
+
+    static Record* Acquire()
+    {
+        State& s = Global();
+        for ( Record* r = s.records.load( cxx0x::memory_order_acquire ); r != NULL; r = r -> next )
+        {
+            bool expected = true;
+            if ( r -> free.load( cxx0x::memory_order_relaxed ) && r -> free.compare_exchange_strong( expected, false ) )
+                return r;
+        }
+        Record* r = new Record;
+        Record* head = s.records.load( cxx0x::memory_order_relaxed );
+        do r -> next = head;
+        while ( ! s.records.compare_exchange_weak( head, r ) );
+        return r;
+    }
+
+    static Record* Enter()
+    {
+        Record* r = Local();
+        Enter( r );
+        return r;
+    }
+
+    // NOTE: the announcement and the reads that follow are sequentially
+    //       consistent with the replacement and the scan of Advance.
+    static void Enter( Record* r )
+    {
+        if ( r -> nesting++ == 0 )
+            r -> epoch.store( Global().epoch.load( cxx0x::memory_order_relaxed ) );
+    }
+
+    static void Leave( Record* r )
+    {
+        if ( --r -> nesting == 0 )
+            r -> epoch.store( 0, cxx0x::memory_order_release );
+    }
+
+    // advance the global epoch if all the readers have announced the current one
+    // (must be called with the mutex locked)
+    static bool Advance( State& s )
+    {
+        const unsigned long epoch = s.epoch.load();
+        for ( const Record* r = s.records.load(); r != NULL; r = r -> next )
+        {
+            const unsigned long e = r -> epoch.load();
+            if ( e != 0 && e != epoch ) return false;
+        }
+        s.epoch.store( epoch + 1 );
+        return true;
+    }
+
+    static void Take( std::vector< Retired >& retired, std::size_t i, std::vector< Retired >& ready )
+    {
+        ready.push_back( retired[ i ] );
+        retired[ i ] = retired.back();
+        retired.pop_back();
+    }
+};
+
+// While a thread holds a guard, the objects it reads from a RcuPtr
+// are not destroyed. The guards can be nested.
+class EpochGuard
+{
+public:
+    EpochGuard() : record( Epochs::Enter() ) {}
+    EpochGuard( const EpochGuard& other ) : record( other.record )
+    {
+        if ( record != NULL ) Epochs::Enter( record );
+    }
+    ~EpochGuard()
+    {
+        if ( record != NULL ) Epochs::Leave( record );
+    }
+    // a guard that doesn't protect anything
+    static EpochGuard None() { return EpochGuard( NULL ); }
+private:
+    explicit EpochGuard( Epochs::Record* r ) : record( r ) {}
+    EpochGuard& operator = ( const EpochGuard& );
+    Epochs::Record* record;
+};
+
+} // namespace detail
+} // namespace wallaroo
+
+#endif // WALLAROO_DETAIL_EPOCHS_H_
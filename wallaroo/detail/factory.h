@@ -33,15 +33,70 @@
 #ifndef WALLAROO_DETAIL_FACTORY_H_
 #define WALLAROO_DETAIL_FACTORY_H_
 
+#include <new>
 #include "wallaroo/cxx0x.h"
 #include "wallaroo/part.h"
+#include "wallaroo/detail/arena.h"
+#include "wallaroo/detail/intrusive_ptr.h"
 
 namespace wallaroo
 {
 namespace detail
 {
 
-// This helper class exports the method to create the class T.
+#ifdef WALLAROO_INTRUSIVE_PARTS
+
+// This helper class exports the methods to create the class T
+// on the heap (Create) or inside an arena (CreateIn).
+// The objects have an intrusive reference count, and the shared_ptr
+// returned owns one reference.
+// Can't use a function because we cannot partial specialize template functions.
+template < class T, class P1, class P2 >
+class Factory
+{
+public:
+    static cxx0x::shared_ptr< Part > Create( const P1& p1, const P2& p2 )
+    {
+        return Own( new T( p1, p2 ) );
+    }
+    static cxx0x::shared_ptr< Part > CreateIn( const cxx0x::shared_ptr< Arena >& arena, const P1& p1, const P2& p2 )
+    {
+        return ArenaOwner< T >::Own( new ( ArenaOwner< T >::Allocate( arena ) ) T( p1, p2 ), arena );
+    }
+};
+
+template < class T, class P >
+class Factory< T, P, void >
+{
+public:
+    static cxx0x::shared_ptr< Part > Create( const P& p )
+    {
+        return Own( new T( p ) );
+    }
+    static cxx0x::shared_ptr< Part > CreateIn( const cxx0x::shared_ptr< Arena >& arena, const P& p )
+    {
+        return ArenaOwner< T >::Own( new ( ArenaOwner< T >::Allocate( arena ) ) T( p ), arena );
+    }
+};
+
+template < class T >
+class Factory< T, void, void >
+{
+public:
+    static cxx0x::shared_ptr< Part > Create()
+    {
+        return Own( new T() );
+    }
+    static cxx0x::shared_ptr< Part > CreateIn( const cxx0x::shared_ptr< Arena >& arena )
+    {
+        return ArenaOwner< T >::Own( new ( ArenaOwner< T >::Allocate( arena ) ) T(), arena );
+    }
+};
+
+#else
+
+// This helper class exports the methods to create the class T
+// on the heap (Create) or inside an arena (CreateIn).
 // Can't use a function because we cannot partial specialize template functions.
 template < class T, class P1, class P2 >
 class Factory
@@ -51,6 +106,10 @@ public:
     {
         return cxx0x::make_shared< T >( p1, p2 );
     }
+    static cxx0x::shared_ptr< Part > CreateIn( const cxx0x::shared_ptr< Arena >& arena, const P1& p1, const P2& p2 )
+    {
+        return cxx0x::allocate_shared< T >( ArenaAllocator< T >( arena ), p1, p2 );
+    }
 };
 
 template < class T, class P >
@@ -61,6 +120,10 @@ public:
     {
         return cxx0x::make_shared< T >( p );
     }
+    static cxx0x::shared_ptr< Part > CreateIn( const cxx0x::shared_ptr< Arena >& arena, const P& p )
+    {
+        return cxx0x::allocate_shared< T >( ArenaAllocator< T >( arena ), p );
+    }
 };
 
 template < class T >
@@ -71,8 +134,14 @@ public:
     {
         return cxx0x::make_shared< T >();
     }
+    static cxx0x::shared_ptr< Part > CreateIn( const cxx0x::shared_ptr< Arena >& arena )
+    {
+        return cxx0x::allocate_shared< T >( ArenaAllocator< T >( arena ) );
+    }
 };
 
+#endif
+
 } // detail namespace
 } // wallaroo namespace
 
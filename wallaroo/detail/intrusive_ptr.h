@@ -0,0 +1,254 @@
+/*******************************************************************************
+ * wallaroo - A library for configurable creation and wiring of C++ classes.
+ * Copyright (C) 2012 Daniele Pallastrelli
+ *
+ * This file is part of wallaroo.
+ * For more information, see http://wallaroo.googlecode.com/
+ *
+ * Boost Software License - Version 1.0 - August 17th, 2003
+ *
+ * Permission is hereby granted, free of charge, to any person or organization
+ * obtaining a copy of the software and accompanying documentation covered by
+ * this license (the "Software") to use, reproduce, display, distribute,
+ * execute, and transmit the Software, and to prepare derivative works of the
+ * Software, and to permit third-parties to whom the Software is furnished to
+ * do so, all subject to the following:
+ *
+ * The copyright notices in the Software and this entire statement, including
+ * the above license grant, this restriction and the following disclaimer,
+ * must be included in all copies of the Software, in whole or in part, and
+ * all derivative works of the Software, unless such copies or derivative
+ * works are solely in the form of machine-executable object code generated by
+ * a source language processor.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT
+ * SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE
+ * FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE,
+ * ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ ******************************************************************************/
+
+#ifndef WALLAROO_DETAIL_INTRUSIVE_PTR_H_
+#define WALLAROO_DETAIL_INTRUSIVE_PTR_H_
+
+#include <cstddef>
+#include "wallaroo/cxx0x.h"
+#include "wallaroo/detail/arena.h"
+
+namespace wallaroo
+{
+namespace detail
+{
+
+#ifdef WALLAROO_INTRUSIVE_PARTS
+
+class RefCounted;
+template < typename T > cxx0x::shared_ptr< T > Own( T* p );
+template < typename T > cxx0x::shared_ptr< T > Adopt( const cxx0x::shared_ptr< T >& p );
+template < typename T > cxx0x::shared_ptr< T > Share( T* p );
+
+// The base class of Part when the parts have an intrusive reference count
+// (WALLAROO_INTRUSIVE_PARTS defined).
+// The object is destroyed when the count drops to zero. The shared_ptr
+// created by wallaroo own a single reference (see Own), while every
+// collaborator linked to the part owns another one.
+// A part allocated elsewhere (i.e., with make_shared) is adopted instead
+// (see Adopt): it keeps alive its original owner until the count drops to zero.
+// If WALLAROO_SINGLE_THREADED is defined, the count is not atomic.
+// NOTE: the shared_ptr created by wallaroo still allocate their control
+//       block, because the catalog hands out shared_ptr: the count saves
+//       the reference counting of the collaborators, not the allocation.
+//       With the arena, the owner and the weak_ptr to that control block,
+//       each part grows by 56 bytes with 64 bit pointers.
+class RefCounted
+{
+public:
+#ifdef WALLAROO_SINGLE_THREADED
+    void AddRef() const
+    {
+        ++refs;
+    }
+    void Release() const
+    {
+        if ( --refs == 0 )
+            const_cast< RefCounted* >( this ) -> Destroy();
+    }
+#else
+    void AddRef() const
+    {
+        refs.fetch_add( 1, cxx0x::memory_order_relaxed );
+    }
+    void Release() const
+    {
+        if ( refs.fetch_sub( 1, cxx0x::memory_order_acq_rel ) == 1 )
+            const_cast< RefCounted* >( this ) -> Destroy();
+    }
+#endif
+
+protected:
+    RefCounted() : refs( 0 ) {}
+    RefCounted( const RefCounted& ) : refs( 0 ) {}
+    RefCounted& operator = ( const RefCounted& ) { return *this; }
+    virtual ~RefCounted() {}
+
+private:
+    template < typename T > friend class ArenaOwner;
+    template < typename T > friend cxx0x::shared_ptr< T > Own( T* p );
+    template < typename T > friend cxx0x::shared_ptr< T > Adopt( const cxx0x::shared_ptr< T >& p );
+    template < typename T > friend cxx0x::shared_ptr< T > Share( T* p );
+    void Destroy()
+    {
+        if ( arena )
+        {
+            // the memory belongs to the arena: keep it alive until the destructor returns
+            const cxx0x::shared_ptr< Arena > keep( arena );
+            this -> ~RefCounted();
+        }
+        else if ( owner )
+        {
+            // the last owner of the part destroys it (when keep goes out of scope)
+            cxx0x::shared_ptr< const void > keep;
+            keep.swap( owner );
+        }
+        else
+            delete this;
+    }
+#ifdef WALLAROO_SINGLE_THREADED
+    mutable long refs;
+#else
+    mutable cxx0x::atomic< long > refs;
+#endif
+    cxx0x::shared_ptr< Arena > arena; // the arena containing the object, if any
+    cxx0x::shared_ptr< const void > owner; // the original owner of an adopted object, if any
+    cxx0x::weak_ptr< const RefCounted > self; // the shared_ptr created with the object (see Share)
+};
+
+// The deleter of the shared_ptr created by Own: it releases the reference
+// owned by the shared_ptr.
+struct ReleaseRef
+{
+    void operator()( const RefCounted* p ) const { p -> Release(); }
+};
+
+// Return a shared_ptr owning a reference of @c p (allocated with new).
+template < typename T >
+cxx0x::shared_ptr< T > Own( T* p )
+{
+    p -> AddRef();
+    const cxx0x::shared_ptr< T > result( p, ReleaseRef() );
+    p -> self = result;
+    return result;
+}
+
+// Return a shared_ptr owning a reference of the object owned by @c p.
+// If @c p has not been created by wallaroo (i.e., with make_shared), the
+// object keeps a copy of @c p until its reference count drops to zero.
+template < typename T >
+cxx0x::shared_ptr< T > Adopt( const cxx0x::shared_ptr< T >& p )
+{
+    if ( ! p || cxx0x::get_deleter< ReleaseRef >( p ) != NULL ) return p;
+    p -> owner = p;
+    return Own( p.get() );
+}
+
+// Return a shared_ptr owning a reference of @c p.
+// It shares the control block of the shared_ptr created with the object,
+// while it exists (i.e., while the part is in its catalog).
+template < typename T >
+cxx0x::shared_ptr< T > Share( T* p )
+{
+    const cxx0x::shared_ptr< const RefCounted > s = p -> self.lock();
+    if ( s ) return cxx0x::shared_ptr< T >( s, p );
+    p -> AddRef();
+    return cxx0x::shared_ptr< T >( p, ReleaseRef() );
+}
+
+// Build the objects of type T inside an arena.
+template < typename T >
+class ArenaOwner
+{
+public:
+    // Return a shared_ptr owning a reference of the object @c p, built inside @c arena.
+    // The control block is allocated in the arena as well.
+    static cxx0x::shared_ptr< T > Own( T* p, const cxx0x::shared_ptr< Arena >& arena )
+    {
+        p -> arena = arena;
+        p -> AddRef();
+        const cxx0x::shared_ptr< T > result( p, ReleaseRef(), ArenaAllocator< T >( arena ) );
+        p -> self = result;
+        return result;
+    }
+    // Return uninitialized memory for an object of type T.
+    static void* Allocate( const cxx0x::shared_ptr< Arena >& arena )
+    {
+        return arena -> Allocate( sizeof( T ), cxx0x::alignment_of< T >::value );
+    }
+};
+
+// A handle that owns a reference of a RefCounted object.
+// It provides the interface of weak_ptr used by wallaroo and by the
+// collections of collaborators (lock, expired), so that the code
+// iterating the collections is the same with and without
+// WALLAROO_INTRUSIVE_PARTS.
+template < typename T >
+class IntrusivePtr
+{
+public:
+    IntrusivePtr() : ptr( NULL ) {}
+    explicit IntrusivePtr( T* p ) : ptr( p ) { if ( ptr ) ptr -> AddRef(); }
+    explicit IntrusivePtr( const cxx0x::shared_ptr< T >& p ) : ptr( p.get() )
+    {
+        if ( ptr ) Adopt( p ) -> AddRef();
+    }
+    IntrusivePtr( const IntrusivePtr& other ) : ptr( other.ptr ) { if ( ptr ) ptr -> AddRef(); }
+    ~IntrusivePtr() { if ( ptr ) ptr -> Release(); }
+    IntrusivePtr& operator = ( const IntrusivePtr& other )
+    {
+        IntrusivePtr tmp( other );
+        T* const p = ptr;
+        ptr = tmp.ptr;
+        tmp.ptr = p;
+        return *this;
+    }
+
+    T* get() const { return ptr; }
+    T* operator -> () const { return ptr; }
+    T& operator * () const { return *ptr; }
+    bool operator ! () const { return ptr == NULL; }
+
+    // the linked object is alive as long as the handle exists
+    bool expired() const { return ptr == NULL; }
+    IntrusivePtr lock() const { return *this; }
+
+    // Return a shared_ptr owning a reference of the object (see Share).
+    operator cxx0x::shared_ptr< T >() const
+    {
+        return ( ptr ? Share( ptr ) : cxx0x::shared_ptr< T >() );
+    }
+
+private:
+    T* ptr;
+};
+
+#else
+
+// The base class of Part (empty when WALLAROO_INTRUSIVE_PARTS is not defined).
+class RefCounted
+{
+};
+
+// Without intrusive reference count, any shared_ptr owns its part.
+template < typename T >
+const cxx0x::shared_ptr< T >& Adopt( const cxx0x::shared_ptr< T >& p )
+{
+    return p;
+}
+
+#endif
+
+} // namespace detail
+} // namespace wallaroo
+
+#endif // WALLAROO_DETAIL_INTRUSIVE_PTR_H_
@@ -0,0 +1,247 @@
+/*******************************************************************************
+ * wallaroo - A library for configurable creation and wiring of C++ classes.
+ * Copyright (C) 2012 Daniele Pallastrelli
+ *
+ * This file is part of wallaroo.
+ * For more information, see http://wallaroo.googlecode.com/
+ *
+ * Boost Software License - Version 1.0 - August 17th, 2003
+ *
+ * Permission is hereby granted, free of charge, to any person or organization
+ * obtaining a copy of the software and accompanying documentation covered by
+ * this license (the "Software") to use, reproduce, display, distribute,
+ * execute, and transmit the Software, and to prepare derivative works of the
+ * Software, and to permit third-parties to whom the Software is furnished to
+ * do so, all subject to the following:
+ *
+ * The copyright notices in the Software and this entire statement, including
+ * the above license grant, this restriction and the following disclaimer,
+ * must be included in all copies of the Software, in whole or in part, and
+ * all derivative works of the Software, unless such copies or derivative
+ * works are solely in the form of machine-executable object code generated by
+ * a source language processor.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT
+ * SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE
+ * FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE,
+ * ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ ******************************************************************************/
+
+#ifndef WALLAROO_DETAIL_JSONSTREAMPARSER_H_
+#define WALLAROO_DETAIL_JSONSTREAMPARSER_H_
+
+#include <string>
+#include <istream>
+#include "streamreader.h"
+
+namespace wallaroo
+{
+namespace detail
+{
+
+// This class parses a json document from a stream, without building it in memory.
+// For each member of an object and for each element of an array
+// (that has an empty key) it calls the methods of a handler:
+//   Open( key ) when the value starts,
+//   Text( text ) if the value is a string, a number, true, false or null,
+//   Close() when the value ends.
+// The members of the root object are reported as the elements at the first level.
+class JsonStreamParser
+{
+public:
+    // @c name is the name of the stream in the error messages.
+    JsonStreamParser( std::istream& s, const std::string& name ) : reader( s, name ) {}
+
+    // Parse the whole document.
+    // throw WrongFile if the document is not well formed.
+    template < typename Handler >
+    void Parse( Handler& handler )
+    {
+        reader.SkipSpaces();
+        const int c = reader.Peek();
+        if ( c != '{' && c != '[' ) reader.Error( "expected object or array" );
+        ParseValue( handler );
+        reader.SkipSpaces();
+        if ( reader.Peek() != StreamReader::End ) reader.Error( "garbage after data" );
+    }
+
+private:
+
+    template < typename Handler >
+    void ParseValue( Handler& handler )
+    {
+        reader.SkipSpaces();
+        const int c = reader.Peek();
+        if ( c == '{' )
+            ParseObject( handler );
+        else if ( c == '[' )
+            ParseArray( handler );
+        else if ( c == '"' )
+            handler.Text( ParseString() );
+        else if ( c == 't' )
+        {
+            reader.Expect( "true" );
+            handler.Text( "true" );
+        }
+        else if ( c == 'f' )
+        {
+            reader.Expect( "false" );
+            handler.Text( "false" );
+        }
+        else if ( c == 'n' )
+        {
+            reader.Expect( "null" );
+            handler.Text( "null" );
+        }
+        else if ( c == '-' || ( c >= '0' && c <= '9' ) )
+            handler.Text( ParseNumber() );
+        else
+            reader.Error( "expected value" );
+    }
+
+    template < typename Handler >
+    void ParseObject( Handler& handler )
+    {
+        reader.Expect( '{' );
+        reader.SkipSpaces();
+        if ( reader.Peek() == '}' )
+        {
+            reader.Get();
+            return;
+        }
+        while ( true )
+        {
+            reader.SkipSpaces();
+            if ( reader.Peek() != '"' ) reader.Error( "expected key string" );
+            handler.Open( ParseString() );
+            reader.SkipSpaces();
+            reader.Expect( ':' );
+            ParseValue( handler );
+            handler.Close();
+            reader.SkipSpaces();
+            const int c = reader.Get();
+            if ( c == '}' ) return;
+            if ( c != ',' ) reader.Error( "expected ',' or '}'" );
+        }
+    }
+
+    template < typename Handler >
+    void ParseArray( Handler& handler )
+    {
+        reader.Expect( '[' );
+        reader.SkipSpaces();
+        if ( reader.Peek() == ']' )
+        {
+            reader.Get();
+            return;
+        }
+        while ( true )
+        {
+            handler.Open( std::string() );
+            ParseValue( handler );
+            handler.Close();
+            reader.SkipSpaces();
+            const int c = reader.Get();
+            if ( c == ']' ) return;
+            if ( c != ',' ) reader.Error( "expected ',' or ']'" );
+        }
+    }
+
+    std::string ParseString()
+    {
+        reader.Expect( '"' );
+        std::string s;
+        for ( int c = reader.Get(); c != '"'; c = reader.Get() )
+        {
+            if ( c == StreamReader::End ) reader.Error( "unterminated string" );
+            if ( c != '\\' )
+            {
+                if ( static_cast< unsigned char >( c ) < 0x20 ) reader.Error( "invalid code sequence" );
+                s += static_cast< char >( c );
+                continue;
+            }
+            switch ( reader.Get() )
+            {
+                case '"': s += '"'; break;
+                case '\\': s += '\\'; break;
+                case '/': s += '/'; break;
+                case 'b': s += '\b'; break;
+                case 'f': s += '\f'; break;
+                case 'n': s += '\n'; break;
+                case 'r': s += '\r'; break;
+                case 't': s += '\t'; break;
+                case 'u':
+                {
+                    unsigned long code = ParseCodeUnit();
+                    if ( code >= 0xD800 && code < 0xDC00 )
+                    {
+                        // surrogate pair
+                        reader.Expect( "\\u" );
+                        const unsigned long low = ParseCodeUnit();
+                        if ( low < 0xDC00 || low >= 0xE000 ) reader.Error( "invalid surrogate pair" );
+                        code = 0x10000 + ( ( code - 0xD800 ) << 10 ) + ( low - 0xDC00 );
+                    }
+                    s += StreamReader::Utf8( code );
+                    break;
+                }
+                default: reader.Error( "invalid escape sequence" );
+            }
+        }
+        return s;
+    }
+
+    unsigned long ParseCodeUnit()
+    {
+        unsigned long code = 0;
+        for ( int i = 0; i < 4; ++i )
+        {
+            const int c = reader.Get();
+            int digit = -1;
+            if ( c >= '0' && c <= '9' ) digit = c - '0';
+            else if ( c >= 'a' && c <= 'f' ) digit = c - 'a' + 10;
+            else if ( c >= 'A' && c <= 'F' ) digit = c - 'A' + 10;
+            if ( digit < 0 ) reader.Error( "invalid escape sequence" );
+            code = code * 16 + digit;
+        }
+        return code;
+    }
+
+    // numbers are reported with their textual representation
+    std::string ParseNumber()
+    {
+        std::string s;
+        if ( reader.Peek() == '-' ) s += static_cast< char >( reader.Get() );
+        if ( ! Digits( s ) ) reader.Error( "expected digits" );
+        if ( reader.Peek() == '.' )
+        {
+            s += static_cast< char >( reader.Get() );
+            if ( ! Digits( s ) ) reader.Error( "need at least one digit after '.'" );
+        }
+        if ( reader.Peek() == 'e' || reader.Peek() == 'E' )
+        {
+            s += static_cast< char >( reader.Get() );
+            if ( reader.Peek() == '+' || reader.Peek() == '-' ) s += static_cast< char >( reader.Get() );
+            if ( ! Digits( s ) ) reader.Error( "need at least one digit in exponent" );
+        }
+        return s;
+    }
+
+    // append the decimal digits that follow to s. Return false if there are none.
+    bool Digits( std::string& s )
+    {
+        const std::size_t size = s.size();
+        for ( int c = reader.Peek(); c >= '0' && c <= '9'; c = reader.Peek() )
+            s += static_cast< char >( reader.Get() );
+        return s.size() > size;
+    }
+
+    StreamReader reader;
+};
+
+} // namespace detail
+} // namespace wallaroo
+
+#endif // WALLAROO_DETAIL_JSONSTREAMPARSER_H_
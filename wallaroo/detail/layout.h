@@ -0,0 +1,358 @@
+/*******************************************************************************
+ * wallaroo - A library for configurable creation and wiring of C++ classes.
+ * Copyright (C) 2012 Daniele Pallastrelli
+ *
+ * This file is part of wallaroo.
+ * For more information, see http://wallaroo.googlecode.com/
+ *
+ * Boost Software License - Version 1.0 - August 17th, 2003
+ *
+ * Permission is hereby granted, free of charge, to any person or organization
+ * obtaining a copy of the software and accompanying documentation covered by
+ * this license (the "Software") to use, reproduce, display, distribute,
+ * execute, and transmit the Software, and to prepare derivative works of the
+ * Software, and to permit third-parties to whom the Software is furnished to
+ * do so, all subject to the following:
+ *
+ * The copyright notices in the Software and this entire statement, including
+ * the above license grant, this restriction and the following disclaimer,
+ * must be included in all copies of the Software, in whole or in part, and
+ * all derivative works of the Software, unless such copies or derivative
+ * works are solely in the form of machine-executable object code generated by
+ * a source language processor.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT
+ * SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE
+ * FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE,
+ * ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ ******************************************************************************/
+
+#ifndef WALLAROO_DETAIL_LAYOUT_H_
+#define WALLAROO_DETAIL_LAYOUT_H_
+
+#include <string>
+#include <vector>
+#include <deque>
+#include <typeinfo>
+#include <cstddef>
+#include "wallaroo/cxx0x.h"
+#include "wallaroo/symbol.h"
+
+namespace wallaroo
+{
+namespace detail
+{
+
+// This class describes the collaborators and the attributes declared by
+// a class derived from Part, as offsets from the Part subobject.
+// There is a Layout for each class of a hierarchy, filled while the first
+// instance is built and shared by the instances that register the same
+// members (see PartLayout). Once complete, a Layout never changes (and it
+// lives until the end of the program): the instances that follow read it
+// without locking.
+// Each Layout is chained to the Layout of its base class, so that
+// a part needs to store only the pointer to the Layout of its most derived class.
+// NOTE: a class must not derive virtually from Part, otherwise the offsets
+//       of its members depend on the most derived class.
+class Layout
+{
+public:
+
+    typedef std::ptrdiff_t Offset;
+
+    struct Entry
+    {
+        Entry( const Symbol& n, Offset o ) : name( n ), offset( o ) {}
+        Symbol name;
+        Offset offset;
+    };
+    typedef std::vector< Entry > Entries;
+
+    // (used only by the store of the layouts, before publishing a new one)
+    Layout( const Layout& l ) :
+        base( l.base ), type( l.type ), dependencies( l.dependencies ), attributes( l.attributes ),
+        derived( l.derived.load() ), next( l.next ), owner( l.owner.load() )
+    {}
+
+    // The layout of the base class (NULL for the first class of the hierarchy).
+    const Layout* Base() const { return base; }
+
+    // The collaborators declared in this class.
+    const Entries& Dependencies() const { return dependencies; }
+
+    // The attributes declared in this class.
+    const Entries& Attributes() const { return attributes; }
+
+private:
+    friend class PartLayout;
+
+    // NOTE: the class is identified by its name, because its type_info
+    //       can belong to a plugin that will be unloaded.
+    Layout( Layout* b, const char* t, const void* o ) : base( b ), type( t ), derived( NULL ), next( NULL ), owner( o ) {}
+
+    // true if the layout cannot grow anymore (then it never changes)
+    bool Complete() const { return owner.load( cxx0x::memory_order_acquire ) == NULL; }
+
+    // the layout of the class @c type in the list starting with @c l, or NULL
+    static Layout* Find( Layout* l, const char* type )
+    {
+        for ( ; l != NULL; l = l -> next )
+            if ( l -> type == type ) return l;
+        return NULL;
+    }
+
+    // the layouts shared by the parts (a deque does not move its elements)
+    static std::deque< Layout >& Store()
+    {
+        static std::deque< Layout > store;
+        return store;
+    }
+
+    // the list of the layouts of the classes deriving directly from Part
+    static cxx0x::atomic< Layout* >& Roots()
+    {
+        static cxx0x::atomic< Layout* > roots( NULL );
+        return roots;
+    }
+
+    static cxx0x::mutex& Mutex()
+    {
+        static cxx0x::mutex mutex;
+        return mutex;
+    }
+
+    Layout* base;
+    std::string type;
+    Entries dependencies;
+    Entries attributes;
+    // the list of the layouts of the derived classes, linked by next
+    // (the insertions are serialized by the mutex)
+    cxx0x::atomic< Layout* > derived;
+    Layout* next;
+    // the only part that can still append entries (NULL when the layout is
+    // complete), changed with the mutex locked
+    cxx0x::atomic< const void* > owner;
+};
+
+// The layout of a part: the chain of Layout of its classes, and the number
+// of entries the part registered in the Layout of its most derived class.
+// The registrations of a part are checked against the shared Layout: when
+// a name or an offset differs (i.e., a name chosen at runtime, or a member
+// allocated on the heap) the part goes on with a private copy of the chain.
+// A shared Layout is extended only by the part that created it, until
+// another part uses it: the parts that follow check their registrations
+// against the complete layouts without locking and without building any Symbol.
+class PartLayout
+{
+public:
+
+    // A pointer of the member that selects the table (collaborators or attributes).
+    typedef Layout::Entries Layout::*Table;
+
+    // Iterates the entries of a table of a part, from the most derived class.
+    class Iterator
+    {
+    public:
+        bool End() const { return layout == NULL; }
+        const Layout::Entry& operator * () const { return ( layout ->* table )[ index ]; }
+        const Layout::Entry* operator -> () const { return &( layout ->* table )[ index ]; }
+        Iterator& operator ++ ()
+        {
+            ++index;
+            Skip();
+            return *this;
+        }
+    private:
+        friend class PartLayout;
+        Iterator( const Layout* l, Table t, std::size_t s ) : layout( l ), table( t ), index( 0 ), size( s ) { Skip(); }
+        // go to the next layout when the current one is finished
+        void Skip()
+        {
+            while ( layout != NULL && index == size )
+            {
+                layout = layout -> base;
+                index = 0;
+                size = ( layout == NULL ? 0 : ( layout ->* table ).size() );
+            }
+        }
+        const Layout* layout;
+        Table table;
+        std::size_t index;
+        std::size_t size;
+    };
+
+    PartLayout() : top( NULL ), dependencies( 0 ), attributes( 0 ), copy( false ) {}
+    // the members of a part don't move with a copy of the part: they register again
+    PartLayout( const PartLayout& ) : top( NULL ), dependencies( 0 ), attributes( 0 ), copy( false ) {}
+    PartLayout& operator = ( const PartLayout& ) { return *this; }
+    ~PartLayout() { if ( copy ) Delete( top ); }
+
+    // Register a collaborator declared in the class @c type (the class
+    // whose constructor is running).
+    void RegisterDependency( const std::type_info& type, const std::string& name, Layout::Offset offset )
+    {
+        Register( type, &Layout::dependencies, dependencies, name, offset );
+    }
+
+    // Register an attribute declared in the class @c type (the class
+    // whose constructor is running).
+    void RegisterAttribute( const std::type_info& type, const std::string& name, Layout::Offset offset )
+    {
+        Register( type, &Layout::attributes, attributes, name, offset );
+    }
+
+    Iterator Dependencies() const { return Iterator( top, &Layout::dependencies, dependencies ); }
+    Iterator Attributes() const { return Iterator( top, &Layout::attributes, attributes ); }
+
+    // Look for the entry named @c name in @c i and the entries following.
+    // Returns false if it cannot be found.
+    static bool Find( Iterator i, const Symbol& name, Layout::Offset& offset )
+    {
+        for ( ; ! i.End(); ++i )
+            if ( i -> name == name )
+            {
+                offset = i -> offset;
+                return true;
+            }
+        return false;
+    }
+
+private:
+
+    void Register( const std::type_info& type, Table table, unsigned int& count, const std::string& name, Layout::Offset offset )
+    {
+        if ( Reuse( type, table, count, name, offset ) )
+        {
+            ++count;
+            return;
+        }
+        Build( type, table, count, Symbol( name ), offset );
+    }
+
+    // true if the entry is the next one of the complete shared layout of
+    // the class @c type (the check doesn't lock)
+    bool Reuse( const std::type_info& type, Table table, const unsigned int& count, const std::string& name, Layout::Offset offset )
+    {
+        if ( copy ) return false;
+        if ( top == NULL || top -> type != type.name() )
+        {
+            // the part must have registered all the entries of the shared layout
+            if ( top != NULL && ( ! top -> Complete() || dependencies != top -> dependencies.size() || attributes != top -> attributes.size() ) )
+                return false;
+            Layout* derived = Layout::Find( ( top == NULL ? Layout::Roots() : top -> derived ).load( cxx0x::memory_order_acquire ), type.name() );
+            if ( derived == NULL || ! derived -> Complete() ) return false;
+            top = derived;
+            dependencies = attributes = 0; // count is one of them
+        }
+        else if ( ! top -> Complete() )
+            return false;
+        const Layout::Entries& entries = top ->* table;
+        if ( count >= entries.size() ) return false;
+        const Layout::Entry& e = entries[ count ];
+        return e.offset == offset && e.name.Name() == name;
+    }
+
+    // register the entry while the layout is being built (or in the private copy)
+    void Build( const std::type_info& type, Table table, unsigned int& count, const Symbol& name, Layout::Offset offset )
+    {
+        cxx0x::lock_guard< cxx0x::mutex > lock( Layout::Mutex() );
+        if ( top == NULL || top -> type != type.name() ) Derive( type );
+        Layout::Entries& entries = top ->* table;
+        if ( ! copy )
+        {
+            if ( count < entries.size() )
+            {
+                const Layout::Entry& e = entries[ count ];
+                if ( e.name == name && e.offset == offset )
+                {
+                    ++count;
+                    return;
+                }
+            }
+            else if ( top -> owner.load( cxx0x::memory_order_relaxed ) == this )
+            {
+                entries.push_back( Layout::Entry( name, offset ) );
+                ++count;
+                return;
+            }
+            Copy();
+        }
+        ( top ->* table ).push_back( Layout::Entry( name, offset ) );
+        ++count;
+    }
+
+    // start the layout of the class @c type, derived from the class of top
+    void Derive( const std::type_info& type )
+    {
+        if ( top != NULL && ! copy )
+        {
+            // the part must have registered all the entries of the shared layout
+            if ( dependencies != top -> dependencies.size() || attributes != top -> attributes.size() )
+                Copy();
+            else if ( top -> owner.load( cxx0x::memory_order_relaxed ) == this )
+                top -> owner.store( NULL, cxx0x::memory_order_release );
+        }
+        dependencies = attributes = 0;
+        if ( copy )
+        {
+            top = new Layout( top, type.name(), this );
+            return;
+        }
+        cxx0x::atomic< Layout* >& candidates = ( top == NULL ? Layout::Roots() : top -> derived );
+        Layout* const found = Layout::Find( candidates.load( cxx0x::memory_order_relaxed ), type.name() );
+        if ( found != NULL )
+        {
+            top = found;
+            top -> owner.store( NULL, cxx0x::memory_order_release ); // used by another part: it cannot grow anymore
+            return;
+        }
+        Layout::Store().push_back( Layout( top, type.name(), this ) );
+        top = &Layout::Store().back();
+        top -> next = candidates.load( cxx0x::memory_order_relaxed );
+        candidates.store( top, cxx0x::memory_order_release );
+    }
+
+    // go on with a private copy of the entries registered
+    void Copy()
+    {
+        top = Clone( top, dependencies, attributes );
+        copy = true;
+    }
+
+    Layout* Clone( const Layout* l, std::size_t deps, std::size_t attrs )
+    {
+        if ( l == NULL ) return NULL;
+        const Layout* b = l -> base;
+        Layout* result = new Layout(
+            Clone( b, b == NULL ? 0 : b -> dependencies.size(), b == NULL ? 0 : b -> attributes.size() ),
+            l -> type.c_str(),
+            this
+        );
+        result -> dependencies.assign( l -> dependencies.begin(), l -> dependencies.begin() + deps );
+        result -> attributes.assign( l -> attributes.begin(), l -> attributes.begin() + attrs );
+        return result;
+    }
+
+    static void Delete( const Layout* l )
+    {
+        while ( l != NULL )
+        {
+            const Layout* b = l -> base;
+            delete l;
+            l = b;
+        }
+    }
+
+    Layout* top; // the layout of the most derived class registered
+    unsigned int dependencies; // the collaborators registered in top
+    unsigned int attributes; // the attributes registered in top
+    bool copy; // true if the chain belongs to this part
+};
+
+} // namespace detail
+} // namespace wallaroo
+
+#endif // WALLAROO_DETAIL_LAYOUT_H_
@@ -0,0 +1,94 @@
+/*******************************************************************************
+ * wallaroo - A library for configurable creation and wiring of C++ classes.
+ * Copyright (C) 2012 Daniele Pallastrelli
+ *
+ * This file is part of wallaroo.
+ * For more information, see http://wallaroo.googlecode.com/
+ *
+ * Boost Software License - Version 1.0 - August 17th, 2003
+ *
+ * Permission is hereby granted, free of charge, to any person or organization
+ * obtaining a copy of the software and accompanying documentation covered by
+ * this license (the "Software") to use, reproduce, display, distribute,
+ * execute, and transmit the Software, and to prepare derivative works of the
+ * Software, and to permit third-parties to whom the Software is furnished to
+ * do so, all subject to the following:
+ *
+ * The copyright notices in the Software and this entire statement, including
+ * the above license grant, this restriction and the following disclaimer,
+ * must be included in all copies of the Software, in whole or in part, and
+ * all derivative works of the Software, unless such copies or derivative
+ * works are solely in the form of machine-executable object code generated by
+ * a source language processor.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT
+ * SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE
+ * FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE,
+ * ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ ******************************************************************************/
+
+#ifndef WALLAROO_DETAIL_LIVE_VALUE_H_
+#define WALLAROO_DETAIL_LIVE_VALUE_H_
+
+#include "wallaroo/cxx0x.h"
+#include "wallaroo/detail/rcu.h"
+
+namespace wallaroo
+{
+namespace detail
+{
+
+// A value of type T that any number of threads can read without waiting
+// while another thread assigns it. The writers must be serialized.
+// The types that fit in a lock-free atomic are stored in an atomic variable,
+// the other ones are copied at every assignment (read-copy-update).
+template < typename T, bool Atomic =
+    ( cxx0x::is_arithmetic< T >::value || cxx0x::is_enum< T >::value || cxx0x::is_pointer< T >::value ) &&
+    sizeof( T ) <= sizeof( void* ) >
+class LiveValue
+{
+public:
+    typedef T Reference;
+
+    LiveValue() : value( T() ) {}
+
+    T Get() const { return value.load( cxx0x::memory_order_acquire ); }
+    void Set( const T& v ) { value.store( v, cxx0x::memory_order_release ); }
+
+private:
+    cxx0x::atomic< T > value;
+
+    // copy disabled
+    LiveValue( const LiveValue& );
+    LiveValue& operator = ( const LiveValue& );
+};
+
+// The reader gets a copy of the current value, taken from an immutable
+// copy that is freed after the next assignment, when its last reader
+// is done (see RcuPtr).
+template < typename T >
+class LiveValue< T, false >
+{
+public:
+    typedef T Reference;
+
+    LiveValue() { value.Publish( T() ); }
+
+    T Get() const
+    {
+        EpochGuard guard;
+        return *value.Get();
+    }
+    void Set( const T& v ) { value.Publish( v ); }
+
+private:
+    RcuPtr< T > value;
+};
+
+} // namespace detail
+} // namespace wallaroo
+
+#endif // WALLAROO_DETAIL_LIVE_VALUE_H_
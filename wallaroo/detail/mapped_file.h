@@ -0,0 +1,81 @@
+/*******************************************************************************
+ * wallaroo - A library for configurable creation and wiring of C++ classes.
+ * Copyright (C) 2012 Daniele Pallastrelli
+ *
+ * This file is part of wallaroo.
+ * For more information, see http://wallaroo.googlecode.com/
+ *
+ * Boost Software License - Version 1.0 - August 17th, 2003
+ *
+ * Permission is hereby granted, free of charge, to any person or organization
+ * obtaining a copy of the software and accompanying documentation covered by
+ * this license (the "Software") to use, reproduce, display, distribute,
+ * execute, and transmit the Software, and to prepare derivative works of the
+ * Software, and to permit third-parties to whom the Software is furnished to
+ * do so, all subject to the following:
+ *
+ * The copyright notices in the Software and this entire statement, including
+ * the above license grant, this restriction and the following disclaimer,
+ * must be included in all copies of the Software, in whole or in part, and
+ * all derivative works of the Software, unless such copies or derivative
+ * works are solely in the form of machine-executable object code generated by
+ * a source language processor.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT
+ * SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE
+ * FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE,
+ * ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ ******************************************************************************/
+
+#ifndef WALLAROO_DETAIL_MAPPED_FILE_H_
+#define WALLAROO_DETAIL_MAPPED_FILE_H_
+
+#include <string>
+#include <cstddef>
+#include "wallaroo/exceptions.h"
+#include "wallaroo/detail/platform_specific_lib_macros.h"
+#include WALLAROO_MAPPED_FILE_IMPL_HEADER // select the right OS-specific header-file for PlatformSpecificMappedFile
+
+
+namespace wallaroo
+{
+namespace detail
+{
+
+// Manage a read-only memory mapping of a file as a resource.
+// Map the file on the ctor and unmap it on the dtor.
+class MappedFile : private PlatformSpecificMappedFile
+{
+public:
+    /* Create a MappedFile from the path specified as parameter
+    * mapping the whole file in memory.
+    * @param fileName the path of the file to map
+    * @throw WrongFile if the file does not exist or cannot be mapped.
+    */
+    explicit MappedFile( const std::string& fileName ) :
+        PlatformSpecificMappedFile( fileName )
+    {
+    }
+    // Unmap the file
+    ~MappedFile()
+    {
+    }
+    // The address of the first byte of the file
+    const char* Data() const
+    {
+        return PlatformSpecificMappedFile::Data();
+    }
+    // The size of the file in bytes
+    std::size_t Size() const
+    {
+        return PlatformSpecificMappedFile::Size();
+    }
+};
+
+} // namespace detail
+} // namespace wallaroo
+
+#endif // WALLAROO_DETAIL_MAPPED_FILE_H_
@@ -0,0 +1,100 @@
+/*******************************************************************************
+ * wallaroo - A library for configurable creation and wiring of C++ classes.
+ * Copyright (C) 2012 Daniele Pallastrelli
+ *
+ * This file is part of wallaroo.
+ * For more information, see http://wallaroo.googlecode.com/
+ *
+ * Boost Software License - Version 1.0 - August 17th, 2003
+ *
+ * Permission is hereby granted, free of charge, to any person or organization
+ * obtaining a copy of the software and accompanying documentation covered by
+ * this license (the "Software") to use, reproduce, display, distribute,
+ * execute, and transmit the Software, and to prepare derivative works of the
+ * Software, and to permit third-parties to whom the Software is furnished to
+ * do so, all subject to the following:
+ *
+ * The copyright notices in the Software and this entire statement, including
+ * the above license grant, this restriction and the following disclaimer,
+ * must be included in all copies of the Software, in whole or in part, and
+ * all derivative works of the Software, unless such copies or derivative
+ * works are solely in the form of machine-executable object code generated by
+ * a source language processor.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT
+ * SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE
+ * FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE,
+ * ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ ******************************************************************************/
+
+#ifndef WALLAROO_DETAIL_MAPPED_FILE_UNIX_H_
+#define WALLAROO_DETAIL_MAPPED_FILE_UNIX_H_
+
+#include <string>
+#include <cstddef>
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <sys/mman.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include "wallaroo/exceptions.h"
+
+
+namespace wallaroo
+{
+namespace detail
+{
+
+// unix-like specific implementation of a read-only mapped file
+class PlatformSpecificMappedFile
+{
+public:
+    // throw WrongFile if the file does not exist or cannot be mapped.
+    explicit PlatformSpecificMappedFile( const std::string& fileName ) :
+        data( NULL ),
+        size( 0 )
+    {
+        const int fd = open( fileName.c_str(), O_RDONLY );
+        if ( fd < 0 ) throw WrongFile( fileName );
+        struct stat info;
+        if ( fstat( fd, &info ) != 0 )
+        {
+            close( fd );
+            throw WrongFile( fileName );
+        }
+        size = static_cast< std::size_t >( info.st_size );
+        if ( size > 0 )
+        {
+            void* address = mmap( NULL, size, PROT_READ, MAP_PRIVATE, fd, 0 );
+            if ( address == MAP_FAILED )
+            {
+                close( fd );
+                throw WrongFile( fileName );
+            }
+            data = static_cast< const char* >( address );
+        }
+        close( fd ); // the mapping keeps the file open
+    }
+    // Unmap the file
+    ~PlatformSpecificMappedFile()
+    {
+        if ( data != NULL ) munmap( const_cast< char* >( data ), size );
+    }
+    const char* Data() const { return data; }
+    std::size_t Size() const { return size; }
+private:
+    const char* data;
+    std::size_t size;
+
+    // copy ctor and assignment operator disabled
+    PlatformSpecificMappedFile( const PlatformSpecificMappedFile& );
+    PlatformSpecificMappedFile& operator = ( const PlatformSpecificMappedFile& );
+};
+
+} // namespace detail
+} // namespace wallaroo
+
+#endif // WALLAROO_DETAIL_MAPPED_FILE_UNIX_H_
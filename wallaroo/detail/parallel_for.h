@@ -0,0 +1,267 @@
+/*******************************************************************************
+ * wallaroo - A library for configurable creation and wiring of C++ classes.
+ * Copyright (C) 2012 Daniele Pallastrelli
+ *
+ * This file is part of wallaroo.
+ * For more information, see http://wallaroo.googlecode.com/
+ *
+ * Boost Software License - Version 1.0 - August 17th, 2003
+ *
+ * Permission is hereby granted, free of charge, to any person or organization
+ * obtaining a copy of the software and accompanying documentation covered by
+ * this license (the "Software") to use, reproduce, display, distribute,
+ * execute, and transmit the Software, and to prepare derivative works of the
+ * Software, and to permit third-parties to whom the Software is furnished to
+ * do so, all subject to the following:
+ *
+ * The copyright notices in the Software and this entire statement, including
+ * the above license grant, this restriction and the following disclaimer,
+ * must be included in all copies of the Software, in whole or in part, and
+ * all derivative works of the Software, unless such copies or derivative
+ * works are solely in the form of machine-executable object code generated by
+ * a source language processor.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT
+ * SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE
+ * FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE,
+ * ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ ******************************************************************************/
+
+#ifndef WALLAROO_DETAIL_PARALLEL_FOR_H_
+#define WALLAROO_DETAIL_PARALLEL_FOR_H_
+
+#include <cstddef>
+#include <algorithm>
+#include "wallaroo/cxx0x.h"
+#include "wallaroo/detail/thread_pool.h"
+
+#ifdef WALLAROO_HAS_CXX0X
+    #include <exception>
+#else
+    #include <boost/exception_ptr.hpp>
+#endif
+
+namespace wallaroo
+{
+namespace detail
+{
+
+// Call f( first, last ) on chunks of the range [0, size), using the calling
+// thread and the workers of a thread pool shared by the whole process.
+// The chunks are handed out by a shared cursor, and every chunk takes a
+// fraction of the indexes remaining (guided self-scheduling): the big chunks
+// at the beginning keep the overhead low, and the small chunks at the end
+// balance the load among the threads, that take new work as soon as they're
+// idle. The calling thread doesn't wait for the workers that are busy with
+// other tasks, so the calls can be nested.
+// The first exception thrown by f stops the distribution of the chunks and
+// is rethrown by the calling thread, when the chunks in progress are done.
+class ParallelFor
+{
+public:
+    // the number of threads used (the workers of the pool and the calling thread)
+    static std::size_t Threads()
+    {
+        static const std::size_t threads = std::max< std::size_t >( cxx0x::thread::hardware_concurrency(), 2 );
+        return threads;
+    }
+
+    template < typename F >
+    static void Run( std::size_t size, const F& f )
+    {
+        if ( size == 0 ) return;
+        const cxx0x::shared_ptr< State< F > > state( new State< F >( size, f, Threads() ) );
+        const std::size_t helpers = std::min( Threads() - 1, size - 1 );
+        for ( std::size_t i = 0; i < helpers; ++i )
+            Pool().Post( Helper< F >( state ) );
+        state -> Work();
+        state -> Wait();
+    }
+
+private:
+
+#ifdef WALLAROO_HAS_CXX0X
+    typedef std::exception_ptr ExceptionPtr;
+    static ExceptionPtr CurrentException() { return std::current_exception(); }
+    static void Rethrow( const ExceptionPtr& e ) { std::rethrow_exception( e ); }
+#else
+    // without C++11, only the standard exceptions and the ones thrown with
+    // boost::enable_current_exception are rethrown with their own type
+    typedef boost::exception_ptr ExceptionPtr;
+    static ExceptionPtr CurrentException() { return boost::current_exception(); }
+    static void Rethrow( const ExceptionPtr& e ) { boost::rethrow_exception( e ); }
+#endif
+
+    // the pool shared by all the calls
+    static ThreadPool& Pool()
+    {
+        static ThreadPool pool( Threads() - 1 );
+        return pool;
+    }
+
+    // the state of a call, shared by the calling thread and the helpers
+    template < typename F >
+    class State
+    {
+    public:
+        State( std::size_t s, const F& _f, std::size_t t ) :
+            f( _f ), size( s ), threads( t ), next( 0 ), failed( false ), active( 0 )
+        {}
+
+        // executed by the helpers: take part only if there's still work to do
+        void Join()
+        {
+            {
+                cxx0x::lock_guard< cxx0x::mutex > lock( mutex );
+                if ( failed.load() || next.load() >= size ) return;
+                ++active;
+            }
+            Work();
+            {
+                cxx0x::lock_guard< cxx0x::mutex > lock( mutex );
+                --active;
+            }
+            done.notify_all();
+        }
+
+        void Work()
+        {
+            while ( ! failed.load() )
+            {
+                const std::size_t current = next.load();
+                if ( current >= size ) return;
+                const std::size_t chunk = std::max< std::size_t >( 1, ( size - current ) / ( 2 * threads ) );
+                const std::size_t first = next.fetch_add( chunk );
+                if ( first >= size ) return;
+                try
+                {
+                    f( first, std::min( first + chunk, size ) );
+                }
+                catch ( ... )
+                {
+                    cxx0x::lock_guard< cxx0x::mutex > lock( mutex );
+                    if ( ! failed.load() ) error = CurrentException();
+                    failed.store( true );
+                }
+            }
+        }
+
+        // wait for the helpers still working and rethrow the first exception
+        void Wait()
+        {
+            cxx0x::unique_lock< cxx0x::mutex > lock( mutex );
+            while ( active > 0 )
+                done.wait( lock );
+            if ( failed.load() ) Rethrow( error );
+        }
+
+    private:
+        const F f;
+        const std::size_t size;
+        const std::size_t threads;
+        cxx0x::atomic< std::size_t > next; // the first index not yet handed out
+        cxx0x::atomic< bool > failed;
+        cxx0x::mutex mutex;
+        cxx0x::condition_variable done;
+        std::size_t active; // the helpers working
+        ExceptionPtr error;
+    };
+
+    template < typename F >
+    struct Helper
+    {
+        explicit Helper( const cxx0x::shared_ptr< State< F > >& s ) : state( s ) {}
+        void operator()() { state -> Join(); }
+        cxx0x::shared_ptr< State< F > > state;
+    };
+};
+
+// ********************************************************
+// adapters used by Collaborator::ParallelForEach and Collaborator::ParallelReduce
+
+// call a method with no parameters
+template < typename R, typename T, typename M >
+struct MethodCall0
+{
+    explicit MethodCall0( M _m ) : m( _m ) {}
+    R operator()( T* p ) const { return ( p ->* m )(); }
+    M m;
+};
+
+// the type of the arguments of Collaborator::ParallelForEach, taken from the
+// parameters of the method (it prevents their deduction from the arguments)
+template < typename P >
+struct NonDeduced
+{
+    typedef P Type;
+};
+
+// call a method with one parameter
+// (a reference parameter is stored as a reference, so it can be non-const)
+template < typename R, typename T, typename M, typename P1 >
+struct MethodCall1
+{
+    MethodCall1( M _m, P1 _a1 ) : m( _m ), a1( _a1 ) {}
+    R operator()( T* p ) const { return ( p ->* m )( a1 ); }
+    M m;
+    P1 a1;
+};
+
+// call a method with two parameters
+template < typename R, typename T, typename M, typename P1, typename P2 >
+struct MethodCall2
+{
+    MethodCall2( M _m, P1 _a1, P2 _a2 ) : m( _m ), a1( _a1 ), a2( _a2 ) {}
+    R operator()( T* p ) const { return ( p ->* m )( a1, a2 ); }
+    M m;
+    P1 a1;
+    P2 a2;
+};
+
+// call f on the parts of a chunk
+// NOTE: all the chunks call the same f (that must outlive ParallelFor::Run)
+//       through a const reference, from several threads at once: its
+//       operator() must be const and safe to call concurrently.
+template < typename T, typename F >
+struct ForEachChunk
+{
+    ForEachChunk( T* const* p, const F& _f ) : parts( p ), f( _f ) {}
+    void operator()( std::size_t first, std::size_t last ) const
+    {
+        for ( std::size_t i = first; i < last; ++i )
+            f( parts[ i ] );
+    }
+    T* const* parts;
+    const F& f;
+};
+
+// call f on the parts of a chunk and combine the results into *result
+// (f and op are shared by the chunks, like in ForEachChunk)
+template < typename T, typename R, typename F, typename Op >
+struct ReduceChunk
+{
+    ReduceChunk( T* const* p, const F& _f, const Op& _op, R* r, cxx0x::mutex* m ) :
+        parts( p ), f( _f ), op( _op ), result( r ), mutex( m )
+    {}
+    void operator()( std::size_t first, std::size_t last ) const
+    {
+        R partial = f( parts[ first ] );
+        for ( std::size_t i = first + 1; i < last; ++i )
+            partial = op( partial, f( parts[ i ] ) );
+        cxx0x::lock_guard< cxx0x::mutex > lock( *mutex );
+        *result = op( *result, partial );
+    }
+    T* const* parts;
+    const F& f;
+    const Op& op;
+    R* result;
+    cxx0x::mutex* mutex;
+};
+
+} // namespace detail
+} // namespace wallaroo
+
+#endif // WALLAROO_DETAIL_PARALLEL_FOR_H_
@@ -38,6 +38,7 @@
 #include <cassert>
 #include "wallaroo/cxx0x.h"
 #include "wallaroo/part.h"
+#include "wallaroo/symbol.h"
 
 namespace wallaroo
 {
@@ -62,12 +63,23 @@ public:
         part -> Wire( collaboratorName, destination.part );
     }
 
+    void Wire( const Symbol& collaboratorName, const PartShell& destination ) const
+    {
+        part -> Wire( collaboratorName, destination.part );
+    }
+
     template < class T >
     void SetAttribute( const std::string& attribute, const T& value ) const
     {
         part -> SetAttribute( attribute, value );
     }
 
+    template < class T >
+    void SetAttribute( const Symbol& attribute, const T& value ) const
+    {
+        part -> SetAttribute( attribute, value );
+    }
+
     /** Convert the contained part to the type T
     * @return the converted part.
     * @throw WrongType if the contained part is not a subclass of T
@@ -0,0 +1,154 @@
+/*******************************************************************************
+ * wallaroo - A library for configurable creation and wiring of C++ classes.
+ * Copyright (C) 2012 Daniele Pallastrelli
+ *
+ * This file is part of wallaroo.
+ * For more information, see http://wallaroo.googlecode.com/
+ *
+ * Boost Software License - Version 1.0 - August 17th, 2003
+ *
+ * Permission is hereby granted, free of charge, to any person or organization
+ * obtaining a copy of the software and accompanying documentation covered by
+ * this license (the "Software") to use, reproduce, display, distribute,
+ * execute, and transmit the Software, and to prepare derivative works of the
+ * Software, and to permit third-parties to whom the Software is furnished to
+ * do so, all subject to the following:
+ *
+ * The copyright notices in the Software and this entire statement, including
+ * the above license grant, this restriction and the following disclaimer,
+ * must be included in all copies of the Software, in whole or in part, and
+ * all derivative works of the Software, unless such copies or derivative
+ * works are solely in the form of machine-executable object code generated by
+ * a source language processor.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT
+ * SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE
+ * FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE,
+ * ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ ******************************************************************************/
+
+#ifndef WALLAROO_DETAIL_PERFECT_HASH_H_
+#define WALLAROO_DETAIL_PERFECT_HASH_H_
+
+#include <vector>
+#include <utility>
+#include <functional>
+#include <algorithm>
+#include <cstddef>
+#include "wallaroo/cxx0x.h"
+
+namespace wallaroo
+{
+namespace detail
+{
+
+// A minimal perfect hash table with integer keys, built once from a
+// fixed set of distinct keys (hash and displace algorithm).
+// The keys are distributed in buckets by a first hash function; then,
+// starting from the biggest buckets, each bucket gets the displacement
+// that sends all its keys to free slots with a second hash function.
+// The buckets with a single key are simply assigned the first free slot.
+// A lookup computes two hashes and reads one displacement and one slot
+// of a contiguous array, without probing.
+template < typename T >
+class PerfectHash
+{
+public:
+    typedef std::vector< std::pair< std::size_t, T > > Items;
+
+    // Build the table from @c items, whose keys must be distinct.
+    explicit PerfectHash( const Items& items ) :
+        buckets( std::max< std::size_t >( 1, items.size() / 2 ) ),
+        displacements( buckets, 0 ),
+        slots( items.size() )
+    {
+        const std::size_t n = items.size();
+        if ( n == 0 ) return;
+
+        std::vector< std::vector< std::size_t > > bucket( buckets ); // the items of each bucket
+        for ( std::size_t i = 0; i < n; ++i )
+            bucket[ Mix( items[ i ].first, 0 ) % buckets ].push_back( i );
+        std::vector< std::pair< std::size_t, std::size_t > > order; // ( size, bucket ), biggest first
+        for ( std::size_t b = 0; b < buckets; ++b )
+            order.push_back( std::make_pair( bucket[ b ].size(), b ) );
+        std::sort( order.begin(), order.end(), std::greater< std::pair< std::size_t, std::size_t > >() );
+
+        std::vector< bool > taken( n, false );
+        std::vector< std::size_t > positions;
+        std::size_t free = 0; // the first slot that could be free
+        for ( std::size_t o = 0; o < order.size() && order[ o ].first > 0; ++o )
+        {
+            const std::vector< std::size_t >& keys = bucket[ order[ o ].second ];
+            if ( keys.size() == 1 )
+            {
+                while ( taken[ free ] ) ++free;
+                Place( order[ o ].second, -static_cast< long >( free ) - 1, free, items[ keys[ 0 ] ], taken );
+                continue;
+            }
+            for ( cxx0x::uint32_t d = 1; ; ++d )
+            {
+                positions.clear();
+                for ( std::size_t k = 0; k < keys.size(); ++k )
+                {
+                    const std::size_t p = Mix( items[ keys[ k ] ].first, d ) % n;
+                    if ( taken[ p ] || std::find( positions.begin(), positions.end(), p ) != positions.end() ) break;
+                    positions.push_back( p );
+                }
+                if ( positions.size() < keys.size() ) continue;
+                for ( std::size_t k = 0; k < keys.size(); ++k )
+                    Place( order[ o ].second, static_cast< long >( d ), positions[ k ], items[ keys[ k ] ], taken );
+                break;
+            }
+        }
+    }
+
+    // Return the item having key @c key, or NULL if the key was not in the set.
+    const T* Find( std::size_t key ) const
+    {
+        if ( slots.empty() ) return NULL;
+        const long d = displacements[ Mix( key, 0 ) % buckets ];
+        const std::size_t p = ( d < 0 ? static_cast< std::size_t >( -d - 1 ) : Mix( key, d ) % slots.size() );
+        const Slot& slot = slots[ p ];
+        return ( slot.key == key ? &slot.item : NULL );
+    }
+
+private:
+    struct Slot
+    {
+        Slot() : key( 0 ), item() {}
+        std::size_t key;
+        T item;
+    };
+
+    void Place( std::size_t b, long d, std::size_t p, const std::pair< std::size_t, T >& item, std::vector< bool >& taken )
+    {
+        displacements[ b ] = d;
+        slots[ p ].key = item.first;
+        slots[ p ].item = item.second;
+        taken[ p ] = true;
+    }
+
+    // a 32 bit mixing function (the finalizer of MurmurHash3)
+    static std::size_t Mix( std::size_t key, long seed )
+    {
+        cxx0x::uint32_t h = static_cast< cxx0x::uint32_t >( key ^ ( key >> 16 >> 16 ) ) + static_cast< cxx0x::uint32_t >( seed ) * 0x9E3779B9U;
+        h ^= h >> 16;
+        h *= 0x85EBCA6BU;
+        h ^= h >> 13;
+        h *= 0xC2B2AE35U;
+        h ^= h >> 16;
+        return h;
+    }
+
+    const std::size_t buckets;
+    std::vector< long > displacements; // negative values encode the slot of a single key bucket
+    std::vector< Slot > slots;
+};
+
+} // namespace detail
+} // namespace wallaroo
+
+#endif // WALLAROO_DETAIL_PERFECT_HASH_H_
@@ -71,9 +71,11 @@
 #if defined(WALLAROO_DETAIL_OS_FAMILY_WINDOWS)
     #define WALLAROO_DLL_PREFIX extern "C" __declspec(dllexport)
     #define WALLAROO_DLL_IMPL_HEADER "wallaroo/detail/dynamic_library_WIN32.h"
+    #define WALLAROO_MAPPED_FILE_IMPL_HEADER "wallaroo/detail/mapped_file_WIN32.h"
 #elif defined(WALLAROO_DETAIL_OS_FAMILY_UNIX)
     #define WALLAROO_DLL_PREFIX extern "C" 
     #define WALLAROO_DLL_IMPL_HEADER "wallaroo/detail/dynamic_library_UNIX.h"
+    #define WALLAROO_MAPPED_FILE_IMPL_HEADER "wallaroo/detail/mapped_file_UNIX.h"
 #else
     #error "Unknown Platform."
 #endif
@@ -0,0 +1,173 @@
+/*******************************************************************************
+ * wallaroo - A library for configurable creation and wiring of C++ classes.
+ * Copyright (C) 2012 Daniele Pallastrelli
+ *
+ * This file is part of wallaroo.
+ * For more information, see http://wallaroo.googlecode.com/
+ *
+ * Boost Software License - Version 1.0 - August 17th, 2003
+ *
+ * Permission is hereby granted, free of charge, to any person or organization
+ * obtaining a copy of the software and accompanying documentation covered by
+ * this license (the "Software") to use, reproduce, display, distribute,
+ * execute, and transmit the Software, and to prepare derivative works of the
+ * Software, and to permit third-parties to whom the Software is furnished to
+ * do so, all subject to the following:
+ *
+ * The copyright notices in the Software and this entire statement, including
+ * the above license grant, this restriction and the following disclaimer,
+ * must be included in all copies of the Software, in whole or in part, and
+ * all derivative works of the Software, unless such copies or derivative
+ * works are solely in the form of machine-executable object code generated by
+ * a source language processor.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT
+ * SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE
+ * FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE,
+ * ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ ******************************************************************************/
+
+#ifndef WALLAROO_DETAIL_RCU_H_
+#define WALLAROO_DETAIL_RCU_H_
+
+#include <cstddef>
+#include <vector>
+#include "wallaroo/cxx0x.h"
+#include "wallaroo/detail/epochs.h"
+
+namespace wallaroo
+{
+namespace detail
+{
+
+// A pointer to an immutable object of type T, that any number of threads
+// can read while another thread replaces the object (read-copy-update).
+// The writers must be serialized.
+// A reader must hold an EpochGuard while it uses the object: the readers
+// never lock and never write shared memory, and an object replaced is
+// destroyed when no guard held at the time of the replacement is left
+// (see Epochs).
+template < typename T >
+class RcuPtr
+{
+public:
+    typedef EpochGuard Guard; // what a reader holds while it uses the object
+
+    RcuPtr() : current( NULL ), retired( false ) {}
+
+    ~RcuPtr()
+    {
+        delete current.load( cxx0x::memory_order_relaxed );
+        if ( retired ) Epochs::Release( this );
+    }
+
+    // The current object, or NULL. It remains valid while the calling thread
+    // holds the EpochGuard it was holding when it called Get (the writer
+    // doesn't need a guard).
+    const T* Get() const
+    {
+        return current.load();
+    }
+
+    // replace the current object with a new object T( arg )
+    template < typename A >
+    void Publish( const A& arg )
+    {
+        Store( new T( arg ) );
+    }
+
+    // replace the current object with NULL
+    void Reset()
+    {
+        Store( NULL );
+    }
+
+private:
+    void Store( const T* p )
+    {
+        const T* old = current.exchange( p );
+        if ( old == NULL ) return;
+        retired = true;
+        Epochs::Retire( this, old, &Destroy );
+    }
+
+    static void Destroy( const void* p )
+    {
+        delete static_cast< const T* >( p );
+    }
+
+    cxx0x::atomic< const T* > current;
+    bool retired; // true if an object has been retired (accessed only by the writer)
+
+    // copy disabled
+    RcuPtr( const RcuPtr& );
+    RcuPtr& operator = ( const RcuPtr& );
+};
+
+// A pointer to an immutable object of type T, like RcuPtr, whose readers
+// don't need any guard: the objects replaced are destroyed only together
+// with the pointer. Use it for objects that are rarely replaced (i.e. the
+// links of the wiring), because it keeps all of them.
+// The writers must be serialized.
+template < typename T >
+class RetainPtr
+{
+public:
+    // the readers hold nothing
+    struct Guard
+    {
+        Guard() {}
+    };
+
+    RetainPtr() : current( NULL ) {}
+
+    ~RetainPtr()
+    {
+        delete current.load( cxx0x::memory_order_relaxed );
+        for ( std::size_t i = 0; i < retired.size(); ++i )
+            delete retired[ i ];
+    }
+
+    // The current object, or NULL. It remains valid as long as the pointer.
+    const T* Get() const
+    {
+        return current.load( cxx0x::memory_order_acquire );
+    }
+
+    // replace the current object with a new object T( arg )
+    template < typename A >
+    void Publish( const A& arg )
+    {
+        retired.reserve( retired.size() + 1 ); // Store doesn't throw
+        Store( new T( arg ) );
+    }
+
+    // replace the current object with NULL
+    void Reset()
+    {
+        retired.reserve( retired.size() + 1 );
+        Store( NULL );
+    }
+
+private:
+    void Store( const T* p )
+    {
+        const T* old = current.exchange( p, cxx0x::memory_order_acq_rel );
+        if ( old != NULL ) retired.push_back( old );
+    }
+
+    cxx0x::atomic< const T* > current;
+    std::vector< const T* > retired; // the objects replaced (accessed only by the writer)
+
+    // copy disabled
+    RetainPtr( const RetainPtr& );
+    RetainPtr& operator = ( const RetainPtr& );
+};
+
+} // namespace detail
+} // namespace wallaroo
+
+#endif // WALLAROO_DETAIL_RCU_H_
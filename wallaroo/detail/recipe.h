@@ -0,0 +1,101 @@
+/*******************************************************************************
+ * wallaroo - A library for configurable creation and wiring of C++ classes.
+ * Copyright (C) 2012 Daniele Pallastrelli
+ *
+ * This file is part of wallaroo.
+ * For more information, see http://wallaroo.googlecode.com/
+ *
+ * Boost Software License - Version 1.0 - August 17th, 2003
+ *
+ * Permission is hereby granted, free of charge, to any person or organization
+ * obtaining a copy of the software and accompanying documentation covered by
+ * this license (the "Software") to use, reproduce, display, distribute,
+ * execute, and transmit the Software, and to prepare derivative works of the
+ * Software, and to permit third-parties to whom the Software is furnished to
+ * do so, all subject to the following:
+ *
+ * The copyright notices in the Software and this entire statement, including
+ * the above license grant, this restriction and the following disclaimer,
+ * must be included in all copies of the Software, in whole or in part, and
+ * all derivative works of the Software, unless such copies or derivative
+ * works are solely in the form of machine-executable object code generated by
+ * a source language processor.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT
+ * SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE
+ * FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE,
+ * ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ ******************************************************************************/
+
+#ifndef WALLAROO_DETAIL_RECIPE_H_
+#define WALLAROO_DETAIL_RECIPE_H_
+
+#include "wallaroo/cxx0x.h"
+#include "wallaroo/class.h"
+#include "wallaroo/part.h"
+#include "arena.h"
+
+namespace wallaroo
+{
+namespace detail
+{
+
+// The way a part has been created by Catalog::Create (its class and the
+// parameters of its constructor), used to create other instances of it
+// without looking up the class again (see Prototype).
+class Recipe
+{
+public:
+    virtual ~Recipe() {}
+    virtual cxx0x::shared_ptr< Part > NewInstance( const cxx0x::shared_ptr< Arena >& arena ) const = 0;
+};
+
+template < class P1, class P2 >
+class ClassRecipe : public Recipe
+{
+public:
+    ClassRecipe( const Class< P1, P2 >& _c, const P1& _p1, const P2& _p2 ) : c( _c ), p1( _p1 ), p2( _p2 ) {}
+    virtual cxx0x::shared_ptr< Part > NewInstance( const cxx0x::shared_ptr< Arena >& arena ) const
+    {
+        return c.NewInstance( arena, p1, p2 );
+    }
+private:
+    const Class< P1, P2 > c;
+    const P1 p1;
+    const P2 p2;
+};
+
+template < class P >
+class ClassRecipe< P, void > : public Recipe
+{
+public:
+    ClassRecipe( const Class< P, void >& _c, const P& _p ) : c( _c ), p( _p ) {}
+    virtual cxx0x::shared_ptr< Part > NewInstance( const cxx0x::shared_ptr< Arena >& arena ) const
+    {
+        return c.NewInstance( arena, p );
+    }
+private:
+    const Class< P, void > c;
+    const P p;
+};
+
+template <>
+class ClassRecipe< void, void > : public Recipe
+{
+public:
+    explicit ClassRecipe( const Class< void, void >& _c ) : c( _c ) {}
+    virtual cxx0x::shared_ptr< Part > NewInstance( const cxx0x::shared_ptr< Arena >& arena ) const
+    {
+        return c.NewInstance( arena );
+    }
+private:
+    const Class< void, void > c;
+};
+
+} // namespace detail
+} // namespace wallaroo
+
+#endif // WALLAROO_DETAIL_RECIPE_H_
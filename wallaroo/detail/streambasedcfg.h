@@ -0,0 +1,466 @@
+/*******************************************************************************
+ * wallaroo - A library for configurable creation and wiring of C++ classes.
+ * Copyright (C) 2012 Daniele Pallastrelli
+ *
+ * This file is part of wallaroo.
+ * For more information, see http://wallaroo.googlecode.com/
+ *
+ * Boost Software License - Version 1.0 - August 17th, 2003
+ *
+ * Permission is hereby granted, free of charge, to any person or organization
+ * obtaining a copy of the software and accompanying documentation covered by
+ * this license (the "Software") to use, reproduce, display, distribute,
+ * execute, and transmit the Software, and to prepare derivative works of the
+ * Software, and to permit third-parties to whom the Software is furnished to
+ * do so, all subject to the following:
+ *
+ * The copyright notices in the Software and this entire statement, including
+ * the above license grant, this restriction and the following disclaimer,
+ * must be included in all copies of the Software, in whole or in part, and
+ * all derivative works of the Software, unless such copies or derivative
+ * works are solely in the form of machine-executable object code generated by
+ * a source language processor.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT
+ * SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE
+ * FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE,
+ * ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ ******************************************************************************/
+
+#ifndef WALLAROO_DETAIL_STREAMBASEDCFG_H_
+#define WALLAROO_DETAIL_STREAMBASEDCFG_H_
+
+#include <string>
+#include <vector>
+#include <utility>
+#include <map>
+#include <deque>
+#include <fstream>
+#include "wallaroo/catalog.h"
+#include "wallaroo/dynamic_loader.h"
+#include "wallaroo/parameters.h"
+#include "wallaroo/exceptions.h"
+
+namespace wallaroo
+{
+namespace detail
+{
+
+// The description of a part, as read from a configuration file.
+struct PartDesc
+{
+    PartDesc() : shared( false ) {}
+    struct Parameter
+    {
+        Parameter() : present( false ) {}
+        bool present;
+        std::string type;
+        std::string value;
+    };
+    typedef std::pair< std::string, std::string > AttributeDesc; // name, value
+
+    std::string name;
+    std::string cl;
+    Parameter parameter1;
+    Parameter parameter2;
+    std::vector< AttributeDesc > attributes;
+    bool shared; // not replicated (see Catalog::Share)
+};
+
+// The description of a wire, as read from a configuration file.
+struct WireDesc
+{
+    std::string source;
+    std::string dest;
+    std::string collaborator;
+};
+
+// This class receives the events of a streaming parser (see XmlStreamParser
+// and JsonStreamParser) and rebuilds one item of the configuration at a time.
+// When a plugin, a part or a wire is complete it calls the method
+// OnPlugin( name ), OnPart( const PartDesc& ) or OnWire( const WireDesc& ) of @c Sink.
+// The document must follow the schema of the ptree based configuration files:
+// wallaroo.plugins, wallaroo.parts and wallaroo.wiring.
+template < typename Sink >
+class CfgBuilder
+{
+public:
+    explicit CfgBuilder( Sink& s ) : sink( s ), depth( 0 ) {}
+
+    void Open( const std::string& key )
+    {
+        ++depth;
+        text.clear();
+        switch ( depth )
+        {
+            case 1: root = key; break;
+            case 2: section = key; break;
+            case 3:
+                part = PartDesc();
+                name = Field();
+                cl = Field();
+                wire = Wire();
+                break;
+            case 4:
+                field = key;
+                if ( field == "attribute" ) attribute = Attribute();
+                break;
+            case 5:
+                subfield = key;
+                break;
+            default: break;
+        }
+    }
+
+    void Text( const std::string& t )
+    {
+        text += t;
+    }
+
+    void Close()
+    {
+        if ( root == "wallaroo" )
+        {
+            if ( depth == 3 ) CloseItem();
+            else if ( depth == 4 ) CloseField();
+            else if ( depth == 5 ) CloseSubfield();
+        }
+        text.clear();
+        --depth;
+    }
+
+private:
+
+    // a string field that can be missing in the file
+    struct Field
+    {
+        Field() : present( false ) {}
+        void Set( const std::string& v )
+        {
+            if ( present ) return; // the first one wins
+            value = v;
+            present = true;
+        }
+        const std::string& Get( const char* name ) const
+        {
+            if ( ! present ) throw WrongFile( std::string( "No such node (" ) + name + ")" );
+            return value;
+        }
+        bool present;
+        std::string value;
+    };
+
+    struct Wire
+    {
+        Field source;
+        Field dest;
+        Field collaborator;
+        Field plug;
+    };
+
+    struct Attribute
+    {
+        Field name;
+        Field value;
+    };
+
+    bool IsPartsSection() const
+    {
+#ifndef WALLAROO_REMOVE_DEPRECATED
+        if ( section == "devices" ) return true;
+#endif
+        return section == "parts";
+    }
+
+    void CloseItem()
+    {
+        if ( section == "plugins" )
+            sink.OnPlugin( text );
+        else if ( IsPartsSection() )
+        {
+            part.name = name.Get( "name" );
+            part.cl = cl.Get( "class" );
+            sink.OnPart( part );
+        }
+        else if ( section == "wiring" )
+        {
+            WireDesc desc;
+            desc.source = wire.source.Get( "source" );
+            desc.dest = wire.dest.Get( "dest" );
+#ifdef WALLAROO_REMOVE_DEPRECATED
+            desc.collaborator = wire.collaborator.Get( "collaborator" );
+#else
+            desc.collaborator = ( wire.collaborator.present ? wire.collaborator.value : wire.plug.Get( "plug" ) );
+#endif
+            sink.OnWire( desc );
+        }
+    }
+
+    void CloseField()
+    {
+        if ( IsPartsSection() )
+        {
+            if ( field == "name" ) name.Set( text );
+            else if ( field == "class" ) cl.Set( text );
+            else if ( field == "parameter1" ) CloseParameter( part.parameter1 );
+            else if ( field == "parameter2" ) CloseParameter( part.parameter2 );
+            else if ( field == "shared" && ! Codec< bool >::Decode( text, part.shared ) )
+                throw WrongFile( "Wrong value of shared (" + text + ")" );
+            else if ( field == "attribute" )
+                part.attributes.push_back( PartDesc::AttributeDesc( attribute.name.Get( "name" ), attribute.value.Get( "value" ) ) );
+        }
+        else if ( section == "wiring" )
+        {
+            if ( field == "source" ) wire.source.Set( text );
+            else if ( field == "dest" ) wire.dest.Set( text );
+            else if ( field == "collaborator" ) wire.collaborator.Set( text );
+            else if ( field == "plug" ) wire.plug.Set( text );
+        }
+    }
+
+    void CloseSubfield()
+    {
+        if ( ! IsPartsSection() ) return;
+        if ( field == "parameter1" || field == "parameter2" )
+        {
+            if ( subfield == "type" ) type.Set( text );
+            else if ( subfield == "value" ) value.Set( text );
+        }
+        else if ( field == "attribute" )
+        {
+            if ( subfield == "name" ) attribute.name.Set( text );
+            else if ( subfield == "value" ) attribute.value.Set( text );
+        }
+    }
+
+    void CloseParameter( PartDesc::Parameter& parameter )
+    {
+        if ( ! parameter.present )
+        {
+            parameter.present = true;
+            parameter.type = type.Get( "type" );
+            parameter.value = value.Get( "value" );
+        }
+        type = Field();
+        value = Field();
+    }
+
+    Sink& sink;
+    unsigned int depth;
+    std::string text; // the text of the current element
+    std::string root;
+    std::string section;
+    std::string field;
+    std::string subfield;
+
+    // the item being read
+    PartDesc part;
+    Field name;
+    Field cl;
+    Field type;
+    Field value;
+    Attribute attribute;
+    Wire wire;
+};
+
+// This class parses a configuration file using the streaming parser @c Parser,
+// and loads the plugins or populates a catalog while the file is read, so that
+// the memory needed does not depend on the size of the file.
+// The wires that refer to parts not yet created are applied at the end of the file.
+template < typename Parser >
+class StreamBasedCfg
+{
+public:
+    // throw WrongFile if the file cannot be opened
+    explicit StreamBasedCfg( const std::string& _fileName ) :
+        fileName( _fileName )
+    {
+        std::ifstream file( fileName.c_str() );
+        if ( ! file ) throw WrongFile( "cannot open file " + fileName );
+    }
+
+    // Load the plugins specified in the file.
+    // throw WrongFile if the file contains an error.
+    void LoadPlugins()
+    {
+        PluginLoader loader;
+        Parse( loader );
+    }
+
+    // Fill the catalog with the objects and relations specified in the file.
+    // throw WrongFile if the file contains an error.
+    void Fill( Catalog& catalog )
+    {
+        CatalogFiller filler( catalog );
+        Parse( filler );
+        filler.Flush();
+    }
+
+private:
+
+    struct PluginLoader
+    {
+        void OnPlugin( const std::string& shared )
+        {
+            Plugin::Load( shared + Plugin::Suffix() );
+        }
+        void OnPart( const PartDesc& ) {}
+        void OnWire( const WireDesc& ) {}
+    };
+
+    class CatalogFiller
+    {
+    public:
+        explicit CatalogFiller( Catalog& c ) : catalog( c ), sequence( 0 ) {}
+
+        void OnPlugin( const std::string& ) {}
+
+        void OnPart( const PartDesc& part )
+        {
+            const Symbol name( part.name );
+            const Symbol cl( part.cl );
+            if ( part.parameter1.present )
+            {
+                const std::string type2 = ( part.parameter2.present ? part.parameter2.type : std::string() );
+                ParameterTable::Creator create = ParameterTable::Find( part.parameter1.type, type2 );
+                if ( create == NULL )
+                    throw WrongFile( "Unknown constructor parameter types for part " + part.name );
+                create( catalog, name, cl, part.parameter1.value, part.parameter2.value );
+            }
+            else
+                catalog.Create( name, cl );
+
+            for (
+                std::vector< PartDesc::AttributeDesc >::const_iterator i = part.attributes.begin();
+                i != part.attributes.end();
+                ++i
+            )
+                set_attribute( i -> first ).of( catalog[ name ] ).to( i -> second );
+
+            if ( part.shared ) catalog.Share( name );
+
+            Resume( part.name );
+        }
+
+        void OnWire( const WireDesc& wire )
+        {
+            // the parts could follow in the file: the wire is postponed
+            // until the missing part is created, and so are the following
+            // wires of the same collaborator, to fill it in file order
+            const Key key( wire.source, wire.collaborator );
+            Queues::iterator queue = queues.find( key );
+            if ( queue == queues.end() && Ready( wire ) )
+            {
+                Apply( wire );
+                return;
+            }
+            pending.insert( std::make_pair( sequence, wire ) );
+            if ( queue == queues.end() )
+            {
+                queues[ key ].push_back( sequence );
+                Wait( key, wire );
+            }
+            else
+                queue -> second.push_back( sequence );
+            ++sequence;
+        }
+
+        // apply the wires still postponed (in file order): their parts are
+        // missing, so an exception is thrown
+        void Flush()
+        {
+            for ( Pending::const_iterator i = pending.begin(); i != pending.end(); ++i )
+                Apply( i -> second );
+            pending.clear();
+            queues.clear();
+            waiting.clear();
+        }
+
+    private:
+        // a collaborator: the name of its part and its own name
+        typedef std::pair< std::string, std::string > Key;
+        // the wires postponed, by their sequence number in the file
+        typedef std::map< unsigned long, WireDesc > Pending;
+        // the sequence numbers of the wires postponed for each collaborator
+        typedef std::map< Key, std::deque< unsigned long > > Queues;
+        // the collaborators whose first wire postponed is waiting for a part, by the part name
+        typedef std::multimap< std::string, Key > Waiting;
+
+        bool Ready( const WireDesc& wire ) const
+        {
+            return catalog.Contains( wire.source ) && catalog.Contains( wire.dest );
+        }
+
+        void Apply( const WireDesc& wire )
+        {
+            use( catalog[ wire.dest ] ).as( wire.collaborator ).of( catalog[ wire.source ] );
+        }
+
+        // wait for the part missing for @c wire, the first one postponed of @c key
+        void Wait( const Key& key, const WireDesc& wire )
+        {
+            const std::string& missing = ( catalog.Contains( wire.source ) ? wire.dest : wire.source );
+            waiting.insert( std::make_pair( missing, key ) );
+        }
+
+        // apply the wires waiting for the part @c name, just created
+        void Resume( const std::string& name )
+        {
+            const std::pair< Waiting::iterator, Waiting::iterator > range = waiting.equal_range( name );
+            if ( range.first == range.second ) return;
+            std::vector< Key > keys;
+            for ( Waiting::const_iterator i = range.first; i != range.second; ++i )
+                keys.push_back( i -> second );
+            waiting.erase( range.first, range.second );
+            for ( std::vector< Key >::const_iterator i = keys.begin(); i != keys.end(); ++i )
+                Drain( *i );
+        }
+
+        // apply the wires postponed of the collaborator @c key, in file order,
+        // until one of them is still missing a part
+        void Drain( const Key& key )
+        {
+            const Queues::iterator queue = queues.find( key );
+            std::deque< unsigned long >& wires = queue -> second;
+            while ( ! wires.empty() )
+            {
+                const Pending::iterator wire = pending.find( wires.front() );
+                if ( ! Ready( wire -> second ) )
+                {
+                    Wait( key, wire -> second );
+                    return;
+                }
+                Apply( wire -> second );
+                pending.erase( wire );
+                wires.pop_front();
+            }
+            queues.erase( queue );
+        }
+
+        Catalog& catalog;
+        unsigned long sequence; // of the next wire in the file
+        Pending pending;
+        Queues queues;
+        Waiting waiting;
+    };
+
+    template < typename Sink >
+    void Parse( Sink& sink )
+    {
+        std::ifstream file( fileName.c_str(), std::ios::binary );
+        if ( ! file ) throw WrongFile( "cannot open file " + fileName );
+        CfgBuilder< Sink > builder( sink );
+        Parser parser( file, fileName );
+        parser.Parse( builder );
+    }
+
+    const std::string fileName;
+};
+
+} // namespace detail
+} // namespace wallaroo
+
+#endif // WALLAROO_DETAIL_STREAMBASEDCFG_H_
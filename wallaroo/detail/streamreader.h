@@ -0,0 +1,144 @@
+/*******************************************************************************
+ * wallaroo - A library for configurable creation and wiring of C++ classes.
+ * Copyright (C) 2012 Daniele Pallastrelli
+ *
+ * This file is part of wallaroo.
+ * For more information, see http://wallaroo.googlecode.com/
+ *
+ * Boost Software License - Version 1.0 - August 17th, 2003
+ *
+ * Permission is hereby granted, free of charge, to any person or organization
+ * obtaining a copy of the software and accompanying documentation covered by
+ * this license (the "Software") to use, reproduce, display, distribute,
+ * execute, and transmit the Software, and to prepare derivative works of the
+ * Software, and to permit third-parties to whom the Software is furnished to
+ * do so, all subject to the following:
+ *
+ * The copyright notices in the Software and this entire statement, including
+ * the above license grant, this restriction and the following disclaimer,
+ * must be included in all copies of the Software, in whole or in part, and
+ * all derivative works of the Software, unless such copies or derivative
+ * works are solely in the form of machine-executable object code generated by
+ * a source language processor.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT
+ * SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE
+ * FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE,
+ * ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ ******************************************************************************/
+
+#ifndef WALLAROO_DETAIL_STREAMREADER_H_
+#define WALLAROO_DETAIL_STREAMREADER_H_
+
+#include <string>
+#include <istream>
+#include <sstream>
+#include <cstdio>
+#include "wallaroo/exceptions.h"
+
+namespace wallaroo
+{
+namespace detail
+{
+
+// This class reads a character stream one character at a time,
+// keeping track of the current line for the error messages.
+// It's used by the streaming parsers of the configuration files.
+class StreamReader
+{
+public:
+    static const int End = EOF;
+
+    StreamReader( std::istream& s, const std::string& n ) :
+        buffer( s.rdbuf() ),
+        name( n ),
+        line( 1 )
+    {
+    }
+
+    // Return the next character without extracting it (End at the end of the stream).
+    int Peek() const
+    {
+        return buffer -> sgetc();
+    }
+
+    // Extract the next character (End at the end of the stream).
+    int Get()
+    {
+        const int c = buffer -> sbumpc();
+        if ( c == '\n' ) ++line;
+        return c;
+    }
+
+    // Extract the next character, that must be @c c.
+    // throw WrongFile otherwise.
+    void Expect( char c )
+    {
+        if ( Get() != c ) Error( std::string( "expected '" ) + c + "'" );
+    }
+
+    // Extract the characters of @c s, that must follow in the stream.
+    // throw WrongFile otherwise.
+    void Expect( const char* s )
+    {
+        for ( ; *s != '\0'; ++s ) Expect( *s );
+    }
+
+    void SkipSpaces()
+    {
+        while ( IsSpace( Peek() ) ) Get();
+    }
+
+    static bool IsSpace( int c )
+    {
+        return c == ' ' || c == '\t' || c == '\n' || c == '\r';
+    }
+
+    // The UTF-8 encoding of the unicode code point @c code.
+    static std::string Utf8( unsigned long code )
+    {
+        std::string s;
+        if ( code < 0x80 )
+            s += static_cast< char >( code );
+        else if ( code < 0x800 )
+        {
+            s += static_cast< char >( 0xC0 | ( code >> 6 ) );
+            s += static_cast< char >( 0x80 | ( code & 0x3F ) );
+        }
+        else if ( code < 0x10000 )
+        {
+            s += static_cast< char >( 0xE0 | ( code >> 12 ) );
+            s += static_cast< char >( 0x80 | ( ( code >> 6 ) & 0x3F ) );
+            s += static_cast< char >( 0x80 | ( code & 0x3F ) );
+        }
+        else
+        {
+            s += static_cast< char >( 0xF0 | ( code >> 18 ) );
+            s += static_cast< char >( 0x80 | ( ( code >> 12 ) & 0x3F ) );
+            s += static_cast< char >( 0x80 | ( ( code >> 6 ) & 0x3F ) );
+            s += static_cast< char >( 0x80 | ( code & 0x3F ) );
+        }
+        return s;
+    }
+
+    // throw WrongFile with a message containing the current position.
+    void Error( const std::string& msg ) const
+    {
+        std::ostringstream s;
+        s << name << '(' << line << "): " << msg;
+        throw WrongFile( s.str() );
+    }
+
+private:
+    std::streambuf* buffer;
+    const std::string name;
+    unsigned int line;
+};
+
+} // namespace detail
+} // namespace wallaroo
+
+#endif // WALLAROO_DETAIL_STREAMREADER_H_
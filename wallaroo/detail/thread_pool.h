@@ -0,0 +1,138 @@
+/*******************************************************************************
+ * wallaroo - A library for configurable creation and wiring of C++ classes.
+ * Copyright (C) 2012 Daniele Pallastrelli
+ *
+ * This file is part of wallaroo.
+ * For more information, see http://wallaroo.googlecode.com/
+ *
+ * Boost Software License - Version 1.0 - August 17th, 2003
+ *
+ * Permission is hereby granted, free of charge, to any person or organization
+ * obtaining a copy of the software and accompanying documentation covered by
+ * this license (the "Software") to use, reproduce, display, distribute,
+ * execute, and transmit the Software, and to prepare derivative works of the
+ * Software, and to permit third-parties to whom the Software is furnished to
+ * do so, all subject to the following:
+ *
+ * The copyright notices in the Software and this entire statement, including
+ * the above license grant, this restriction and the following disclaimer,
+ * must be included in all copies of the Software, in whole or in part, and
+ * all derivative works of the Software, unless such copies or derivative
+ * works are solely in the form of machine-executable object code generated by
+ * a source language processor.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT
+ * SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE
+ * FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE,
+ * ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ ******************************************************************************/
+
+#ifndef WALLAROO_DETAIL_THREAD_POOL_H_
+#define WALLAROO_DETAIL_THREAD_POOL_H_
+
+#include <vector>
+#include <deque>
+#include <cstddef>
+#include "wallaroo/cxx0x.h"
+
+#ifdef WALLAROO_HAS_CXX0X
+    #include <thread>
+    #include <condition_variable>
+#else
+    #include <boost/thread/thread.hpp>
+    #include <boost/thread/condition_variable.hpp>
+    #include <boost/thread/locks.hpp>
+#endif
+
+namespace wallaroo
+{
+namespace detail
+{
+
+// A fixed set of worker threads executing the tasks posted, in FIFO order.
+// The destructor waits for the tasks already posted and joins the threads.
+// The tasks must not throw: the exceptions escaping a task are discarded.
+class ThreadPool
+{
+public:
+    typedef cxx0x::function< void() > Task;
+
+    // Start @c threads worker threads (at least one).
+    explicit ThreadPool( std::size_t threads ) : stop( false )
+    {
+        if ( threads == 0 ) threads = 1;
+        for ( std::size_t i = 0; i < threads; ++i )
+            workers.push_back( cxx0x::shared_ptr< cxx0x::thread >( new cxx0x::thread( Worker( this ) ) ) );
+    }
+
+    ~ThreadPool()
+    {
+        {
+            cxx0x::lock_guard< cxx0x::mutex > lock( mutex );
+            stop = true;
+        }
+        available.notify_all();
+        for ( std::size_t i = 0; i < workers.size(); ++i )
+            workers[ i ] -> join();
+    }
+
+    // Enqueue a task for execution by a worker thread.
+    void Post( const Task& task )
+    {
+        {
+            cxx0x::lock_guard< cxx0x::mutex > lock( mutex );
+            tasks.push_back( task );
+        }
+        available.notify_one();
+    }
+
+private:
+
+    struct Worker
+    {
+        explicit Worker( ThreadPool* p ) : pool( p ) {}
+        void operator()() { pool -> Run(); }
+        ThreadPool* pool;
+    };
+
+    void Run()
+    {
+        while ( true )
+        {
+            Task task;
+            {
+                cxx0x::unique_lock< cxx0x::mutex > lock( mutex );
+                while ( ! stop && tasks.empty() )
+                    available.wait( lock );
+                if ( tasks.empty() ) return; // stop requested and nothing left to do
+                task = tasks.front();
+                tasks.pop_front();
+            }
+            try
+            {
+                task();
+            }
+            catch ( ... )
+            {
+            }
+        }
+    }
+
+    cxx0x::mutex mutex;
+    cxx0x::condition_variable available;
+    std::deque< Task > tasks;
+    bool stop;
+    std::vector< cxx0x::shared_ptr< cxx0x::thread > > workers;
+
+    // copy ctor and assignment operator disabled
+    ThreadPool( const ThreadPool& );
+    ThreadPool& operator = ( const ThreadPool& );
+};
+
+} // namespace detail
+} // namespace wallaroo
+
+#endif // WALLAROO_DETAIL_THREAD_POOL_H_
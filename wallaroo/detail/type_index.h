@@ -0,0 +1,216 @@
+/*******************************************************************************
+ * wallaroo - A library for configurable creation and wiring of C++ classes.
+ * Copyright (C) 2012 Daniele Pallastrelli
+ *
+ * This file is part of wallaroo.
+ * For more information, see http://wallaroo.googlecode.com/
+ *
+ * Boost Software License - Version 1.0 - August 17th, 2003
+ *
+ * Permission is hereby granted, free of charge, to any person or organization
+ * obtaining a copy of the software and accompanying documentation covered by
+ * this license (the "Software") to use, reproduce, display, distribute,
+ * execute, and transmit the Software, and to prepare derivative works of the
+ * Software, and to permit third-parties to whom the Software is furnished to
+ * do so, all subject to the following:
+ *
+ * The copyright notices in the Software and this entire statement, including
+ * the above license grant, this restriction and the following disclaimer,
+ * must be included in all copies of the Software, in whole or in part, and
+ * all derivative works of the Software, unless such copies or derivative
+ * works are solely in the form of machine-executable object code generated by
+ * a source language processor.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT
+ * SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE
+ * FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE,
+ * ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ ******************************************************************************/
+
+#ifndef WALLAROO_DETAIL_TYPE_INDEX_H_
+#define WALLAROO_DETAIL_TYPE_INDEX_H_
+
+#include <map>
+#include <string>
+#include <vector>
+#include <utility>
+#include <typeinfo>
+#include <cstddef>
+#include "wallaroo/cxx0x.h"
+#include "wallaroo/part.h"
+
+namespace wallaroo
+{
+namespace detail
+{
+
+// This class keeps, for each type ever requested with All(), the dense
+// array of the parts of a catalog assignable to it, updated when the
+// parts are added. Nothing is stored until a type is requested: the array
+// of a type is built on its first request from the parts of the catalog
+// (see Enumerate).
+// Whether a class is assignable to a type (and the offset of the
+// subobject of that type from the Part subobject) is computed with
+// a dynamic_cast on the first part of the class, and then shared by all
+// its instances: adding a part or building an array never needs
+// a dynamic_cast per part.
+// The classes are identified by their name, so that nothing refers to
+// the type_info of a class after its plugin has been unloaded.
+// NOTE: the offset of a subobject depends only on the most derived class.
+// NOTE: the calls must be serialized by the caller (the catalog mutex).
+class TypeIndex
+{
+public:
+
+    typedef std::ptrdiff_t Offset;
+
+    // The parts assignable to the type T, in the order they've been added:
+    // the pointers to their T subobjects, the same pointers sharing
+    // the ownership of the parts, and the pointers to the parts.
+    template < class T >
+    struct Matches
+    {
+        std::vector< T* > pointers;
+        std::vector< cxx0x::shared_ptr< T > > parts;
+        std::vector< const Part* > sources;
+    };
+
+    // The function that appends to @c parts the parts of @c owner (the catalog),
+    // in the order they've been added.
+    typedef void ( *Enumerate )( const void* owner, std::vector< cxx0x::shared_ptr< Part > >& parts );
+
+    TypeIndex( const void* o, Enumerate e ) : owner( o ), enumerate( e ) {}
+
+    // Add a part (the caller checks it has not been added yet).
+    void Add( const cxx0x::shared_ptr< Part >& part )
+    {
+        if ( views.empty() ) return;
+        const std::string cls( typeid( *part ).name() );
+        try
+        {
+            for ( Views::iterator v = views.begin(); v != views.end(); ++v )
+                v -> second -> Add( cls, part );
+        }
+        catch ( ... )
+        {
+            for ( Views::iterator v = views.begin(); v != views.end(); ++v )
+                v -> second -> Remove( part.get() );
+            throw;
+        }
+    }
+
+    // Remove the last part added, to roll back a failed insertion.
+    void RemoveLast( Part* part )
+    {
+        for ( Views::iterator v = views.begin(); v != views.end(); ++v )
+            v -> second -> Remove( part );
+    }
+
+    // Return the parts assignable to the type T.
+    // The first request for T builds its arrays from the parts of the catalog;
+    // the following ones just return them (and the arrays are copied only
+    // when a new part has been added in the meantime).
+    template < class T >
+    cxx0x::shared_ptr< const Matches< T > > All() const
+    {
+        const std::string key( typeid( TypedView< T > ).name() ); // typeid( T ) ignores the cv-qualifiers
+        Views::iterator v = views.find( key );
+        if ( v == views.end() )
+        {
+            cxx0x::shared_ptr< View > view( new TypedView< T > );
+            std::vector< cxx0x::shared_ptr< Part > > parts;
+            enumerate( owner, parts );
+            for ( std::vector< cxx0x::shared_ptr< Part > >::const_iterator p = parts.begin(); p != parts.end(); ++p )
+                view -> Add( typeid( **p ).name(), *p );
+            v = views.insert( std::make_pair( key, view ) ).first;
+        }
+        return static_cast< TypedView< T >& >( *( v -> second ) ).Snapshot();
+    }
+
+private:
+
+    struct View
+    {
+        virtual ~View() {}
+        virtual void Add( const std::string& cls, const cxx0x::shared_ptr< Part >& part ) = 0;
+        virtual void Remove( Part* part ) = 0;
+    };
+
+    template < class T >
+    class TypedView : public View
+    {
+    public:
+        virtual void Add( const std::string& cls, const cxx0x::shared_ptr< Part >& part )
+        {
+            Offset offset;
+            if ( ! Relation( cls, part.get(), offset ) ) return;
+            T* const subobject = At( part.get(), offset );
+            // after the allocations the arrays are updated together without throwing
+            Grow( current.pointers );
+            Grow( current.parts );
+            Grow( current.sources );
+            current.pointers.push_back( subobject );
+            current.parts.push_back( cxx0x::shared_ptr< T >( part, subobject ) );
+            current.sources.push_back( part.get() );
+            snapshot.reset();
+        }
+        virtual void Remove( Part* part )
+        {
+            if ( current.sources.empty() || current.sources.back() != part ) return;
+            current.sources.pop_back();
+            current.parts.pop_back();
+            current.pointers.pop_back();
+            snapshot.reset();
+        }
+        cxx0x::shared_ptr< const Matches< T > > Snapshot()
+        {
+            if ( ! snapshot ) snapshot.reset( new Matches< T >( current ) );
+            return snapshot;
+        }
+    private:
+        // Tell whether the class @c cls (the class of @c part) is assignable
+        // to T and, if so, set @c offset to the offset of the T subobject.
+        // The result is computed once per class and then cached.
+        bool Relation( const std::string& cls, Part* part, Offset& offset )
+        {
+            Relations::const_iterator i = relations.find( cls );
+            if ( i == relations.end() )
+            {
+                T* subobject = dynamic_cast< T* >( part );
+                std::pair< bool, Offset > relation( subobject != NULL, 0 );
+                if ( subobject != NULL )
+                    relation.second = reinterpret_cast< const char* >( subobject ) - reinterpret_cast< const char* >( part );
+                i = relations.insert( std::make_pair( cls, relation ) ).first;
+            }
+            offset = i -> second.second;
+            return i -> second.first;
+        }
+        static T* At( Part* part, Offset offset )
+        {
+            return reinterpret_cast< T* >( reinterpret_cast< char* >( part ) + offset );
+        }
+        template < typename V >
+        static void Grow( V& v )
+        {
+            if ( v.size() == v.capacity() ) v.reserve( 2 * v.size() + 1 );
+        }
+        typedef std::map< std::string, std::pair< bool, Offset > > Relations;
+        Relations relations; // by class name
+        Matches< T > current;
+        cxx0x::shared_ptr< const Matches< T > > snapshot; // empty when out of date
+    };
+
+    typedef std::map< std::string, cxx0x::shared_ptr< View > > Views;
+
+    const void* const owner;
+    const Enumerate enumerate;
+    mutable Views views; // the arrays are built when requested, by type name
+};
+
+} // namespace detail
+} // namespace wallaroo
+
+#endif // WALLAROO_DETAIL_TYPE_INDEX_H_
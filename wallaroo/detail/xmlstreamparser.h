@@ -0,0 +1,294 @@
+/*******************************************************************************
+ * wallaroo - A library for configurable creation and wiring of C++ classes.
+ * Copyright (C) 2012 Daniele Pallastrelli
+ *
+ * This file is part of wallaroo.
+ * For more information, see http://wallaroo.googlecode.com/
+ *
+ * Boost Software License - Version 1.0 - August 17th, 2003
+ *
+ * Permission is hereby granted, free of charge, to any person or organization
+ * obtaining a copy of the software and accompanying documentation covered by
+ * this license (the "Software") to use, reproduce, display, distribute,
+ * execute, and transmit the Software, and to prepare derivative works of the
+ * Software, and to permit third-parties to whom the Software is furnished to
+ * do so, all subject to the following:
+ *
+ * The copyright notices in the Software and this entire statement, including
+ * the above license grant, this restriction and the following disclaimer,
+ * must be included in all copies of the Software, in whole or in part, and
+ * all derivative works of the Software, unless such copies or derivative
+ * works are solely in the form of machine-executable object code generated by
+ * a source language processor.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT
+ * SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE
+ * FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE,
+ * ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ ******************************************************************************/
+
+#ifndef WALLAROO_DETAIL_XMLSTREAMPARSER_H_
+#define WALLAROO_DETAIL_XMLSTREAMPARSER_H_
+
+#include <string>
+#include <vector>
+#include <istream>
+#include "streamreader.h"
+
+namespace wallaroo
+{
+namespace detail
+{
+
+// This class parses a xml document from a stream, without building it in memory.
+// For each element it calls the methods of a handler:
+//   Open( tag ) when the element starts,
+//   Text( text ) for the text content (whitespaces are trimmed and condensed),
+//   Close() when the element ends.
+// XML attributes, comments, processing instructions and the DOCTYPE are skipped.
+// Only the stack of the open tags is kept in memory.
+class XmlStreamParser
+{
+public:
+    // @c name is the name of the stream in the error messages.
+    XmlStreamParser( std::istream& s, const std::string& name ) : reader( s, name ) {}
+
+    // Parse the whole document.
+    // throw WrongFile if the document is not well formed.
+    template < typename Handler >
+    void Parse( Handler& handler )
+    {
+        bool root = false;
+        std::string text;
+        for ( int c = reader.Peek(); c != StreamReader::End; c = reader.Peek() )
+        {
+            if ( c != '<' )
+            {
+                ParseText( text );
+                continue;
+            }
+            reader.Get();
+            c = reader.Peek();
+            if ( c == '?' )
+                ReadUntil( "?>", NULL );
+            else if ( c == '!' )
+                ParseMarkup( text );
+            else if ( c == '/' )
+            {
+                reader.Get();
+                if ( tags.empty() || ParseName() != tags.back() ) reader.Error( "mismatched end tag" );
+                reader.SkipSpaces();
+                reader.Expect( '>' );
+                Flush( handler, text );
+                tags.pop_back();
+                handler.Close();
+            }
+            else
+            {
+                if ( tags.empty() && root ) reader.Error( "multiple root elements" );
+                Flush( handler, text );
+                root = true;
+                const std::string tag = ParseName();
+                handler.Open( tag );
+                if ( ParseAttributes() )
+                    handler.Close(); // empty element
+                else
+                    tags.push_back( tag );
+            }
+        }
+        if ( ! text.empty() ) reader.Error( "data outside the root element" );
+        if ( ! root ) reader.Error( "no root element" );
+        if ( ! tags.empty() ) reader.Error( "unexpected end of data" );
+    }
+
+private:
+
+    // emit the text collected so far, trimmed
+    template < typename Handler >
+    void Flush( Handler& handler, std::string& text )
+    {
+        if ( ! text.empty() && text[ text.size() - 1 ] == ' ' ) text.erase( text.size() - 1 );
+        if ( ! text.empty() )
+        {
+            if ( tags.empty() ) reader.Error( "data outside the root element" );
+            handler.Text( text );
+        }
+        text.clear();
+    }
+
+    // collect the character data up to the next tag, condensing the whitespaces
+    void ParseText( std::string& text )
+    {
+        for ( int c = reader.Peek(); c != '<' && c != StreamReader::End; c = reader.Peek() )
+        {
+            if ( StreamReader::IsSpace( c ) )
+            {
+                reader.Get();
+                if ( ! text.empty() && text[ text.size() - 1 ] != ' ' ) text += ' ';
+            }
+            else if ( c == '&' )
+                text += ParseEntity();
+            else
+                text += static_cast< char >( reader.Get() );
+        }
+    }
+
+    // comments, CDATA sections and DOCTYPE. The '<' has already been read.
+    void ParseMarkup( std::string& text )
+    {
+        reader.Get(); // '!'
+        if ( reader.Peek() == '-' )
+        {
+            reader.Expect( "--" );
+            ReadUntil( "-->", NULL );
+        }
+        else if ( reader.Peek() == '[' )
+        {
+            reader.Expect( "[CDATA[" );
+            ReadUntil( "]]>", &text );
+        }
+        else
+        {
+            // DOCTYPE, possibly with an internal subset
+            int nesting = 0;
+            for ( int c = reader.Get(); c != '>' || nesting > 0; c = reader.Get() )
+            {
+                if ( c == StreamReader::End ) reader.Error( "unexpected end of data" );
+                if ( c == '[' ) ++nesting;
+                if ( c == ']' ) --nesting;
+            }
+        }
+    }
+
+    // skip the attributes of a start tag.
+    // Return true if the element is empty (i.e., the tag ends with "/>")
+    bool ParseAttributes()
+    {
+        while ( true )
+        {
+            reader.SkipSpaces();
+            const int c = reader.Get();
+            if ( c == '>' ) return false;
+            if ( c == '/' )
+            {
+                reader.Expect( '>' );
+                return true;
+            }
+            if ( c == StreamReader::End ) reader.Error( "unexpected end of data" );
+            if ( c == '"' || c == '\'' )
+            {
+                for ( int q = reader.Get(); q != c; q = reader.Get() )
+                    if ( q == StreamReader::End ) reader.Error( "unexpected end of data" );
+            }
+        }
+    }
+
+    std::string ParseName()
+    {
+        std::string name;
+        for ( int c = reader.Peek(); IsNameChar( c ); c = reader.Peek() )
+            name += static_cast< char >( reader.Get() );
+        if ( name.empty() ) reader.Error( "expected element name" );
+        return name;
+    }
+
+    static bool IsNameChar( int c )
+    {
+        return c != StreamReader::End && ! StreamReader::IsSpace( c ) &&
+               c != '>' && c != '/' && c != '<' && c != '=' && c != '"' && c != '\'';
+    }
+
+    // decode a reference to a predefined entity or a character reference
+    std::string ParseEntity()
+    {
+        reader.Get(); // '&'
+        std::string entity;
+        for ( int c = reader.Get(); c != ';'; c = reader.Get() )
+        {
+            if ( c == StreamReader::End || entity.size() > 10 ) reader.Error( "invalid entity reference" );
+            entity += static_cast< char >( c );
+        }
+        if ( entity == "lt" ) return "<";
+        if ( entity == "gt" ) return ">";
+        if ( entity == "amp" ) return "&";
+        if ( entity == "quot" ) return "\"";
+        if ( entity == "apos" ) return "'";
+        if ( entity.size() > 1 && entity[ 0 ] == '#' )
+        {
+            const bool hex = ( entity[ 1 ] == 'x' );
+            unsigned long code = 0;
+            for ( std::size_t i = ( hex ? 2 : 1 ); i < entity.size(); ++i )
+            {
+                const int digit = Digit( entity[ i ], hex );
+                if ( digit < 0 ) reader.Error( "invalid character reference" );
+                code = code * ( hex ? 16 : 10 ) + digit;
+            }
+            return StreamReader::Utf8( code );
+        }
+        reader.Error( "unknown entity &" + entity + ";" );
+        return std::string();
+    }
+
+    static int Digit( char c, bool hex )
+    {
+        if ( c >= '0' && c <= '9' ) return c - '0';
+        if ( hex && c >= 'a' && c <= 'f' ) return c - 'a' + 10;
+        if ( hex && c >= 'A' && c <= 'F' ) return c - 'A' + 10;
+        return -1;
+    }
+
+    // read everything up to the string @c end (included), appending
+    // the characters before @c end to *text (if text is not NULL)
+    void ReadUntil( const std::string& end, std::string* text )
+    {
+        std::size_t matched = 0;
+        while ( matched < end.size() )
+        {
+            const int c = reader.Get();
+            if ( c == StreamReader::End ) reader.Error( "unexpected end of data" );
+            matched = Advance( end, matched, static_cast< char >( c ), text );
+        }
+    }
+
+    // The number of characters of @c end matched after reading @c c, when
+    // the first @c matched characters were matched. The longest prefix of @c end
+    // that is a suffix of the characters read is kept, so that i.e. "]]]>"
+    // matches "]]>" after a ']'. The characters that can no longer be part of
+    // @c end are appended to *skipped (if skipped is not NULL).
+    static std::size_t Advance( const std::string& end, std::size_t matched, char c, std::string* skipped )
+    {
+        if ( c == end[ matched ] ) return matched + 1;
+        // the characters read are end[ 0 .. matched ) followed by c
+        std::size_t length = matched + 1;
+        for ( std::size_t k = matched; k > 0; --k )
+        {
+            // is end[ 0 .. k ) a suffix of the characters read?
+            const std::size_t start = length - k;
+            bool suffix = ( end[ k - 1 ] == c );
+            for ( std::size_t j = 0; suffix && j + 1 < k; ++j )
+                suffix = ( end[ j ] == end[ start + j ] );
+            if ( suffix )
+            {
+                if ( skipped != NULL ) skipped -> append( end, 0, start );
+                return k;
+            }
+        }
+        if ( skipped != NULL )
+        {
+            skipped -> append( end, 0, matched );
+            *skipped += c;
+        }
+        return 0;
+    }
+
+    StreamReader reader;
+    std::vector< std::string > tags; // the elements currently open
+};
+
+} // namespace detail
+} // namespace wallaroo
+
+#endif // WALLAROO_DETAIL_XMLSTREAMPARSER_H_
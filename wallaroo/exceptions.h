@@ -34,6 +34,9 @@
 #define WALLAROO_EXCEPTIONS_H_
 
 #include <stdexcept>
+#include <string>
+#include <vector>
+#include <utility>
 
 namespace wallaroo
 {
@@ -161,6 +164,30 @@ private:
 };
 
 
+/** Error indicating that an item was added to a catalog after Catalog::Freeze.
+*   Derives from WallarooError.
+*/
+class FrozenCatalog : public WallarooError
+{
+public:
+    /// Instantiate a FrozenCatalog
+    FrozenCatalog( const std::string& _element ) :
+        WallarooError( "cannot add " + _element + ": the catalog is frozen" ),
+        element( _element )
+    {
+    }
+    ~FrozenCatalog() throw()
+    {
+    }
+    const std::string& Element() const
+    {
+        return element;
+    }
+private:
+    const std::string element;
+};
+
+
 /** Error indicating that the file does not exist or contains a semantic error.
 *   Derives from WallarooError.
 */
@@ -201,6 +228,161 @@ private:
     const std::string element;
 };
 
+/** Error indicating that a collaborator left unwired could be wired
+*   to more than one part by Catalog::Autowire.
+*   Derives from WallarooError.
+*/
+class AmbiguousWiring : public WallarooError
+{
+public:
+    /// Instantiate an AmbiguousWiring
+    /// @param _part The name of the part containing the collaborator
+    /// @param _collaborator The name of the collaborator
+    /// @param _candidates The names of the parts the collaborator could be wired to
+    AmbiguousWiring( const std::string& _part, const std::string& _collaborator, const std::vector< std::string >& _candidates ) :
+        WallarooError( _part + "." + _collaborator + " can be wired to more than one part: " + Join( _candidates ) ),
+        part( _part ),
+        collaborator( _collaborator ),
+        candidates( _candidates )
+    {
+    }
+    ~AmbiguousWiring() throw()
+    {
+    }
+    /// The name of the part containing the collaborator
+    const std::string& PartName() const
+    {
+        return part;
+    }
+    /// The name of the collaborator
+    const std::string& CollaboratorName() const
+    {
+        return collaborator;
+    }
+    /// The names of the parts the collaborator could be wired to
+    const std::vector< std::string >& Candidates() const
+    {
+        return candidates;
+    }
+private:
+    static std::string Join( const std::vector< std::string >& names )
+    {
+        std::string result;
+        for ( std::vector< std::string >::const_iterator i = names.begin(); i != names.end(); ++i )
+            result += ( i == names.begin() ? "" : ", " ) + *i;
+        return result;
+    }
+    const std::string part;
+    const std::string collaborator;
+    const std::vector< std::string > candidates;
+};
+
+/** Error indicating that the collaborators of some parts form a cycle,
+*   so that there is no order in which the parts can be initialized.
+*   Derives from WallarooError.
+*/
+class CyclicDependencyError : public WallarooError
+{
+public:
+    /// Instantiate a CyclicDependencyError
+    /// @param _cycle The names of the parts in the cycle (the first one is repeated at the end)
+    CyclicDependencyError( const std::vector< std::string >& _cycle ) :
+        WallarooError( "cyclic dependency: " + Join( _cycle ) ),
+        cycle( _cycle )
+    {
+    }
+    ~CyclicDependencyError() throw()
+    {
+    }
+    /// The names of the parts in the cycle (the first one is repeated at the end)
+    const std::vector< std::string >& Cycle() const
+    {
+        return cycle;
+    }
+private:
+    static std::string Join( const std::vector< std::string >& names )
+    {
+        std::string result;
+        for ( std::vector< std::string >::const_iterator i = names.begin(); i != names.end(); ++i )
+            result += ( i == names.begin() ? "" : " -> " ) + *i;
+        return result;
+    }
+    const std::vector< std::string > cycle;
+};
+
+/** Base class for the errors collecting the failures of several parts
+*   (see InitError and StopError). Derives from WallarooError.
+*/
+class PartsError : public WallarooError
+{
+public:
+    typedef std::pair< std::string, std::string > Failure; ///< name of the part, description of the failure
+    typedef std::vector< Failure > Failures;
+
+    /// Instantiate a PartsError
+    PartsError( const std::string& what, const Failures& _failures ) :
+        WallarooError( what + ": " + Join( _failures ) ),
+        failures( _failures )
+    {
+    }
+    ~PartsError() throw()
+    {
+    }
+    /// The parts that failed, with the description of the failure
+    const Failures& Parts() const
+    {
+        return failures;
+    }
+private:
+    static std::string Join( const Failures& failures )
+    {
+        std::string result;
+        for ( Failures::const_iterator i = failures.begin(); i != failures.end(); ++i )
+            result += ( i == failures.begin() ? "" : "; " ) + i -> first + ": " + i -> second;
+        return result;
+    }
+    const Failures failures;
+};
+
+/** Error indicating that the Part::Init (or Part::Start) of one or more parts
+*   threw an exception while the catalog was being initialized (or started)
+*   by a pool of threads.
+*   It collects the messages of all the exceptions.
+*   Derives from PartsError.
+*/
+class InitError : public PartsError
+{
+public:
+    /// Instantiate an InitError
+    InitError( const Failures& _failures ) :
+        PartsError( "init error", _failures )
+    {
+    }
+    ~InitError() throw()
+    {
+    }
+};
+
+/** Error indicating that the Part::Stop of one or more parts threw an
+*   exception or did not return within the timeout while the catalog was
+*   being stopped by Catalog::Stop( threads, timeout ).
+*   It collects the messages of all the exceptions ("timeout" for the
+*   parts that did not stop in time).
+*   Derives from PartsError.
+*/
+class StopError : public PartsError
+{
+public:
+    /// Instantiate a StopError
+    StopError( const Failures& _failures ) :
+        PartsError( "stop error", _failures )
+    {
+    }
+    ~StopError() throw()
+    {
+    }
+};
+
 } // namespace
 
 #endif
@@ -62,7 +62,8 @@ namespace wallaroo
     [
       {
         "name": "instance1",
-        "class": "className1"
+        "class": "className1",
+        "shared": true
       },
 
       {
@@ -115,6 +116,8 @@ namespace wallaroo
 
 }
 \endcode
+* A part marked with @c "shared": true is shared by all the replicas
+* of the catalog (see Catalog::Share and Replicas).
 */
 class JsonConfiguration : private detail::PtreeBasedCfg
 {
@@ -152,6 +155,20 @@ public:
     {
         detail::PtreeBasedCfg::Fill( catalog );
     }
+
+    /** Declare in the @c catalog the objects and relations specified in the file,
+     * without creating them: each object is created (and wired) the first time
+     * it's looked up in the catalog, either directly or because an object wired
+     * to it has been looked up (see Catalog::Declare).
+     * This configuration object can be destroyed afterwards.
+     * @param catalog The catalog target of the new items of the file.
+     * @throw WrongFile If the file contains a semantic error. The errors in the
+     *        description of an object are reported when it's created.
+     */
+    void FillLazily( Catalog& catalog )
+    {
+        detail::PtreeBasedCfg::FillLazily( catalog );
+    }
 private:
     ptree tree;
 };
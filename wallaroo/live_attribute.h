@@ -0,0 +1,166 @@
+/*******************************************************************************
+ * wallaroo - A library for configurable creation and wiring of C++ classes.
+ * Copyright (C) 2012 Daniele Pallastrelli
+ *
+ * This file is part of wallaroo.
+ * For more information, see http://wallaroo.googlecode.com/
+ *
+ * Boost Software License - Version 1.0 - August 17th, 2003
+ *
+ * Permission is hereby granted, free of charge, to any person or organization
+ * obtaining a copy of the software and accompanying documentation covered by
+ * this license (the "Software") to use, reproduce, display, distribute,
+ * execute, and transmit the Software, and to prepare derivative works of the
+ * Software, and to permit third-parties to whom the Software is furnished to
+ * do so, all subject to the following:
+ *
+ * The copyright notices in the Software and this entire statement, including
+ * the above license grant, this restriction and the following disclaimer,
+ * must be included in all copies of the Software, in whole or in part, and
+ * all derivative works of the Software, unless such copies or derivative
+ * works are solely in the form of machine-executable object code generated by
+ * a source language processor.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT
+ * SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE
+ * FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE,
+ * ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ ******************************************************************************/
+
+#ifndef WALLAROO_LIVE_ATTRIBUTE_H_
+#define WALLAROO_LIVE_ATTRIBUTE_H_
+
+#include <string>
+#include <iostream>
+#include <typeinfo>
+#include "cxx0x.h"
+#include "part.h"
+#include "attribute.h"
+#include "deserializable_value.h"
+#include "exceptions.h"
+#include "detail/live_value.h"
+
+namespace wallaroo
+{
+
+/**
+ * This is an attribute of a part that can be assigned while other threads
+ * are reading it, i.e. to change a threshold without stopping the part.
+ * It has a type T and you can set its value at runtime by code or
+ * from a configuration file, like an Attribute.
+ *
+ * Reading the value never waits for an assignment: the arithmetic, enum
+ * and pointer types are stored in an atomic variable; the other types are
+ * copied at every assignment and each previous copy is freed as soon as
+ * the readers that are copying it are done.
+ * The assignments are serialized.
+ *
+ * Optionally, a callback is invoked with the new value after every
+ * assignment, in the thread that performs the assignment.
+ *
+ * @tparam T The type of the value contained
+ */
+template < typename T >
+class LiveAttribute : public DeserializableValue
+{
+public:
+
+    /** The type returned by Get(): a copy of the value, @c T. */
+    typedef typename detail::LiveValue< T >::Reference Reference;
+
+    /** The type of the function called when the attribute changes value. */
+    typedef cxx0x::function< void ( const T& ) > Callback;
+
+    /**
+    * Create a LiveAttribute and register it to its part so that you can
+    * assign a value to it.
+    * @param name the name of this attribute
+    * @param token the registration token. You get an instance
+    *              by calling Part::RegistrationToken()
+    * @param callback the function called with the new value after every
+    *                 assignment. It must not assign this attribute.
+    */
+    LiveAttribute( const std::string& name, const RegToken& token, const Callback& callback = Callback() ) :
+        onChange( callback )
+    {
+        Part* owner = token.GetPart();
+        owner -> Register( name, this );
+    }
+
+    /** Assign a value to the LiveAttribute using a string as representation
+     * @param v the string representation of the value
+     * @throw WrongType if v cannot be converted to T
+     */
+    virtual void Value( StringView v )
+    {
+        T t = T();
+        if ( ! detail::Decode( v, t ) ) throw WrongType();
+        Set( t );
+    }
+
+    /** Assign a value to the LiveAttribute, if its type is @c T
+     * @param type the type of the value pointed by @c v
+     * @param v a pointer to the value
+     * @return false if @c type is not @c T
+     */
+    virtual bool Assign( const std::type_info& type, const void* v )
+    {
+        if ( type != typeid( T ) ) return false;
+        Set( *static_cast< const T* >( v ) );
+        return true;
+    }
+
+    /** Assign the current value of the LiveAttribute to @c other, if its type is @c T
+     * @param other the attribute to assign
+     * @return false if the type of @c other is not @c T
+     */
+    virtual bool CopyTo( DeserializableValue& other ) const
+    {
+        const Reference current = value.Get();
+        return other.Assign( typeid( T ), &current );
+    }
+
+    /** Retrieve the current value. It can be called by any thread
+     * and it never waits.
+     */
+    Reference Get() const { return value.Get(); }
+
+    /** Conversion operator to the internal type @c T. Retrieve the current value. */
+    operator T () const { return value.Get(); }
+
+    /** Assign the value @c v and invoke the callback, if any.
+     * It can be called by any thread.
+     */
+    void Set( const T& v )
+    {
+        cxx0x::lock_guard< cxx0x::mutex > lock( mutex );
+        value.Set( v );
+        if ( onChange ) onChange( v );
+    }
+
+    LiveAttribute& operator = ( const T& v ) { Set( v ); return *this; }
+
+private:
+    detail::LiveValue< T > value;
+    cxx0x::mutex mutex; // serializes the assignments
+    const Callback onChange;
+
+    // copy disabled
+    LiveAttribute( const LiveAttribute& );
+    LiveAttribute& operator = ( const LiveAttribute& );
+};
+
+// stream output operator
+template < typename T >
+std::ostream& operator << ( std::ostream& os, const LiveAttribute< T >& att )
+{
+    os << att.Get();
+    return os;
+}
+
+}
+
+#endif
@@ -0,0 +1,484 @@
+/*******************************************************************************
+ * wallaroo - A library for configurable creation and wiring of C++ classes.
+ * Copyright (C) 2012 Daniele Pallastrelli
+ *
+ * This file is part of wallaroo.
+ * For more information, see http://wallaroo.googlecode.com/
+ *
+ * Boost Software License - Version 1.0 - August 17th, 2003
+ *
+ * Permission is hereby granted, free of charge, to any person or organization
+ * obtaining a copy of the software and accompanying documentation covered by
+ * this license (the "Software") to use, reproduce, display, distribute,
+ * execute, and transmit the Software, and to prepare derivative works of the
+ * Software, and to permit third-parties to whom the Software is furnished to
+ * do so, all subject to the following:
+ *
+ * The copyright notices in the Software and this entire statement, including
+ * the above license grant, this restriction and the following disclaimer,
+ * must be included in all copies of the Software, in whole or in part, and
+ * all derivative works of the Software, unless such copies or derivative
+ * works are solely in the form of machine-executable object code generated by
+ * a source language processor.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT
+ * SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE
+ * FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE,
+ * ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ ******************************************************************************/
+
+#ifndef WALLAROO_PARAMETERS_H_
+#define WALLAROO_PARAMETERS_H_
+
+#include <string>
+#include <utility>
+#include <vector>
+#include <deque>
+#include <cstddef>
+#include "cxx0x.h"
+#include "symbol.h"
+#include "codec.h"
+#include "catalog.h"
+#include "exceptions.h"
+#include "detail/concurrent_index.h"
+
+namespace wallaroo
+{
+
+namespace detail
+{
+
+// ********************************************************
+// names of the constructor parameter types in the configuration files
+
+// The name of a type registered by the application is stored at runtime
+// by RegisterParameterType.
+// the base of the descriptions of the built-in types
+struct BuiltInTypeDesc
+{
+    enum { builtIn = true };
+};
+
+template < typename T >
+struct TypeDesc
+{
+    enum { builtIn = false };
+    static const char* Name() { return Storage().c_str(); }
+    static std::string& Storage()
+    {
+        static std::string name;
+        return name;
+    }
+};
+
+template <>
+struct TypeDesc< char > : BuiltInTypeDesc
+{
+    static const char* Name() { return "char"; }
+};
+
+template <>
+struct TypeDesc< unsigned char > : BuiltInTypeDesc
+{
+    static const char* Name() { return "unsigned char"; }
+};
+
+template <>
+struct TypeDesc< int > : BuiltInTypeDesc
+{
+    static const char* Name() { return "int"; }
+};
+
+template <>
+struct TypeDesc< unsigned int > : BuiltInTypeDesc
+{
+    static const char* Name() { return "unsigned int"; }
+};
+
+template <>
+struct TypeDesc< long > : BuiltInTypeDesc
+{
+    static const char* Name() { return "long"; }
+};
+
+template <>
+struct TypeDesc< double > : BuiltInTypeDesc
+{
+    static const char* Name() { return "double"; }
+};
+
+template <>
+struct TypeDesc< bool > : BuiltInTypeDesc
+{
+    static const char* Name() { return "bool"; }
+};
+
+template <>
+struct TypeDesc< std::string > : BuiltInTypeDesc
+{
+    static const char* Name() { return "string"; }
+};
+
+// ********************************************************
+// conversion of the constructor parameters from their string representation.
+
+// The function used to convert a string into a constructor parameter of type T.
+// It's set when the type is registered (see ParameterTable and RegisterParameterType):
+// by default it's the codec of T.
+template < typename T >
+struct ParameterParser
+{
+    typedef bool ( *Function )( StringView v, T& value );
+    static Function& Get()
+    {
+        static Function function = NULL;
+        return function;
+    }
+};
+
+// The conversion of the constructor parameters of a built-in type: the codec
+// of the type, except for unsigned char, that the configuration files have
+// always expressed as a number (e.g., <value>200</value>), while its codec
+// reads a single character.
+template < typename T >
+struct BuiltInParser
+{
+    static bool Parse( StringView v, T& value ) { return Decode( v, value ); }
+};
+
+template <>
+struct BuiltInParser< unsigned char >
+{
+    static bool Parse( StringView v, unsigned char& value )
+    {
+        const UserCodec< unsigned char >::Function decode = UserCodec< unsigned char >::Get();
+        return ( decode == NULL ? DecodeInteger( v, value ) : decode( v, value ) );
+    }
+};
+
+// The function that converts a std::string into a constructor parameter of
+// type T, when it's registered by the application (see RegisterParameterType).
+template < typename T >
+struct StringParameterParser
+{
+    typedef bool ( *Function )( const std::string& v, T& value );
+    static Function& Get()
+    {
+        static Function function = NULL;
+        return function;
+    }
+    static bool Parse( StringView v, T& value )
+    {
+        return Get()( v.str(), value );
+    }
+};
+
+// Convert v into a constructor parameter of type T.
+// throw WrongFile if v cannot be converted to T
+template < typename T >
+inline T Parameter( StringView v )
+{
+    T value = T();
+    if ( ! ParameterParser< T >::Get()( v, value ) )
+        throw WrongFile( "conversion of \"" + v.str() + "\" to type \"" + TypeDesc< T >::Name() + "\" failed" );
+    return value;
+}
+
+// ********************************************************
+
+// This class contains a table that maps the types of the constructor parameters
+// (as they're named in the configuration files) to the function that converts
+// the parameters and creates the part. The table contains the one-parameter
+// entries (with an empty second type) and the two-parameters entries of
+// every combination of the built-in types, and it can be extended with
+// the types registered by the application.
+class ParameterTable
+{
+public:
+
+    // Create the part @c instance of the class @c cl using the string
+    // representations of the constructor parameters.
+    typedef void ( *Creator )( Catalog& catalog, const Symbol& instance, const Symbol& cl, StringView v1, StringView v2 );
+
+    // Return the creator for a constructor with parameters of types @c type1
+    // and @c type2 (empty if the constructor has only one parameter),
+    // or NULL if the types have not been registered.
+    // It doesn't lock (see Creators).
+    static Creator Find( const std::string& type1, const std::string& type2 )
+    {
+        const Creators& creators = Table(); // interns the names of the built-in types
+        Symbol s1, s2;
+        if ( ! Symbol::Find( type1, s1 ) ) return NULL;
+        if ( ! type2.empty() && ! Symbol::Find( type2, s2 ) ) return NULL;
+        const Key key( s1, s2 );
+        const Entry* e = creators.index.Find( KeyHash()( key ), SameKey( key ) );
+        return ( e == NULL ? NULL : e -> creator.load( cxx0x::memory_order_acquire ) );
+    }
+
+    // Add the constructors with one parameter of type T and with
+    // two parameters of type T and a built-in type (in any order).
+    template < typename T >
+    static void Register()
+    {
+        cxx0x::lock_guard< cxx0x::mutex > lock( Mutex() );
+        Creators& creators = Table();
+        Add< T >( creators );
+        Row< T >( creators );
+        Column< T >( creators );
+        Add< T, T >( creators );
+    }
+
+    // Make @c name an alias of the built-in type T: it can be used in place
+    // of the name of T in every constructor where T appears.
+    template < typename T >
+    static void Alias( const std::string& name )
+    {
+        cxx0x::lock_guard< cxx0x::mutex > lock( Mutex() );
+        Creators& creators = Table();
+        const Symbol alias( name );
+        const Symbol type( TypeDesc< T >::Name() );
+        std::vector< std::pair< Key, Creator > > added;
+        for ( std::deque< Entry >::const_iterator i = creators.entries.begin(); i != creators.entries.end(); ++i )
+        {
+            const Key& k = i -> key;
+            const Creator c = i -> creator.load( cxx0x::memory_order_relaxed );
+            if ( k.first == type )
+                added.push_back( std::make_pair( Key( alias, k.second ), c ) );
+            if ( k.second == type )
+                added.push_back( std::make_pair( Key( k.first, alias ), c ) );
+            if ( k.first == type && k.second == type )
+                added.push_back( std::make_pair( Key( alias, alias ), c ) );
+        }
+        for ( std::size_t i = 0; i < added.size(); ++i )
+            Put( creators, added[ i ].first, added[ i ].second );
+    }
+
+    // Add the constructor with two parameters of types T1 and T2.
+    template < typename T1, typename T2 >
+    static void Register()
+    {
+        cxx0x::lock_guard< cxx0x::mutex > lock( Mutex() );
+        Add< T1, T2 >( Table() );
+    }
+
+private:
+
+    typedef std::pair< Symbol, Symbol > Key;
+    struct KeyHash
+    {
+        std::size_t operator()( const Key& k ) const { return k.first.Id() * 31 + k.second.Id(); }
+    };
+
+    // a registered constructor
+    struct Entry
+    {
+        Entry( const Key& k, Creator c ) : key( k ), creator( c ) {}
+        // (used only by the store of the entries, before publishing one)
+        Entry( const Entry& e ) : key( e.key ), creator( e.creator.load() ) {}
+        const Key key;
+        cxx0x::atomic< Creator > creator; // replaced when the constructor is registered again
+    };
+    struct SameKey
+    {
+        explicit SameKey( const Key& k ) : key( k ) {}
+        bool operator()( const Entry& e ) const { return e.key == key; }
+        const Key key;
+    };
+
+    // The registered constructors: the lookups read the index without
+    // locking, while the registrations are serialized by the mutex.
+    struct Creators
+    {
+        Creators()
+        {
+            BuiltIn< std::string >( *this );
+            BuiltIn< char >( *this );
+            BuiltIn< unsigned char >( *this );
+            BuiltIn< int >( *this );
+            BuiltIn< unsigned int >( *this );
+            BuiltIn< long >( *this );
+            BuiltIn< double >( *this );
+            BuiltIn< bool >( *this );
+        }
+        detail::ConcurrentIndex< Entry > index;
+        std::deque< Entry > entries; // a deque does not move its elements
+    };
+
+    // add (or replace) the constructor @c key (with the mutex locked)
+    static void Put( Creators& creators, const Key& key, Creator creator )
+    {
+        const std::size_t hash = KeyHash()( key );
+        const Entry* e = creators.index.Find( hash, SameKey( key ) );
+        if ( e != NULL )
+        {
+            const_cast< Entry* >( e ) -> creator.store( creator, cxx0x::memory_order_release );
+            return;
+        }
+        creators.entries.push_back( Entry( key, creator ) );
+        creators.index.Insert( hash, &creators.entries.back() );
+    }
+
+    template < typename T >
+    static void Create( Catalog& catalog, const Symbol& instance, const Symbol& cl, StringView v, StringView )
+    {
+        catalog.Create( instance, cl, Parameter< T >( v ) );
+    }
+
+    template < typename T1, typename T2 >
+    static void Create( Catalog& catalog, const Symbol& instance, const Symbol& cl, StringView v1, StringView v2 )
+    {
+        catalog.Create( instance, cl, Parameter< T1 >( v1 ), Parameter< T2 >( v2 ) );
+    }
+
+    template < typename T >
+    static void Add( Creators& creators )
+    {
+        Put( creators, Key( Symbol( TypeDesc< T >::Name() ), Symbol() ), &ParameterTable::Create< T > );
+    }
+
+    template < typename T1, typename T2 >
+    static void Add( Creators& creators )
+    {
+        Put( creators, Key( Symbol( TypeDesc< T1 >::Name() ), Symbol( TypeDesc< T2 >::Name() ) ), &ParameterTable::Create< T1, T2 > );
+    }
+
+    // the constructors with T as first parameter and a built-in type as second parameter
+    template < typename T >
+    static void Row( Creators& creators )
+    {
+        Add< T, std::string >( creators );
+        Add< T, char >( creators );
+        Add< T, unsigned char >( creators );
+        Add< T, int >( creators );
+        Add< T, unsigned int >( creators );
+        Add< T, long >( creators );
+        Add< T, double >( creators );
+        Add< T, bool >( creators );
+    }
+
+    // the constructors with a built-in type as first parameter and T as second parameter
+    template < typename T >
+    static void Column( Creators& creators )
+    {
+        Add< std::string, T >( creators );
+        Add< char, T >( creators );
+        Add< unsigned char, T >( creators );
+        Add< int, T >( creators );
+        Add< unsigned int, T >( creators );
+        Add< long, T >( creators );
+        Add< double, T >( creators );
+        Add< bool, T >( creators );
+    }
+
+    // the table, initialized with the built-in types on first use
+    static Creators& Table()
+    {
+        static Creators creators;
+        return creators;
+    }
+
+    template < typename T >
+    static void BuiltIn( Creators& creators )
+    {
+        ParameterParser< T >::Get() = &BuiltInParser< T >::Parse;
+        Add< T >( creators );
+        Row< T >( creators );
+    }
+
+    static cxx0x::mutex& Mutex()
+    {
+        static cxx0x::mutex mutex;
+        return mutex;
+    }
+};
+
+// The registration of a constructor parameter type: a type that is (or is
+// an alias of, like int64_t) a built-in type keeps its conversion and
+// its constructors, and @c name becomes another name for it.
+template < typename T, bool builtIn = TypeDesc< T >::builtIn >
+struct ParameterRegistration
+{
+    static void Register( const std::string& name )
+    {
+        ParameterParser< T >::Get() = &Decode< T >;
+        TypeDesc< T >::Storage() = name;
+        ParameterTable::Register< T >();
+    }
+    static void Register( const std::string& name, bool ( *parser )( const std::string& v, T& value ) )
+    {
+        StringParameterParser< T >::Get() = parser;
+        ParameterParser< T >::Get() = &StringParameterParser< T >::Parse;
+        TypeDesc< T >::Storage() = name;
+        ParameterTable::Register< T >();
+    }
+};
+
+// Left incomplete: a compilation error mentioning it means that a conversion
+// function has been provided for a built-in type (or an alias of it).
+template < typename T >
+struct CustomParserNotAllowedForBuiltInType;
+
+template < typename T >
+struct ParameterRegistration< T, true >
+{
+    static void Register( const std::string& name )
+    {
+        ParameterTable::Alias< T >( name );
+    }
+    static void Register( const std::string&, bool ( * )( const std::string& v, T& value ) )
+    {
+        (void)sizeof( CustomParserNotAllowedForBuiltInType< T > );
+    }
+};
+
+} // namespace detail
+
+/** Register the type @c T as a type for the constructor parameters of the
+ * parts created by the configuration files, using the function @c parser to
+ * convert the textual representation of the parameters.
+ * @param name The name of the type in the configuration files.
+ * @param parser The function that converts a string into a value of type @c T.
+ *               It returns false if the string is not a valid representation.
+ * @note @c T cannot be a built-in type or an alias of it (e.g., @c int64_t where
+ *       it's a @c long): the code doesn't compile.
+ */
+template < typename T >
+void RegisterParameterType( const std::string& name, bool ( *parser )( const std::string& v, T& value ) )
+{
+    detail::ParameterRegistration< T >::Register( name, parser );
+}
+
+/** Register the type @c T as a type for the constructor parameters of the
+ * parts created by the configuration files, in addition to the built-in
+ * types (string, char, unsigned char, int, unsigned int, long, double and bool).
+ * Afterwards, a configuration file can create the parts whose constructor
+ * takes a parameter of type @c T, possibly paired with a parameter of a built-in type.
+ * The textual representation of the parameters is converted using the codec
+ * of @c T (see RegisterCodec).
+ * If @c T is a built-in type, or an alias of it (e.g., @c int64_t is a @c long
+ * on many platforms), @c name becomes another name of the built-in type.
+ * @param name The name of the type in the configuration files.
+ */
+template < typename T >
+void RegisterParameterType( const std::string& name )
+{
+    detail::ParameterRegistration< T >::Register( name );
+}
+
+/** Allow the configuration files to create the parts whose constructor takes
+ * a first parameter of type @c T1 and a second parameter of type @c T2, when
+ * neither of them is a built-in type.
+ * Both the types must have been registered with RegisterParameterType.
+ */
+template < typename T1, typename T2 >
+void RegisterParameterTypes()
+{
+    detail::ParameterTable::Register< T1, T2 >();
+}
+
+} // namespace wallaroo
+
+#endif // WALLAROO_PARAMETERS_H_
@@ -35,16 +35,23 @@
 
 #include <string>
 #include <sstream>
+#include <typeinfo>
+#include <vector>
 #include "exceptions.h"
 #include "cxx0x.h"
 #include "dependency.h"
 #include "deserializable_value.h"
+#include "symbol.h"
+#include "detail/layout.h"
+#include "detail/intrusive_ptr.h"
 
 namespace wallaroo
 {
 
-// forward declaration:
+// forward declarations:
 class Plugin;
+class Prototype;
+namespace detail { class DependencyGraph; }
 
 /**
  * This class is a token used to ensure that Collaborators and Attributes 
@@ -72,10 +79,18 @@ private:
  * wallaroo provides mechanisms more flexible for these tasks
  * (i.e., the DSL constructs "use().as().of()" and "set_attribute().of().to()" and the
  * configuration files).
+ *
+ * If you define the symbol WALLAROO_INTRUSIVE_PARTS, the parts have an
+ * intrusive reference count and the collaborators own a reference of the
+ * parts they're linked to (see Collaborator). Each part grows by 56 bytes
+ * (with 64 bit pointers), and it's still owned by a shared_ptr with its
+ * control block.
  */
-class Part
+class Part : public detail::RefCounted
 {
 public:
+    Part() {}
+
     // we need to make Part virtual, to use dynamic_cast
     virtual ~Part() {}
 
@@ -85,12 +100,71 @@ public:
      */
     void Wire( const std::string& dependency, const cxx0x::shared_ptr< Part >& part )
     {
-        Dependencies::iterator i = dependencies.find( dependency );
-        if ( i == dependencies.end() ) throw ElementNotFound( dependency );
-        ( i -> second ) -> Link( part );
+        Symbol s;
+        if ( ! Symbol::Find( dependency, s ) ) throw ElementNotFound( dependency );
+        Wire( s, part );
+    }
+
+    /** Link the dependency @c dependency of this part into the Part @c part.
+     *  @throw ElementNotFound If @c dependency does not exist in this part.
+     *  @throw WrongType If @c part has not a type compatible with the dependency.
+     */
+    void Wire( const Symbol& dependency, const cxx0x::shared_ptr< Part >& part )
+    {
+        FindDependency( dependency ) -> Link( part );
+    }
+
+    /** Remove the link of the dependency @c dependency of this part with the Part @c part.
+     *  It can be called while other threads are using the dependency.
+     *  @return false If @c part was not linked to the dependency.
+     *  @throw ElementNotFound If @c dependency does not exist in this part.
+     */
+    bool Unwire( const std::string& dependency, const cxx0x::shared_ptr< Part >& part )
+    {
+        Symbol s;
+        if ( ! Symbol::Find( dependency, s ) ) throw ElementNotFound( dependency );
+        return Unwire( s, part );
+    }
+
+    /** Remove the link of the dependency @c dependency of this part with the Part @c part.
+     *  It can be called while other threads are using the dependency.
+     *  @return false If @c part was not linked to the dependency.
+     *  @throw ElementNotFound If @c dependency does not exist in this part.
+     */
+    bool Unwire( const Symbol& dependency, const cxx0x::shared_ptr< Part >& part )
+    {
+        return FindDependency( dependency ) -> Unlink( part );
+    }
+
+    /** Atomically link the dependency @c dependency of this part into the Part @c part
+     *  in place of the Part @c old. It can be called while other threads are using the
+     *  dependency: the calls in progress complete on @c old.
+     *  @return false If @c old was not linked to the dependency (nothing is changed).
+     *  @throw ElementNotFound If @c dependency does not exist in this part.
+     *  @throw WrongType If @c part has not a type compatible with the dependency.
+     */
+    bool Rewire( const std::string& dependency, const cxx0x::shared_ptr< Part >& old, const cxx0x::shared_ptr< Part >& part )
+    {
+        Symbol s;
+        if ( ! Symbol::Find( dependency, s ) ) throw ElementNotFound( dependency );
+        return Rewire( s, old, part );
+    }
+
+    /** Atomically link the dependency @c dependency of this part into the Part @c part
+     *  in place of the Part @c old. It can be called while other threads are using the
+     *  dependency: the calls in progress complete on @c old.
+     *  @return false If @c old was not linked to the dependency (nothing is changed).
+     *  @throw ElementNotFound If @c dependency does not exist in this part.
+     *  @throw WrongType If @c part has not a type compatible with the dependency.
+     */
+    bool Rewire( const Symbol& dependency, const cxx0x::shared_ptr< Part >& old, const cxx0x::shared_ptr< Part >& part )
+    {
+        return FindDependency( dependency ) -> Replace( old, part );
     }
 
     /** Assign a value to an attribute of the Part. 
+     *  If the attribute has exactly the type @c T, the value is assigned
+     *  directly, otherwise it's converted through its string representation.
      *  @param attribute The name of the attribute.
      *  @param value The value to assign.
      *  @throw ElementNotFound If @c attribute does not exist in this part.
@@ -100,9 +174,27 @@ public:
     template < typename T >
     void SetAttribute( const std::string& attribute, const T& value )
     {
+        Symbol s;
+        if ( ! Symbol::Find( attribute, s ) ) throw ElementNotFound( attribute );
+        SetAttribute( s, value );
+    }
+
+    /** Assign a value to an attribute of the Part. 
+     *  If the attribute has exactly the type @c T, the value is assigned
+     *  directly, otherwise it's converted through its string representation.
+     *  @param attribute The name of the attribute.
+     *  @param value The value to assign.
+     *  @throw ElementNotFound If @c attribute does not exist in this part.
+     *  @throw WrongType If @c value has not a type compatible with the attribute.
+     */
+    template < typename T >
+    void SetAttribute( const Symbol& attribute, const T& value )
+    {
+        DeserializableValue* a = FindAttribute( attribute );
+        if ( a -> Assign( typeid( T ), &value ) ) return;
         std::ostringstream stream;
         if ( !( stream << std::boolalpha << value ) ) throw WrongType();
-        SetStringAttribute( attribute, stream.str() );
+        a -> Value( stream.str() );
     }
 
    /** Check the multiplicity of its collaborators.
@@ -110,12 +202,8 @@ public:
     */
     bool MultiplicitiesOk() const
     {
-        for ( 
-            Dependencies::const_iterator i = dependencies.begin();
-            i != dependencies.end();
-            ++i
-        )
-            if ( ! i -> second -> WiringOk() )
+        for ( detail::PartLayout::Iterator i = layout.Dependencies(); ! i.End(); ++i )
+            if ( ! At< Dependency >( i -> offset ) -> WiringOk() )
                 return false;
         return true;
     }
@@ -129,6 +217,20 @@ public:
      */
     virtual void Init() {};
 
+    /** This method get called by Catalog::Start(), after Catalog::Init().
+     *  If your class has activities to launch (i.e. threads, timers, ...), you
+     *  should implement this method in the derived class.
+     *  The collaborators of the part are started before the part.
+     */
+    virtual void Start() {};
+
+    /** This method get called by Catalog::Stop().
+     *  If your class has activities to terminate or resources to release before
+     *  the destruction of the parts, you should implement this method in the derived class.
+     *  The part is stopped before its collaborators, so it can still use them.
+     */
+    virtual void Stop() {};
+
 protected:
     RegToken RegistrationToken()
     { 
@@ -143,37 +245,129 @@ private:
         plugin = p;
     }
 
+    // this method should only be invoked by Catalog::Seal
+    // to pin every collaborator of this part.
+    friend class Catalog;
+    void Pin()
+    {
+        for ( detail::PartLayout::Iterator i = layout.Dependencies(); ! i.End(); ++i )
+            At< Dependency >( i -> offset ) -> Pin();
+    }
+
+    // this method should only be invoked by Catalog::Autowire
+    // to wire by type the collaborators of this part left unwired.
+    // Returns false (and sets @c dependency and @c candidates) at
+    // the first collaborator that could be wired to more than one part.
+    bool Autowire( const detail::TypeIndex& index, Symbol& dependency, std::vector< const Part* >& candidates )
+    {
+        for ( detail::PartLayout::Iterator i = layout.Dependencies(); ! i.End(); ++i )
+            if ( ! At< Dependency >( i -> offset ) -> Autowire( index, this, candidates ) )
+            {
+                dependency = i -> name;
+                return false;
+            }
+        return true;
+    }
+
+    // these methods should only be invoked by detail::DependencyGraph
+    // to get the parts linked to the collaborators of this part.
+    friend class detail::DependencyGraph;
+    void Collaborators( std::vector< Part* >& targets ) const
+    {
+        for ( detail::PartLayout::Iterator i = layout.Dependencies(); ! i.End(); ++i )
+            At< Dependency >( i -> offset ) -> Targets( targets );
+    }
+    // append to @c linked the parts linked to the collaborators of this part
+    void LinkedParts( std::vector< cxx0x::shared_ptr< Part > >& linked ) const
+    {
+        for ( detail::PartLayout::Iterator i = layout.Dependencies(); ! i.End(); ++i )
+            At< Dependency >( i -> offset ) -> LinkedParts( linked );
+    }
+
+    // these methods should only be invoked by Prototype to copy this part.
+    friend class Prototype;
+    // append to @c names the names of the dependencies of this part
+    void DependencyNames( std::vector< Symbol >& names ) const
+    {
+        for ( detail::PartLayout::Iterator i = layout.Dependencies(); ! i.End(); ++i )
+            names.push_back( i -> name );
+    }
+    // assign the values of the attributes of this part to the attributes
+    // of @c other (that must have the same class of this part)
+    // NOTE: the attributes are looked up by name, because they can have
+    //       different offsets in other (i.e., if they're allocated on the heap).
+    void CopyAttributes( Part& other ) const
+    {
+        for ( detail::PartLayout::Iterator i = layout.Attributes(); ! i.End(); ++i )
+            At< DeserializableValue >( i -> offset ) -> CopyTo( *other.FindAttribute( i -> name ) );
+    }
+
     // this method should only be invoked by the dependencies of this part
     // to register itself into the dependencies table.
     template < class T, class P, template < typename E, typename Allocator = std::allocator< E > > class Container > friend class Collaborator;
+    // NOTE: typeid( *this ) returns the class whose constructor is running.
     void Register( const std::string& id, Dependency* c )
     {
-        dependencies[ id ] = c;
+        layout.RegisterDependency( typeid( *this ), id, OffsetOf( c ) );
     }
 
     // this method should only be invoked by the attributes of this part
     // to register itself into the attributes table.
     template < class T > friend class Attribute;
+    template < class T > friend class LiveAttribute;
     void Register( const std::string& id, DeserializableValue* attribute )
     {
-        attributes[ id ] = attribute;
+        layout.RegisterAttribute( typeid( *this ), id, OffsetOf( attribute ) );
     }
 
     // set attribute to a value represented as string.
     // throws ElementNotFound if the attribute doesn't exist.
     // throws WrongType if @c value is not a valid representation for the type of the attribute
-    void SetStringAttribute( const std::string& attribute, const std::string& value )
+    void SetStringAttribute( const std::string& attribute, StringView value )
+    {
+        Symbol s;
+        if ( ! Symbol::Find( attribute, s ) ) throw ElementNotFound( attribute );
+        SetStringAttribute( s, value );
+    }
+
+    void SetStringAttribute( const Symbol& attribute, StringView value )
     {
-        Attributes::iterator i = attributes.find( attribute );
-        if ( i == attributes.end() ) throw ElementNotFound( attribute );
-        ( i -> second ) -> Value( value );
+        FindAttribute( attribute ) -> Value( value );
     }
 
-    typedef cxx0x::unordered_map< std::string, Dependency* > Dependencies;
-    Dependencies dependencies;
+    // throws ElementNotFound if the dependency doesn't exist.
+    Dependency* FindDependency( const Symbol& dependency ) const
+    {
+        detail::Layout::Offset offset;
+        if ( ! detail::PartLayout::Find( layout.Dependencies(), dependency, offset ) ) throw ElementNotFound( dependency.Name() );
+        return At< Dependency >( offset );
+    }
 
-    typedef cxx0x::unordered_map< std::string, DeserializableValue* > Attributes;
-    Attributes attributes;
+    // throws ElementNotFound if the attribute doesn't exist.
+    DeserializableValue* FindAttribute( const Symbol& attribute ) const
+    {
+        detail::Layout::Offset offset;
+        if ( ! detail::PartLayout::Find( layout.Attributes(), attribute, offset ) ) throw ElementNotFound( attribute.Name() );
+        return At< DeserializableValue >( offset );
+    }
+
+    // offset of a member of this part from the Part subobject
+    template < typename M >
+    detail::Layout::Offset OffsetOf( const M* member ) const
+    {
+        return reinterpret_cast< const char* >( member ) - reinterpret_cast< const char* >( this );
+    }
+
+    // the member of this part at the offset specified
+    template < typename M >
+    M* At( detail::Layout::Offset offset ) const
+    {
+        return reinterpret_cast< M* >( const_cast< char* >( reinterpret_cast< const char* >( this ) + offset ) );
+    }
+
+    // the table of collaborators and attributes, shared by the instances of the class
+    // that register the same members
+    detail::PartLayout layout;
 
     cxx0x::shared_ptr< Plugin > plugin; // optional shared ptr to plugin, to release the shared library when is no more used
 };
@@ -191,6 +385,44 @@ inline void Part::SetAttribute( const std::string& attribute, const std::string&
     SetStringAttribute( attribute, value );
 }
 
+/** Assign a value to a string attribute of the part.
+ *  @param attribute The name of the attribute.
+ *  @param value The value to assign.
+ *  @throw ElementNotFound If @c attribute does not exist in this part.
+ */
+template <>
+inline void Part::SetAttribute( const Symbol& attribute, const std::string& value )
+{
+    // Optimization: with strings we don't need conversion
+    SetStringAttribute( attribute, value );
+}
+
+/** Assign a value to an attribute of the part, using its string representation
+ *  (see RegisterCodec for the conversion rules).
+ *  @param attribute The name of the attribute.
+ *  @param value The string representation of the value to assign.
+ *  @throw ElementNotFound If @c attribute does not exist in this part.
+ *  @throw WrongType If @c value is not a valid representation for the type of the attribute.
+ */
+template <>
+inline void Part::SetAttribute( const std::string& attribute, const StringView& value )
+{
+    SetStringAttribute( attribute, value );
+}
+
+/** Assign a value to an attribute of the part, using its string representation
+ *  (see RegisterCodec for the conversion rules).
+ *  @param attribute The name of the attribute.
+ *  @param value The string representation of the value to assign.
+ *  @throw ElementNotFound If @c attribute does not exist in this part.
+ *  @throw WrongType If @c value is not a valid representation for the type of the attribute.
+ */
+template <>
+inline void Part::SetAttribute( const Symbol& attribute, const StringView& value )
+{
+    SetStringAttribute( attribute, value );
+}
+
 #ifndef WALLAROO_REMOVE_DEPRECATED
 #define Device Part
 #endif
@@ -0,0 +1,203 @@
+/*******************************************************************************
+ * wallaroo - A library for configurable creation and wiring of C++ classes.
+ * Copyright (C) 2012 Daniele Pallastrelli
+ *
+ * This file is part of wallaroo.
+ * For more information, see http://wallaroo.googlecode.com/
+ *
+ * Boost Software License - Version 1.0 - August 17th, 2003
+ *
+ * Permission is hereby granted, free of charge, to any person or organization
+ * obtaining a copy of the software and accompanying documentation covered by
+ * this license (the "Software") to use, reproduce, display, distribute,
+ * execute, and transmit the Software, and to prepare derivative works of the
+ * Software, and to permit third-parties to whom the Software is furnished to
+ * do so, all subject to the following:
+ *
+ * The copyright notices in the Software and this entire statement, including
+ * the above license grant, this restriction and the following disclaimer,
+ * must be included in all copies of the Software, in whole or in part, and
+ * all derivative works of the Software, unless such copies or derivative
+ * works are solely in the form of machine-executable object code generated by
+ * a source language processor.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT
+ * SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE
+ * FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE,
+ * ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ ******************************************************************************/
+
+#ifndef WALLAROO_PROTOTYPE_H_
+#define WALLAROO_PROTOTYPE_H_
+
+#include <string>
+#include <vector>
+#include <utility>
+#include <cstddef>
+#include "cxx0x.h"
+#include "catalog.h"
+#include "dependency.h"
+#include "exceptions.h"
+#include "part.h"
+#include "symbol.h"
+
+namespace wallaroo
+{
+
+/**
+ * A wired subgraph of the parts of a catalog, used as a model to build
+ * copies of it with a single call (i.e. a graph of parts for each session).
+ *
+ * The prototype records once the class and the constructor parameters of
+ * each part, and the wiring of the parts. Then Prototype::Clone creates
+ * new instances of the parts, without looking up the classes or parsing
+ * anything, copies the current values of their attributes and wires them
+ * like the originals: a collaborator linked to a part of the prototype is
+ * linked to its copy, while a collaborator linked to a part outside the
+ * prototype is linked to the same part (that is shared by all the copies).
+ *
+ * The parts of the prototype must have been created (see Catalog::Create)
+ * after Catalog::EnableCloning, or declared (see Catalog::Declare) and not
+ * instantiated yet, in the catalog or in one of its ancestors (see
+ * Catalog::Catalog(const Catalog*)). The prototype keeps them alive, so it
+ * can outlive the catalog.
+ */
+class Prototype
+{
+public:
+    /** Build a prototype made of the parts @c ids of @c catalog.
+    * @param catalog The catalog containing the parts.
+    * @param ids The names of the parts of the prototype.
+    * @throw ElementNotFound If a part cannot be found in @c catalog.
+    * @throw DuplicatedElement If a name is repeated in @c ids.
+    * @throw WrongType If a part has not been created by @c catalog (i.e. it's
+    *        been added with Catalog::Add), or it's been created with cloning
+    *        disabled (see Catalog::EnableCloning).
+    */
+    Prototype( const Catalog& catalog, const std::vector< std::string >& ids )
+    {
+        std::vector< Symbol > symbols;
+        symbols.reserve( ids.size() );
+        for ( std::vector< std::string >::const_iterator i = ids.begin(); i != ids.end(); ++i )
+        {
+            Symbol s;
+            if ( ! Symbol::Find( *i, s ) ) throw ElementNotFound( *i );
+            symbols.push_back( s );
+        }
+        Build( catalog, symbols );
+    }
+
+    /** Build a prototype made of the parts @c ids of @c catalog.
+    * @param catalog The catalog containing the parts.
+    * @param ids The names of the parts of the prototype.
+    * @throw ElementNotFound If a part cannot be found in @c catalog.
+    * @throw DuplicatedElement If a name is repeated in @c ids.
+    * @throw WrongType If a part has not been created by @c catalog (i.e. it's
+    *        been added with Catalog::Add), or it's been created with cloning
+    *        disabled (see Catalog::EnableCloning).
+    */
+    Prototype( const Catalog& catalog, const std::vector< Symbol >& ids )
+    {
+        Build( catalog, ids );
+    }
+
+    /** Create a copy of the parts of the prototype, and add them to @c catalog
+    * with their original names. The copies are allocated in the arena of @c catalog.
+    * @param catalog The catalog that will contain the copies (it cannot be the
+    *        catalog of the prototype, because the names would clash).
+    * @throw DuplicatedElement If @c catalog already contains a part with the
+    *        name of a part of the prototype (in this case no part is added).
+    * @throw FrozenCatalog If @c catalog has been frozen.
+    */
+    void Clone( Catalog& catalog ) const
+    {
+        if ( catalog.IsFrozen() && ! nodes.empty() ) throw FrozenCatalog( nodes.front().id.Name() );
+        std::vector< cxx0x::shared_ptr< Part > > copies;
+        copies.reserve( nodes.size() );
+        for ( std::vector< Node >::const_iterator n = nodes.begin(); n != nodes.end(); ++n )
+        {
+            if ( catalog.Lookup( n -> id ) != NULL ) throw DuplicatedElement( n -> id.Name() );
+            copies.push_back( n -> recipe -> NewInstance( catalog.arena ) );
+            n -> part -> CopyAttributes( *copies.back() );
+        }
+        for ( std::vector< Edge >::const_iterator e = edges.begin(); e != edges.end(); ++e )
+        {
+            Dependency* dependency = copies[ e -> source ] -> FindDependency( e -> dependency );
+            dependency -> Link( e -> shared ? e -> shared : copies[ e -> target ] );
+        }
+        for ( std::size_t i = 0; i < nodes.size(); ++i )
+            catalog.Add( nodes[ i ].id, copies[ i ], nodes[ i ].recipe );
+    }
+
+private:
+
+    // a part of the prototype
+    struct Node
+    {
+        Node( const Symbol& i, const cxx0x::shared_ptr< Part >& p, const Catalog::Recipe& r ) :
+            id( i ), part( p ), recipe( r )
+        {}
+        Symbol id;
+        cxx0x::shared_ptr< Part > part;
+        Catalog::Recipe recipe;
+    };
+
+    // a link of a collaborator of a part of the prototype, either to
+    // another part of the prototype (target) or to a shared part
+    struct Edge
+    {
+        Edge( std::size_t s, const Symbol& d, std::size_t t, const cxx0x::shared_ptr< Part >& p ) :
+            source( s ), dependency( d ), target( t ), shared( p )
+        {}
+        std::size_t source;
+        Symbol dependency; // the collaborator in the source part
+        std::size_t target;
+        cxx0x::shared_ptr< Part > shared; // empty if the target is in the prototype
+    };
+
+    void Build( const Catalog& catalog, const std::vector< Symbol >& ids )
+    {
+        typedef cxx0x::unordered_map< const Part*, std::size_t > Index;
+        Index index;
+        nodes.reserve( ids.size() );
+        for ( std::size_t i = 0; i < ids.size(); ++i )
+        {
+            const Catalog::Entry* e = catalog.Resolve( ids[ i ] ); // it can belong to an ancestor
+            if ( e == NULL ) throw ElementNotFound( ids[ i ].Name() );
+            if ( ! e -> recipe ) throw WrongType();
+            if ( ! index.insert( std::make_pair( e -> part.get(), i ) ).second ) throw DuplicatedElement( ids[ i ].Name() );
+            nodes.push_back( Node( e -> id, e -> part, e -> recipe ) );
+        }
+
+        std::vector< Symbol > names;
+        std::vector< cxx0x::shared_ptr< Part > > linked;
+        for ( std::size_t i = 0; i < nodes.size(); ++i )
+        {
+            names.clear();
+            nodes[ i ].part -> DependencyNames( names );
+            for ( std::size_t d = 0; d < names.size(); ++d )
+            {
+                linked.clear();
+                nodes[ i ].part -> FindDependency( names[ d ] ) -> LinkedParts( linked );
+                for ( std::size_t l = 0; l < linked.size(); ++l )
+                {
+                    const Index::const_iterator target = index.find( linked[ l ].get() );
+                    if ( target != index.end() )
+                        edges.push_back( Edge( i, names[ d ], target -> second, cxx0x::shared_ptr< Part >() ) );
+                    else
+                        edges.push_back( Edge( i, names[ d ], 0, linked[ l ] ) );
+                }
+            }
+        }
+    }
+
+    std::vector< Node > nodes;
+    std::vector< Edge > edges;
+};
+
+} // namespace wallaroo
+
+#endif // WALLAROO_PROTOTYPE_H_
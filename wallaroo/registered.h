@@ -37,6 +37,7 @@
 #include "class.h"
 #include "collaborator.h"
 #include "attribute.h"
+#include "live_attribute.h"
 #include "part.h"
 
 /// @cond DOC_WALLAROO_TOKENPASTE
@@ -0,0 +1,216 @@
+/*******************************************************************************
+ * wallaroo - A library for configurable creation and wiring of C++ classes.
+ * Copyright (C) 2012 Daniele Pallastrelli
+ *
+ * This file is part of wallaroo.
+ * For more information, see http://wallaroo.googlecode.com/
+ *
+ * Boost Software License - Version 1.0 - August 17th, 2003
+ *
+ * Permission is hereby granted, free of charge, to any person or organization
+ * obtaining a copy of the software and accompanying documentation covered by
+ * this license (the "Software") to use, reproduce, display, distribute,
+ * execute, and transmit the Software, and to prepare derivative works of the
+ * Software, and to permit third-parties to whom the Software is furnished to
+ * do so, all subject to the following:
+ *
+ * The copyright notices in the Software and this entire statement, including
+ * the above license grant, this restriction and the following disclaimer,
+ * must be included in all copies of the Software, in whole or in part, and
+ * all derivative works of the Software, unless such copies or derivative
+ * works are solely in the form of machine-executable object code generated by
+ * a source language processor.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT
+ * SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE
+ * FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE,
+ * ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ ******************************************************************************/
+
+#ifndef WALLAROO_REPLICAS_H_
+#define WALLAROO_REPLICAS_H_
+
+#include <string>
+#include <vector>
+#include <cstddef>
+#include "cxx0x.h"
+#include "catalog.h"
+#include "exceptions.h"
+#include "prototype.h"
+#include "symbol.h"
+#include "detail/concurrent_index.h"
+#include "detail/partshell.h"
+
+#ifdef WALLAROO_HAS_CXX0X
+    #include <thread>
+    #include <functional>
+#else
+    #include <boost/thread/thread.hpp>
+    #include <boost/functional/hash.hpp>
+#endif
+
+namespace wallaroo
+{
+
+/**
+ * The replicas of the parts of a catalog: each thread (or each group of
+ * threads, i.e. the threads of a NUMA node) gets its own copy of the parts
+ * and of their wiring, so that the threads don't share the state of the
+ * parts and their reference counts.
+ *
+ * The catalog must record how its parts are created (see
+ * Catalog::EnableCloning), before creating them. The parts marked as
+ * shared (see Catalog::Share), and the parts added to the catalog from
+ * outside (see Catalog::Add) or created before enabling the cloning, are
+ * never replicated: the replicas are linked to the same instances of the catalog.
+ * The other parts are replicated as described in Prototype: in particular,
+ * the shared parts keep the links to the original parts in the catalog.
+ *
+ * A replica is created the first time it's requested (it's a new Catalog,
+ * sealed if the catalog was sealed), and after that the lookups never lock.
+ * The catalog must outlive its replicas.
+ * \code{.cpp}
+ *     Replicas replicas( catalog );
+ *     // on each worker thread:
+ *     shared_ptr< Processor > processor = replicas[ "processor" ];
+ * \endcode
+ */
+class Replicas
+{
+public:
+    /** Prepare the replicas of the parts contained in @c catalog
+    * (the parts declared and not instantiated are not replicated).
+    * @param catalog The catalog to replicate.
+    * @throw WrongType If the cloning of @c catalog is not enabled (see Catalog::EnableCloning).
+    */
+    explicit Replicas( Catalog& catalog ) :
+        original( catalog ),
+        prototype( catalog, ReplicatedParts( catalog ) )
+    {
+    }
+
+    /** Return the replica of the calling thread, creating it if needed.
+    */
+    Catalog& Local()
+    {
+        const cxx0x::thread::id thread = cxx0x::this_thread::get_id();
+        return Get( Key( thread, 0 ), cxx0x::hash< cxx0x::thread::id >()( thread ) );
+    }
+
+    /** Return the replica number @c n, creating it if needed.
+    * Use it to share a replica among a group of threads (i.e. the threads
+    * running on the same NUMA node). The numbered replicas are distinct
+    * from the replicas of the threads.
+    * @param n The number of the replica.
+    */
+    Catalog& Replica( std::size_t n )
+    {
+        return Get( Key( cxx0x::thread::id(), n + 1 ), n );
+    }
+
+    /** Look for the element @c id in the replica of the calling thread, or
+    * in the catalog if it's shared.
+    * @param id The name of the element
+    * @return The element.
+    * @throw ElementNotFound If an element with key @c id cannot be found.
+    */
+    detail::PartShell operator [] ( const std::string& id )
+    {
+        Symbol s;
+        if ( ! Symbol::Find( id, s ) ) throw ElementNotFound( id );
+        return operator[]( s );
+    }
+
+    /** Look for the element @c id in the replica of the calling thread, or
+    * in the catalog if it's shared.
+    * @param id The name of the element
+    * @return The element.
+    * @throw ElementNotFound If an element with key @c id cannot be found.
+    */
+    detail::PartShell operator [] ( const Symbol& id )
+    {
+        const Catalog::Entry* e = Local().Lookup( id );
+        return ( e != NULL ? detail::PartShell( e -> part ) : original[ id ] );
+    }
+
+private:
+
+    // copy ctor and assignment operator disabled
+    Replicas( const Replicas& );
+    Replicas& operator = ( const Replicas& );
+
+    // the owner of a replica: a thread, or a number (1-based) for the numbered replicas
+    struct Key
+    {
+        Key( const cxx0x::thread::id& t, std::size_t n ) : thread( t ), number( n ) {}
+        bool operator == ( const Key& other ) const { return thread == other.thread && number == other.number; }
+        cxx0x::thread::id thread;
+        std::size_t number;
+    };
+
+    struct Item
+    {
+        explicit Item( const Key& k ) : key( k ) {}
+        const Key key;
+        Catalog catalog;
+    };
+
+    struct SameKey
+    {
+        explicit SameKey( const Key& k ) : key( k ) {}
+        bool operator()( const Item& item ) const { return item.key == key; }
+        const Key key;
+    };
+
+    Catalog& Get( const Key& key, std::size_t hash )
+    {
+        const Item* item = index.Find( hash, SameKey( key ) );
+        if ( item == NULL )
+        {
+            cxx0x::lock_guard< cxx0x::mutex > lock( mutex );
+            item = index.Find( hash, SameKey( key ) );
+            if ( item == NULL )
+            {
+                const cxx0x::shared_ptr< Item > replica( new Item( key ) );
+                prototype.Clone( replica -> catalog );
+                if ( IsSealed( original ) ) replica -> catalog.Seal();
+                items.push_back( replica );
+                index.Insert( hash, replica.get() );
+                item = replica.get();
+            }
+        }
+        // the catalog of an item is not changed by the index
+        return const_cast< Catalog& >( item -> catalog );
+    }
+
+    static bool IsSealed( const Catalog& catalog )
+    {
+        cxx0x::lock_guard< cxx0x::mutex > lock( catalog.mutex );
+        return catalog.sealed;
+    }
+
+    // the names of the parts to replicate
+    static std::vector< Symbol > ReplicatedParts( const Catalog& catalog )
+    {
+        if ( ! catalog.IsCloningEnabled() ) throw WrongType();
+        cxx0x::lock_guard< cxx0x::mutex > lock( catalog.mutex );
+        std::vector< Symbol > ids;
+        for ( Catalog::Parts::const_iterator i = catalog.parts.begin(); i != catalog.parts.end(); ++i )
+            if ( i -> recipe && catalog.shared.find( i -> id ) == catalog.shared.end() )
+                ids.push_back( i -> id );
+        return ids;
+    }
+
+    Catalog& original;
+    const Prototype prototype;
+    std::vector< cxx0x::shared_ptr< Item > > items; // owned by the replicas
+    detail::ConcurrentIndex< Item > index;
+    cxx0x::mutex mutex; // serializes the creation of the replicas
+};
+
+} // namespace wallaroo
+
+#endif // WALLAROO_REPLICAS_H_
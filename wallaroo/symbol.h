@@ -0,0 +1,170 @@
+/*******************************************************************************
+ * wallaroo - A library for configurable creation and wiring of C++ classes.
+ * Copyright (C) 2012 Daniele Pallastrelli
+ *
+ * This file is part of wallaroo.
+ * For more information, see http://wallaroo.googlecode.com/
+ *
+ * Boost Software License - Version 1.0 - August 17th, 2003
+ *
+ * Permission is hereby granted, free of charge, to any person or organization
+ * obtaining a copy of the software and accompanying documentation covered by
+ * this license (the "Software") to use, reproduce, display, distribute,
+ * execute, and transmit the Software, and to prepare derivative works of the
+ * Software, and to permit third-parties to whom the Software is furnished to
+ * do so, all subject to the following:
+ *
+ * The copyright notices in the Software and this entire statement, including
+ * the above license grant, this restriction and the following disclaimer,
+ * must be included in all copies of the Software, in whole or in part, and
+ * all derivative works of the Software, unless such copies or derivative
+ * works are solely in the form of machine-executable object code generated by
+ * a source language processor.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT
+ * SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE
+ * FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE,
+ * ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ ******************************************************************************/
+
+#ifndef WALLAROO_SYMBOL_H_
+#define WALLAROO_SYMBOL_H_
+
+#include <string>
+#include <deque>
+#include <cstddef>
+#include "cxx0x.h"
+#include "detail/concurrent_index.h"
+
+namespace wallaroo
+{
+
+/**
+ * This class represents an interned name (the name of a part,
+ * a class, a collaborator or an attribute).
+ *
+ * Every string is stored only once in a global table, and a Symbol
+ * is a stable handle to it: comparing and hashing two symbols is
+ * an integer operation. Every wallaroo API taking a name has an
+ * overload taking a Symbol, so that you can intern the names once
+ * and avoid hashing and copying strings again and again.
+ *
+ * The global table is thread safe (the lookups don't lock, only the
+ * insertion of new strings does) and is never cleared, so a Symbol
+ * (and the reference returned by Symbol::Name) is valid until the end
+ * of the program.
+ */
+class Symbol
+{
+public:
+
+    /** Build the symbol of the empty string.
+    */
+    Symbol() : entry( &Table::Instance().Empty() ) {}
+
+    /** Intern the string @c name.
+    * @param name The string to intern.
+    */
+    explicit Symbol( const std::string& name ) : entry( &Table::Instance().Intern( name ) ) {}
+
+    /** Intern the string @c name.
+    * @param name The string to intern.
+    */
+    explicit Symbol( const char* name ) : entry( &Table::Instance().Intern( name ) ) {}
+
+    /** Look for the symbol of the string @c name, without interning it.
+    * @param name The string to look for.
+    * @param result The symbol found.
+    * @return false if @c name has never been interned.
+    */
+    static bool Find( const std::string& name, Symbol& result )
+    {
+        const Entry* e = Table::Instance().Find( name );
+        if ( e == NULL ) return false;
+        result.entry = e;
+        return true;
+    }
+
+    /** The string represented by this symbol.
+    */
+    const std::string& Name() const { return entry -> name; }
+
+    /** A small integer that identifies this symbol
+    * (the symbols are numbered progressively starting from 0).
+    */
+    std::size_t Id() const { return entry -> id; }
+
+    bool operator == ( const Symbol& other ) const { return entry == other.entry; }
+    bool operator != ( const Symbol& other ) const { return entry != other.entry; }
+    bool operator < ( const Symbol& other ) const { return entry -> id < other.entry -> id; }
+
+    /** Function object to use symbols as keys in hash tables.
+    */
+    struct Hash
+    {
+        std::size_t operator()( const Symbol& s ) const { return s.Id(); }
+    };
+
+private:
+
+    struct Entry
+    {
+        Entry( const std::string& n, std::size_t i ) : name( n ), id( i ) {}
+        const std::string name;
+        const std::size_t id;
+    };
+
+    // The global table of interned strings
+    class Table
+    {
+    public:
+        static Table& Instance()
+        {
+            static Table instance;
+            return instance;
+        }
+        const Entry& Empty() const { return entries.front(); }
+        const Entry& Intern( const std::string& name )
+        {
+            const std::size_t hash = cxx0x::hash< std::string >()( name );
+            const Entry* e = index.Find( hash, Equal( name ) );
+            if ( e != NULL ) return *e;
+            cxx0x::lock_guard< cxx0x::mutex > lock( mutex );
+            e = index.Find( hash, Equal( name ) ); // could have been added in the meantime
+            if ( e != NULL ) return *e;
+            entries.push_back( Entry( name, entries.size() ) );
+            const Entry& result = entries.back();
+            index.Insert( hash, &result );
+            return result;
+        }
+        // lock free
+        const Entry* Find( const std::string& name ) const
+        {
+            return index.Find( cxx0x::hash< std::string >()( name ), Equal( name ) );
+        }
+    private:
+        Table()
+        {
+            Intern( std::string() );
+        }
+        struct Equal
+        {
+            explicit Equal( const std::string& n ) : name( n ) {}
+            bool operator()( const Entry& e ) const { return e.name == name; }
+            const std::string& name;
+        };
+        // the index refers to the entries, and the lookups don't need the mutex
+        detail::ConcurrentIndex< Entry > index;
+        std::deque< Entry > entries; // a deque does not move its elements
+        cxx0x::mutex mutex;
+    };
+
+    const Entry* entry;
+};
+
+} // namespace
+
+#endif
@@ -58,6 +58,7 @@ namespace wallaroo
     <part>
       <name>instance1</name>
       <class>className1</class>
+      <shared>true</shared>
     </part>
     <part>
       <name>instance2</name>
@@ -101,6 +102,8 @@ namespace wallaroo
 
 </wallaroo>
 \endcode
+* A part marked with @c <shared>true</shared> is shared by all the replicas
+* of the catalog (see Catalog::Share and Replicas).
 */
 class XmlConfiguration : private detail::PtreeBasedCfg
 {
@@ -138,6 +141,20 @@ public:
     {
         detail::PtreeBasedCfg::Fill( catalog );
     }
+
+    /** Declare in the @c catalog the objects and relations specified in the file,
+     * without creating them: each object is created (and wired) the first time
+     * it's looked up in the catalog, either directly or because an object wired
+     * to it has been looked up (see Catalog::Declare).
+     * This configuration object can be destroyed afterwards.
+     * @param catalog The catalog target of the new items of the file.
+     * @throw WrongFile If the file contains a semantic error. The errors in the
+     *        description of an object are reported when it's created.
+     */
+    void FillLazily( Catalog& catalog )
+    {
+        detail::PtreeBasedCfg::FillLazily( catalog );
+    }
 private:
     ptree tree;
 };
@@ -0,0 +1,84 @@
+/*******************************************************************************
+ * wallaroo - A library for configurable creation and wiring of C++ classes.
+ * Copyright (C) 2012 Daniele Pallastrelli
+ *
+ * This file is part of wallaroo.
+ * For more information, see http://wallaroo.googlecode.com/
+ *
+ * Boost Software License - Version 1.0 - August 17th, 2003
+ *
+ * Permission is hereby granted, free of charge, to any person or organization
+ * obtaining a copy of the software and accompanying documentation covered by
+ * this license (the "Software") to use, reproduce, display, distribute,
+ * execute, and transmit the Software, and to prepare derivative works of the
+ * Software, and to permit third-parties to whom the Software is furnished to
+ * do so, all subject to the following:
+ *
+ * The copyright notices in the Software and this entire statement, including
+ * the above license grant, this restriction and the following disclaimer,
+ * must be included in all copies of the Software, in whole or in part, and
+ * all derivative works of the Software, unless such copies or derivative
+ * works are solely in the form of machine-executable object code generated by
+ * a source language processor.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT
+ * SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE
+ * FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE,
+ * ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ ******************************************************************************/
+
+#ifndef WALLAROO_XMLSTREAMCONFIGURATION_H_
+#define WALLAROO_XMLSTREAMCONFIGURATION_H_
+
+#include "catalog.h"
+#include "detail/streambasedcfg.h"
+#include "detail/xmlstreamparser.h"
+
+namespace wallaroo
+{
+
+/**
+* This class can parse a xml file containing a list of objects to
+* be created and their wiring, with the same syntax of XmlConfiguration.
+* Unlike XmlConfiguration, the file is not loaded in memory: the parts
+* are created, their attributes set and their collaborators wired while
+* the file is read, so that the memory needed does not depend on the size
+* of the file. This is useful for very large configurations.
+* The file is read once by LoadPlugins and once by Fill.
+*/
+class XmlStreamConfiguration : private detail::StreamBasedCfg< detail::XmlStreamParser >
+{
+public:
+    /** Create a XmlStreamConfiguration from the path specified as parameter.
+    * @param fileName The path of the file to parse
+    * @throw WrongFile If the file does not exist.
+    */
+    explicit XmlStreamConfiguration( const std::string& fileName ) :
+        detail::StreamBasedCfg< detail::XmlStreamParser >( fileName )
+    {
+    }
+
+    /** Load the plugins (shared libraries) specified in the file.
+    * @throw WrongFile If the format of the file is wrong or it contains a semantic error.
+    */
+    void LoadPlugins()
+    {
+        detail::StreamBasedCfg< detail::XmlStreamParser >::LoadPlugins();
+    }
+
+    /** Fill the @c catalog with the objects and relations specified in the file.
+    * @param catalog The catalog target of the new items of the file.
+    * @throw WrongFile If the format of the file is wrong or it contains a semantic error.
+    */
+    void Fill( Catalog& catalog )
+    {
+        detail::StreamBasedCfg< detail::XmlStreamParser >::Fill( catalog );
+    }
+};
+
+} // namespace
+
+#endif